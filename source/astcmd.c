@@ -0,0 +1,330 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astcmd.c
+*
+*  Synopsis:	Connect and disconnect commands for asterisk, run on a
+*				worker thread so the buttons never wait on them.  Requests
+*				are queued and done in order.  After asterisk takes the
+*				command the worker watches the node's link list until the
+*				change shows up (or doesn't) so the screen can say how it
+*				went and how long the link took.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "astcmd.h"
+#include "main.h"
+#include "clockfunc.h"
+
+typedef struct
+{
+	uint32_t id;					// 0 if never used
+	AcStatus_t st;
+} AcSlot_t;
+
+static AcSlot_t slots[AC_SLOTS];
+static uint32_t nextId=1;			// given to the next request
+static uint32_t nextRun=1;			// the worker does this one next
+static AcLinkedFn_t linked=NULL;
+static AcDoneFn_t done=NULL;
+static pthread_mutex_t acLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t acWake=PTHREAD_COND_INITIALIZER;
+static pthread_t acThread;
+static bool running=FALSE;
+static bool acKill=FALSE;
+
+/*-----------------------------------------------------------------------------
+Function:
+	setState
+Synopsis:
+	Updates a request's state where the screens can see it
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: the request
+	AcState_t state: new state
+	uint32_t elapsed_ms: time since the command went to asterisk
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void setState(uint32_t id, AcState_t state, uint32_t elapsed_ms)
+{
+	AcSlot_t *pSlot=&slots[id % AC_SLOTS];
+
+	pthread_mutex_lock(&acLock);
+	if (pSlot->id==id)
+	{
+		pSlot->st.state=state;
+		pSlot->st.elapsed_ms=elapsed_ms;
+	}
+	pthread_mutex_unlock(&acLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acRun
+Synopsis:
+	Sends one request to asterisk and waits for the link list to agree
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: the request
+	const AcRequest_t *pReq: what to do
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void acRun(uint32_t id, const AcRequest_t *pReq)
+{
+	char cmd[AC_CMD_LEN];
+	uint64_t start, deadline, now;
+	uint32_t nodeNum=pReq->nodeNum;
+	int want=0, rc;
+
+	switch (pReq->kind)
+	{
+		case AC_CONNECT:
+			sprintf(cmd, "asterisk -rx \"rpt cmd %u ilink %d %u\"", pReq->localNode, pReq->ilinkCmd, nodeNum);
+			want=1;
+			deadline=AC_CONNECT_TIMEOUT_MS;
+			break;
+		case AC_DISCONNECT:
+			sprintf(cmd, "asterisk -rx \"rpt cmd %u ilink 11 %u\"", pReq->localNode, nodeNum);
+			deadline=AC_DISCONNECT_TIMEOUT_MS;
+			break;
+		case AC_DISCONNECT_ALL:
+		default:
+			sprintf(cmd, "asterisk -rx \"rpt fun %u *76\"", pReq->localNode);
+			nodeNum=0;
+			deadline=AC_DISCONNECT_TIMEOUT_MS;
+			break;
+	}
+
+	setState(id, ACS_RUNNING, 0);
+	start=getClock_ms();
+	deadline+=start;
+
+	rc=system(cmd);
+	if (rc==-1 || !WIFEXITED(rc) || WEXITSTATUS(rc)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: asterisk didn't take \"%s\"\n", cmd);
+		setState(id, ACS_FAILED, getClock_ms()-start);
+		return;
+	}
+
+	// No link list check without somewhere to ask
+	if (!linked)
+	{
+		setState(id, ACS_DONE, getClock_ms()-start);
+		return;
+	}
+
+	setState(id, ACS_CONFIRMING, getClock_ms()-start);
+	while (!__atomic_load_n(&acKill, __ATOMIC_RELAXED))
+	{
+		rc=linked(pReq->localNode, nodeNum);
+		now=getClock_ms();
+		if (rc==want)
+		{
+			setState(id, ACS_DONE, now-start);
+			return;
+		}
+		if (now>=deadline)
+			break;
+		usleep(AC_POLL_MS*1000);
+	}
+	setState(id, ACS_TIMEOUT, getClock_ms()-start);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acThreadFn
+Synopsis:
+	Works through the queued requests in order
+Author:
+	John Gedde
+Inputs:
+	void *p: arguments
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *acThreadFn(void *p)
+{
+	AcRequest_t req;
+	uint32_t id;
+
+	pthread_mutex_lock(&acLock);
+	while (!acKill)
+	{
+		if (nextRun==nextId)
+		{
+			pthread_cond_wait(&acWake, &acLock);
+			continue;
+		}
+
+		id=nextRun++;
+		req=slots[id % AC_SLOTS].st.req;
+		pthread_mutex_unlock(&acLock);
+
+		acRun(id, &req);
+		if (done)
+			done(id);
+
+		pthread_mutex_lock(&acLock);
+	}
+	pthread_mutex_unlock(&acLock);
+
+	return p;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acStart
+Synopsis:
+	Starts the worker thread
+Author:
+	John Gedde
+Inputs:
+	AcLinkedFn_t linkedFn: checks the link list, NULL to skip the check
+	AcDoneFn_t doneFn: told when each request finishes, can be NULL
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void acStart(AcLinkedFn_t linkedFn, AcDoneFn_t doneFn)
+{
+	if (running)
+		return;
+
+	linked=linkedFn;
+	done=doneFn;
+	acKill=FALSE;
+	if (pthread_create(&acThread, NULL, acThreadFn, NULL)!=0)
+		fprintf(stderr, "aslLCD Error: Could not create asterisk command thread\n");
+	else
+		running=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acStop
+Synopsis:
+	Stops the worker thread.  A command already sent to asterisk is let
+	finish but its link check is cut short; anything still queued is
+	dropped.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void acStop()
+{
+	if (!running)
+		return;
+
+	pthread_mutex_lock(&acLock);
+	__atomic_store_n(&acKill, TRUE, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&acWake);
+	pthread_mutex_unlock(&acLock);
+	pthread_join(acThread, NULL);
+	running=FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acSubmit
+Synopsis:
+	Queues a connect or disconnect
+Author:
+	John Gedde
+Inputs:
+	const AcRequest_t *pReq: what to do
+Outputs:
+	uint32_t: id to check on it with acStatus(), 0 if the queue is full
+			  or the worker isn't running
+-----------------------------------------------------------------------------*/
+uint32_t acSubmit(const AcRequest_t *pReq)
+{
+	AcSlot_t *pSlot;
+	uint32_t id=0;
+
+	if (!running || !pReq)
+		return 0;
+
+	pthread_mutex_lock(&acLock);
+	pSlot=&slots[nextId % AC_SLOTS];
+
+	// The oldest slot has to be finished with before it can be reused
+	if (pSlot->id==0 || acFinished(pSlot->st.state))
+	{
+		id=nextId++;
+		pSlot->id=id;
+		pSlot->st.req=*pReq;
+		pSlot->st.state=ACS_QUEUED;
+		pSlot->st.elapsed_ms=0;
+		pthread_cond_signal(&acWake);
+	}
+	pthread_mutex_unlock(&acLock);
+
+	if (id==0)
+		fprintf(stderr, "aslLCD Error: Too many asterisk commands waiting\n");
+	return id;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	acStatus
+Synopsis:
+	Gets where a request is up to
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: from acSubmit()
+	AcStatus_t *pStatus: where to put it
+Outputs:
+	bool: FALSE if the request is too old to still be known
+-----------------------------------------------------------------------------*/
+bool acStatus(uint32_t id, AcStatus_t *pStatus)
+{
+	AcSlot_t *pSlot=&slots[id % AC_SLOTS];
+	bool found;
+
+	pthread_mutex_lock(&acLock);
+	found=(id!=0 && pSlot->id==id);
+	if (found && pStatus)
+		*pStatus=pSlot->st;
+	pthread_mutex_unlock(&acLock);
+
+	return found;
+}
@@ -0,0 +1,108 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astcmd.h
+*
+*  Synopsis:	Header file for astcmd.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _ASTCMD
+#define _ASTCMD
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AC_SLOTS				8			// requests kept (queued + finished)
+#define AC_CMD_LEN				96
+#define AC_POLL_MS				500			// link list check rate
+#define AC_CONNECT_TIMEOUT_MS	20000
+#define AC_DISCONNECT_TIMEOUT_MS 5000
+
+typedef enum
+{
+	AC_CONNECT=0,
+	AC_DISCONNECT,
+	AC_DISCONNECT_ALL
+} AcKind_t;
+
+typedef enum
+{
+	ACS_QUEUED=0,
+	ACS_RUNNING,				// asterisk command going
+	ACS_CONFIRMING,				// watching the link list
+	ACS_DONE,
+	ACS_FAILED,					// asterisk didn't take the command
+	ACS_TIMEOUT					// the link list never changed
+} AcState_t;
+
+typedef struct
+{
+	AcKind_t kind;
+	uint32_t localNode;
+	uint32_t nodeNum;			// not used for AC_DISCONNECT_ALL
+	int ilinkCmd;				// AC_CONNECT: 2, 3, 12 or 13
+} AcRequest_t;
+
+typedef struct
+{
+	AcRequest_t req;
+	AcState_t state;
+	uint32_t elapsed_ms;		// since the command went to asterisk
+} AcStatus_t;
+
+// Asks asterisk whether nodeNum is linked to localNode (nodeNum 0: is
+// anything linked).  Returns 1 if so, 0 if not, -1 if it couldn't tell.
+// Called from the worker thread.
+typedef int (*AcLinkedFn_t)(uint32_t localNode, uint32_t nodeNum);
+
+// Called from the worker thread each time a request finishes
+typedef void (*AcDoneFn_t)(uint32_t id);
+
+void 		acStart(AcLinkedFn_t linkedFn, AcDoneFn_t doneFn);
+void 		acStop();
+uint32_t 	acSubmit(const AcRequest_t *pReq);
+bool 		acStatus(uint32_t id, AcStatus_t *pStatus);
+
+/*-----------------------------------------------------------------------------
+Function:
+	acFinished
+Synopsis:
+	Whether a request is over, one way or the other
+Author:
+	John Gedde
+Inputs:
+	AcState_t state: the request's state
+Outputs:
+	bool: TRUE if done, failed or timed out
+-----------------------------------------------------------------------------*/
+static inline bool acFinished(AcState_t state)
+{
+	return state>=ACS_DONE;
+}
+
+#endif
@@ -0,0 +1,246 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astdb.c
+*
+*  Synopsis:	Callsign lookup in the AllStar node database that allmon
+*				keeps (astdb.txt), one node a line:
+*
+*					2000|W1AW|ARRL HQ|Newington, CT
+*
+*				The callsigns and node numbers are read into an array
+*				sorted by callsign, so the nodes for any callsign prefix
+*				are one run found with two binary searches.  The file is
+*				read again when it changes (it's usually fetched nightly).
+*				Only the UI thread uses it.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "astdb.h"
+#include "main.h"
+
+static DbNode_t *nodes=NULL;
+static uint32_t numNodes=0;
+static time_t loadedMtime=0;
+static off_t loadedSize=-1;
+
+/*-----------------------------------------------------------------------------
+Function:
+	dbCompare
+Synopsis:
+	qsort() order: callsign, then node number
+Author:
+	John Gedde
+Inputs:
+	const void *a, *b: DbNode_t
+Outputs:
+	int: <0, 0, >0
+-----------------------------------------------------------------------------*/
+static int dbCompare(const void *a, const void *b)
+{
+	const DbNode_t *pA=a, *pB=b;
+	int diff=strcmp(pA->call, pB->call);
+
+	if (diff)
+		return diff;
+	return (pA->nodeNum>pB->nodeNum) - (pA->nodeNum<pB->nodeNum);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dbLoad
+Synopsis:
+	Reads astdb.txt if it hasn't been read or has changed since.  Lines
+	without a node number or callsign are skipped.
+Author:
+	John Gedde
+Inputs:
+	const char *path: astdb.txt
+Outputs:
+	bool: TRUE if there's a database to search
+-----------------------------------------------------------------------------*/
+bool dbLoad(const char *path)
+{
+	struct stat st;
+	FILE *fp;
+	char line[256];
+	char *pCall, *pEnd;
+	DbNode_t *pNew=NULL, *pMore;
+	uint32_t num=0, room=0;
+	unsigned long nodeNum;
+	size_t len;
+
+	if (stat(path, &st)!=0)
+	{
+		if (nodes==NULL)
+			fprintf(stderr, "aslLCD Error: No node database %s\n", path);
+		return nodes!=NULL;
+	}
+	if (nodes && st.st_mtime==loadedMtime && st.st_size==loadedSize)
+		return TRUE;
+
+	if ((fp=fopen(path, "r"))==NULL)
+	{
+		fprintf(stderr, "aslLCD Error: Could not read %s\n", path);
+		return nodes!=NULL;
+	}
+
+	while (fgets(line, sizeof(line), fp))
+	{
+		nodeNum=strtoul(line, &pEnd, 10);
+		if (nodeNum==0 || *pEnd!='|')
+			continue;
+		pCall=pEnd+1;
+		len=strcspn(pCall, "|\r\n");
+		while (len>0 && isspace((unsigned char)pCall[len-1]))
+			len--;
+		if (len==0 || len>DB_CALL_LEN)
+			continue;
+
+		if (num==room)
+		{
+			room=room ? room*2 : 4096;
+			if ((pMore=realloc(pNew, room*sizeof(*pNew)))==NULL)
+			{
+				fprintf(stderr, "aslLCD Error: No memory for %s\n", path);
+				free(pNew);
+				fclose(fp);
+				return nodes!=NULL;
+			}
+			pNew=pMore;
+		}
+
+		for (size_t i=0; i<len; ++i)
+			pNew[num].call[i]=toupper((unsigned char)pCall[i]);
+		pNew[num].call[len]='\0';
+		pNew[num].nodeNum=nodeNum;
+		num++;
+	}
+	fclose(fp);
+
+	qsort(pNew, num, sizeof(*pNew), dbCompare);
+
+	free(nodes);
+	nodes=pNew;
+	numNodes=num;
+	loadedMtime=st.st_mtime;
+	loadedSize=st.st_size;
+	return nodes!=NULL;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dbFind
+Synopsis:
+	Finds the run of nodes whose callsign starts with prefix
+Author:
+	John Gedde
+Inputs:
+	const char *prefix: upper case, "" for all of them
+	uint32_t *pFirst: where to put the first one's index
+Outputs:
+	uint32_t: how many there are
+-----------------------------------------------------------------------------*/
+uint32_t dbFind(const char *prefix, uint32_t *pFirst)
+{
+	size_t len=strlen(prefix);
+	uint32_t lo=0, hi=numNodes, mid, first;
+
+	// First one not before prefix
+	while (lo<hi)
+	{
+		mid=lo+(hi-lo)/2;
+		if (strncmp(nodes[mid].call, prefix, len)<0)
+			lo=mid+1;
+		else
+			hi=mid;
+	}
+	first=lo;
+
+	// First one after the ones starting with prefix
+	hi=numNodes;
+	while (lo<hi)
+	{
+		mid=lo+(hi-lo)/2;
+		if (strncmp(nodes[mid].call, prefix, len)==0)
+			lo=mid+1;
+		else
+			hi=mid;
+	}
+
+	*pFirst=first;
+	return lo-first;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dbGet
+Synopsis:
+	A node from the sorted list
+Author:
+	John Gedde
+Inputs:
+	uint32_t idx: which one
+Outputs:
+	const DbNode_t *: the node
+-----------------------------------------------------------------------------*/
+const DbNode_t *dbGet(uint32_t idx)
+{
+	return &nodes[idx];
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dbCommon
+Synopsis:
+	How many characters all the callsigns in a run have in common.  They're
+	sorted, so only the first and last need comparing.
+Author:
+	John Gedde
+Inputs:
+	uint32_t first: start of the run
+	uint32_t count: how many, at least 1
+Outputs:
+	size_t: length of the common prefix
+-----------------------------------------------------------------------------*/
+size_t dbCommon(uint32_t first, uint32_t count)
+{
+	const char *pA=nodes[first].call, *pB=nodes[first+count-1].call;
+	size_t len=0;
+
+	while (pA[len] && pA[len]==pB[len])
+		len++;
+	return len;
+}
@@ -0,0 +1,53 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astdb.h
+*
+*  Synopsis:	Header file for astdb.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _ASTDB
+#define _ASTDB
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DB_CALL_LEN			15
+
+typedef struct
+{
+	char call[DB_CALL_LEN+1];			// upper case
+	uint32_t nodeNum;
+} DbNode_t;
+
+bool 		dbLoad(const char *path);
+uint32_t 	dbFind(const char *prefix, uint32_t *pFirst);
+const DbNode_t *dbGet(uint32_t idx);
+size_t 		dbCommon(uint32_t first, uint32_t count);
+
+#endif
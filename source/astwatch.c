@@ -0,0 +1,344 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astwatch.c
+*
+*  Synopsis:	Keeps track of whether Asterisk is running by watching for
+*				its control socket (/var/run/asterisk.ctl).  Waiting is
+*				done with inotify so we find out the moment the socket
+*				shows up instead of polling for it.
+*
+*				Once running, the watch thread follows asterisk.ctl being
+*				removed and created again when asterisk restarts.  If
+*				asterisk dies without cleaning up, the pid in asterisk.pid
+*				going away catches it.  When asterisk comes back the resync
+*				function is called so cached node info can be refreshed.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Watch thread for asterisk going away and
+*            |              |  coming back
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+
+#include "astwatch.h"
+#include "main.h"
+#include "clockfunc.h"
+
+static pthread_t watchThread;
+static bool watching=FALSE;
+static bool watchKill=FALSE;
+static bool astUp=FALSE;
+static uint32_t generation=0;
+static AstResyncFn_t resync=NULL;
+
+/*-----------------------------------------------------------------------------
+Function:
+	astAlive
+Synopsis:
+	Checks asterisk is really running: the control socket is there and the
+	process in asterisk.pid still exists.  A missing pid file isn't held
+	against it.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool: TRUE if asterisk is up
+-----------------------------------------------------------------------------*/
+static bool astAlive()
+{
+	FILE *fp;
+	int pid=0;
+
+	if (!astCtlPresent())
+		return FALSE;
+
+	fp=fopen(AST_PID_PATH, "r");
+	if (!fp)
+		return TRUE;
+	if (fscanf(fp, "%d", &pid)!=1)
+		pid=0;
+	fclose(fp);
+
+	return pid<=0 || kill(pid, 0)==0 || errno==EPERM;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	astCtlPresent
+Synopsis:
+	Checks for the Asterisk control socket
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool: TRUE if it's there
+-----------------------------------------------------------------------------*/
+bool astCtlPresent()
+{
+	return access(AST_CTL_PATH, F_OK)==0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	astWaitForCtl
+Synopsis:
+	Waits for the Asterisk control socket to show up.  Watches /var/run
+	for it being created rather than polling.  The watch is set up before
+	looking for the file so it can't be missed in between.
+Author:
+	John Gedde
+Inputs:
+	uint32_t timeout_ms: how long to wait, AST_WAIT_FOREVER for no limit
+Outputs:
+	bool: TRUE if Asterisk is up, FALSE if we timed out
+-----------------------------------------------------------------------------*/
+bool astWaitForCtl(uint32_t timeout_ms)
+{
+	char buf[sizeof(struct inotify_event)+256] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	struct pollfd pfd;
+	uint64_t end, now;
+	int32_t timeout;
+	ssize_t len;
+	int fd;
+	bool found;
+
+	fd=inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd<0 || inotify_add_watch(fd, AST_RUN_DIR, IN_CREATE | IN_MOVED_TO)<0)
+	{
+		fprintf(stderr, "aslLCD Error: Couldn't watch %s for Asterisk\n", AST_RUN_DIR);
+		if (fd>=0)
+			close(fd);
+
+		// Fall back to polling
+		end=getClock_ms()+timeout_ms;
+		while (!astCtlPresent())
+		{
+			if (timeout_ms!=AST_WAIT_FOREVER && getClock_ms()>=end)
+				return FALSE;
+			usleep(250000);
+		}
+		return TRUE;
+	}
+
+	end=getClock_ms()+timeout_ms;
+	found=astCtlPresent();
+	while (!found)
+	{
+		timeout=-1;
+		if (timeout_ms!=AST_WAIT_FOREVER)
+		{
+			now=getClock_ms();
+			if (now>=end)
+				break;
+			timeout=(int32_t)(end-now);
+		}
+
+		pfd.fd=fd;
+		pfd.events=POLLIN;
+		if (poll(&pfd, 1, timeout)<=0)
+			continue;
+
+		while ((len=read(fd, buf, sizeof(buf)))>0)
+		{
+			for (char *p=buf; p<buf+len; p+=sizeof(struct inotify_event)+ev->len)
+			{
+				ev=(const struct inotify_event *)p;
+				if (ev->len && strcmp(ev->name, AST_CTL_NAME)==0)
+					found=TRUE;
+			}
+		}
+		
+		// In case the queue overflowed
+		if (!found)
+			found=astCtlPresent();
+	}
+
+	close(fd);
+	return found;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	watchThreadFn
+Synopsis:
+	Sleeps on inotify for /var/run changing, waking up every AST_CHECK_MS
+	anyway to check the asterisk process.  Asterisk going down is noticed
+	straight away; coming back bumps the generation and calls the resync
+	function until it succeeds.
+Author:
+	John Gedde
+Inputs:
+	void *p: inotify fd
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *watchThreadFn(void *p)
+{
+	int fd=(int)(intptr_t)p;
+	char buf[1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct pollfd pfd;
+	bool up, needResync=FALSE;
+	int32_t timeout;
+
+	while (!__atomic_load_n(&watchKill, __ATOMIC_RELAXED))
+	{
+		timeout=needResync ? AST_RESYNC_RETRY_MS : AST_CHECK_MS;
+		pfd.fd=fd;
+		pfd.events=POLLIN;
+		if (fd>=0 && poll(&pfd, 1, timeout)>0)
+		{
+			// Don't care what changed, just look again
+			while (read(fd, buf, sizeof(buf))>0)
+				;
+		}
+		else if (fd<0)
+			usleep(timeout*1000);
+
+		up=astAlive();
+		if (up!=astUp)
+		{
+			if (up)
+			{
+				fprintf(stderr, "aslLCD: Asterisk is back\n");
+				__atomic_fetch_add(&generation, 1, __ATOMIC_RELEASE);
+				needResync=TRUE;
+			}
+			else
+			{
+				fprintf(stderr, "aslLCD Error: Asterisk went away\n");
+				needResync=FALSE;
+			}
+			__atomic_store_n(&astUp, up, __ATOMIC_RELEASE);
+		}
+
+		if (needResync && up)
+			needResync=resync ? !resync() : FALSE;
+	}
+
+	if (fd>=0)
+		close(fd);
+	return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	astStartWatch
+Synopsis:
+	Starts the watch thread
+Author:
+	John Gedde
+Inputs:
+	AstResyncFn_t resyncFn: called when asterisk comes back, or NULL
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void astStartWatch(AstResyncFn_t resyncFn)
+{
+	int fd;
+
+	if (watching)
+		return;
+
+	fd=inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd>=0 && inotify_add_watch(fd, AST_RUN_DIR, IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM)<0)
+	{
+		close(fd);
+		fd=-1;
+	}
+	if (fd<0)
+		fprintf(stderr, "aslLCD Error: Couldn't watch %s, checking asterisk every %u ms\n", AST_RUN_DIR, AST_CHECK_MS);
+
+	resync=resyncFn;
+	astUp=astAlive();
+	watchKill=FALSE;
+	if (pthread_create(&watchThread, NULL, watchThreadFn, (void *)(intptr_t)fd)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create asterisk watch thread\n");
+		if (fd>=0)
+			close(fd);
+		return;
+	}
+	watching=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	astStopWatch
+Synopsis:
+	Stops the watch thread.  Takes up to AST_CHECK_MS.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void astStopWatch()
+{
+	if (!watching)
+		return;
+
+	__atomic_store_n(&watchKill, TRUE, __ATOMIC_RELAXED);
+	pthread_join(watchThread, NULL);
+	watching=FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	astIsUp / astGeneration
+Synopsis:
+	Whether asterisk is running, and how many times it has come back since
+	the watch started.  Before the watch is started astIsUp() looks for
+	the control socket itself.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool: TRUE if asterisk is up / uint32_t: generation
+-----------------------------------------------------------------------------*/
+bool astIsUp()
+{
+	if (!watching)
+		return astCtlPresent();
+	return __atomic_load_n(&astUp, __ATOMIC_ACQUIRE);
+}
+
+uint32_t astGeneration()
+{
+	return __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,62 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  astwatch.h
+*
+*  Synopsis:	Header file for astwatch.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Watch thread for asterisk going away and
+*            |              |  coming back
+*
+****************************************************************************/
+
+#ifndef _ASTWATCH
+#define _ASTWATCH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AST_RUN_DIR			"/var/run"
+#define AST_CTL_NAME		"asterisk.ctl"
+#define AST_CTL_PATH		AST_RUN_DIR "/" AST_CTL_NAME
+#define AST_PID_PATH		AST_RUN_DIR "/asterisk.pid"
+
+#define AST_WAIT_FOREVER	0
+#define AST_CHECK_MS		1000		// catches a crash that leaves asterisk.ctl
+#define AST_RESYNC_RETRY_MS	250			// asterisk not ready to answer yet
+
+// Called from the watch thread when asterisk comes back.  Return FALSE if
+// asterisk couldn't answer yet and it will be called again shortly.
+typedef bool (*AstResyncFn_t)();
+
+bool 		astCtlPresent();
+bool 		astWaitForCtl(uint32_t timeout_ms);
+void 		astStartWatch(AstResyncFn_t resyncFn);
+void 		astStopWatch();
+bool 		astIsUp();
+uint32_t 	astGeneration();
+
+#endif
@@ -0,0 +1,335 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  backlight.c
+*
+*  Synopsis:	Backlight status patterns (solid, blink, pulse, alternate).
+*				Patterns are run from the backlight thread.  blService()
+*				is called by the thread and returns the time of the next
+*				color change so the thread can sleep until then.
+*				State changes are coalesced and held for a minimum dwell
+*				time so a flapping COS can't tie up the i2c bus.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  CPU overheat, under COS and PTT
+*  10/19/26  | John Gedde   |  blReport() for the STATS command
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "backlight.h"
+#include "ini.h"
+#include "main.h"
+#include "clockfunc.h"
+#include "latency.h"
+
+// Shortest on time for a pulse
+#define MIN_PULSE_MS	50
+
+static BlPattern_t patterns[BLS_MAX];
+static BlState_t curState=BLS_IDLE;
+static uint64_t patternStart=0;
+static int lastColor=-1;
+static bool forceUpdate=TRUE;
+
+// Coalescing/hysteresis
+static uint16_t coalesce_ms=0;
+static uint16_t minDwell_ms=0;
+static BlState_t lastRequested=BLS_MAX;
+static BlState_t pendingState=BLS_IDLE;
+static bool pending=FALSE;
+static uint64_t pendingSince=0;		// last change of the burst
+static uint64_t burstStart=0;		// first change of the burst
+static BlStats_t stats={ 0 };
+
+// Latency stamps (us) for the pending change
+static uint64_t pendingEvent_us=0;
+static uint64_t pendingQueued_us=0;
+
+/*-----------------------------------------------------------------------------
+Function:
+	blLoadConf
+Synopsis:
+	Picks up the color and effect for each backlight state and the update
+	coalescing settings from the conf file
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void blLoadConf()
+{
+	coalesce_ms=conf->coalesce_ms;
+	minDwell_ms=conf->minDwell_ms;
+	memcpy(patterns, conf->blPatterns, sizeof(patterns));
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blStateFromStatus
+Synopsis:
+	Picks the backlight state for a set of status bits - priority if/else
+Author:
+	John Gedde
+Inputs:
+	uint16_t statusBits: PTT_UP, COS_UP, etc.
+Outputs:
+	BlState_t: the state to show
+-----------------------------------------------------------------------------*/
+BlState_t blStateFromStatus(uint16_t statusBits)
+{
+	if (statusBits & TX_TIMEOUT)
+		return BLS_TX_TIMEOUT;
+	else if ((statusBits & PTT_UP) && (statusBits & COS_UP))
+		return BLS_PTTCOS;
+	else if (statusBits & PTT_UP)
+		return BLS_PTT;
+	else if (statusBits & COS_UP)
+		return BLS_COS;
+	else if (statusBits & CPU_OVERHEAT)
+		return BLS_OVERHEAT;
+	else if (statusBits & ASTERISK_DOWN)
+		return BLS_ASTERISK_DOWN;
+	else if (statusBits & NETWORK_UP)
+		return BLS_NETWORK_UP;
+	else
+		return BLS_IDLE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blSetState
+Synopsis:
+	Asks for a new state.  The change is held back until no other change
+	has come in for coalesce_ms and the current state has been showing for
+	at least min_dwell_ms.  A burst that keeps changing is shown anyway
+	coalesce_ms+min_dwell_ms after its first change so a keyup storm
+	can't hold the old color forever.  Only the last state asked for gets
+	shown; any in between are counted as suppressed.  Asking for the state that is 
+	already running leaves the pattern phase alone.
+Author:
+	John Gedde
+Inputs:
+	BlState_t state: the new state
+	uint64_t now: current time in ms
+	uint64_t eventStamp_us: getClock_us() when the event causing this change
+							came in, for latency stats.  0 if not known.
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void blSetState(BlState_t state, uint64_t now, uint64_t eventStamp_us)
+{
+	if (state>=BLS_MAX)
+		state=BLS_IDLE;
+
+	if (state==lastRequested)
+		return;
+	lastRequested=state;
+	stats.requested++;
+	
+	// Whatever was waiting is never going to be seen
+	if (pending)
+		stats.suppressed++;
+	
+	if (state==curState)
+	{
+		// Flapped back before the change was shown
+		pending=FALSE;
+		return;
+	}
+	
+	if (!pending)
+		burstStart=now;
+	pendingSince=now;
+	pendingState=state;
+	pending=TRUE;
+	
+	pendingEvent_us=eventStamp_us;
+	pendingQueued_us=getClock_us();
+	if (eventStamp_us)
+		latRecord(LAT_STATUS_TO_QUEUE, pendingQueued_us-eventStamp_us);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blForceUpdate
+Synopsis:
+	Makes the next blService() rewrite the backlight even if the color
+	didn't change (e.g. after the backlight test was using it)
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void blForceUpdate()
+{
+	forceUpdate=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blService
+Synopsis:
+	Works out where the current pattern is and sets the backlight color if
+	it needs to change.  Only color changes go to the LCD to keep the i2c
+	bus free for text updates.
+Author:
+	John Gedde
+Inputs:
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: time in ms of the next color change, or BL_NO_DEADLINE
+-----------------------------------------------------------------------------*/
+uint64_t blService(uint64_t now)
+{
+	const BlPattern_t *pat=&patterns[curState];
+	BlColors_t color=pat->color;
+	uint64_t next=BL_NO_DEADLINE;
+	uint64_t elapsed, cycleStart, onTime, applyAt=0;
+	bool applied=FALSE;
+	uint64_t write_us;
+
+	// Time to switch to a pending state?
+	if (pending)
+	{
+		applyAt=pendingSince+coalesce_ms;
+		if (applyAt>burstStart+coalesce_ms+minDwell_ms)
+			applyAt=burstStart+coalesce_ms+minDwell_ms;
+		if (applyAt<patternStart+minDwell_ms)
+			applyAt=patternStart+minDwell_ms;
+		
+		if (now>=applyAt)
+		{
+			curState=pendingState;
+			patternStart=now;
+			pending=FALSE;
+			applied=TRUE;
+			stats.applied++;
+			pat=&patterns[curState];
+			color=pat->color;
+		}
+	}
+
+	if (pat->effect!=BLE_SOLID)
+	{
+		elapsed=(now-patternStart) % pat->period_ms;
+		cycleStart=now-elapsed;
+
+		if (pat->effect==BLE_PULSE)
+		{
+			onTime=pat->period_ms/8;
+			if (onTime<MIN_PULSE_MS)
+				onTime=MIN_PULSE_MS;
+		}
+		else
+			onTime=pat->period_ms/2;
+
+		if (elapsed<onTime)
+			next=cycleStart+onTime;
+		else
+		{
+			color=(pat->effect==BLE_BLINK) ? BLC_BL_OFF : pat->altColor;
+			next=cycleStart+pat->period_ms;
+		}
+	}
+
+	if (applied)
+	{
+		write_us=getClock_us();
+		latRecord(LAT_QUEUE_TO_WRITE, write_us-pendingQueued_us);
+	}
+
+	if (forceUpdate || (int)color!=lastColor)
+	{
+		setBacklightColor(color);
+		lastColor=color;
+		forceUpdate=FALSE;
+	}
+
+	if (applied && pendingEvent_us)
+		latRecord(LAT_END_TO_END, getClock_us()-pendingEvent_us);
+
+	if (pending && applyAt<next)
+		next=applyAt;
+
+	return next;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blGetStats
+Synopsis:
+	Gets the backlight state change counters
+Author:
+	John Gedde
+Inputs:
+	BlStats_t *pStats: where to put them
+Outputs:
+	BlStats_t *pStats: the counters
+-----------------------------------------------------------------------------*/
+void blGetStats(BlStats_t *pStats)
+{
+	if (pStats)
+		*pStats=stats;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	blReport
+Synopsis:
+	Writes the backlight state change counters as text for the STATS
+	command.  Only call it from the backlight thread.
+Author:
+	John Gedde
+Inputs:
+	char *buf: where to put the report
+	size_t bufLen: size of buf
+Outputs:
+	int: length of the report
+-----------------------------------------------------------------------------*/
+int blReport(char *buf, size_t bufLen)
+{
+	BlStats_t blStats;
+	int len;
+
+	if (bufLen==0)
+		return 0;
+
+	blGetStats(&blStats);
+	len=snprintf(buf, bufLen, "backlight requested applied suppressed\nstates %u %u %u\n",
+		blStats.requested, blStats.applied, blStats.suppressed);
+	if (len<0 || (size_t)len>=bufLen)
+	{
+		buf[0]='\0';
+		return 0;
+	}
+	return len;
+}
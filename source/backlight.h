@@ -0,0 +1,104 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  backlight.h
+*
+*  Synopsis:	Header file for backlight.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  CPU overheat
+*  10/19/26  | John Gedde   |  blReport() for the STATS command
+*
+****************************************************************************/
+
+#ifndef _BACKLIGHT
+#define _BACKLIGHT
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "lcdfunc.h"
+
+// Node status bits as tracked by the backlight thread
+#define PTT_UP 			1
+#define COS_UP 			2
+#define NETWORK_UP 		4
+#define TX_TIMEOUT		8
+#define ASTERISK_DOWN	16
+#define CPU_OVERHEAT	32
+
+// No deadline pending (pattern is solid)
+#define BL_NO_DEADLINE	UINT64_MAX
+
+// Backlight states.  Higher value wins when more than one applies.
+typedef enum
+{
+	BLS_IDLE=0,
+	BLS_NETWORK_UP,
+	BLS_ASTERISK_DOWN,
+	BLS_OVERHEAT,
+	BLS_COS,
+	BLS_PTT,
+	BLS_PTTCOS,
+	BLS_TX_TIMEOUT,
+	BLS_MAX
+} BlState_t;
+
+// Backlight effects
+typedef enum
+{
+	BLE_SOLID=0,	// color
+	BLE_BLINK,		// color / off
+	BLE_PULSE,		// short flash of color over alt color
+	BLE_ALTERNATE,	// color / alt color
+	BLE_MAX
+} BlEffect_t;
+
+typedef struct
+{
+	BlColors_t color;
+	BlColors_t altColor;
+	BlEffect_t effect;
+	uint16_t period_ms;
+} BlPattern_t;
+
+// Backlight state change counters
+typedef struct
+{
+	uint32_t requested;		// state changes asked for
+	uint32_t applied;		// state changes that made it to the backlight
+	uint32_t suppressed;	// state changes dropped by coalescing/dwell
+} BlStats_t;
+
+void 		blLoadConf();
+BlState_t 	blStateFromStatus(uint16_t statusBits);
+void 		blSetState(BlState_t state, uint64_t now, uint64_t eventStamp_us);
+void 		blForceUpdate();
+uint64_t 	blService(uint64_t now);
+void 		blGetStats(BlStats_t *pStats);
+int 		blReport(char *buf, size_t bufLen);
+
+#endif
@@ -0,0 +1,248 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  catalog.c
+*
+*  Synopsis:	Drop-in script catalog (/etc/aslLCD/scripts.d).  Each
+*				executable file there says what it is in comment lines at
+*				the top:
+*
+*					#!/bin/sh
+*					# aslLCD-name: Weather
+*					# aslLCD-category: Info
+*					# aslLCD-param: --short
+*					# aslLCD-node: yes
+*					# aslLCD-timeout: 30
+*
+*				Only aslLCD-name is needed.  The directory is read along
+*				with the conf file (at startup and when either changes) so
+*				the scripts menu never has to look at the disk.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "catalog.h"
+#include "main.h"
+
+/*-----------------------------------------------------------------------------
+Function:
+	catCopy
+Synopsis:
+	Copies a header value, cutting it to fit
+Author:
+	John Gedde
+Inputs:
+	char *pDest: where to put it
+	size_t destLen: size of pDest
+	const char *pSrc: the value
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void catCopy(char *pDest, size_t destLen, const char *pSrc)
+{
+	size_t len=strlen(pSrc);
+
+	if (len>=destLen)
+		len=destLen-1;
+	memcpy(pDest, pSrc, len);
+	pDest[len]='\0';
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	catReadHeader
+Synopsis:
+	Reads the aslLCD-xxx: lines from the comments at the top of a script.
+	The header ends at the first line that isn't a comment or blank.
+Author:
+	John Gedde
+Inputs:
+	const char *pPath: the script
+	ConfScript_t *pScript: defaults filled in
+Outputs:
+	ConfScript_t *pScript: what the header says
+	bool: TRUE if it has a name (is meant for the menu)
+-----------------------------------------------------------------------------*/
+static bool catReadHeader(const char *pPath, ConfScript_t *pScript)
+{
+	FILE *fp;
+	char line[256];
+	char *p, *pVal;
+	size_t len;
+	int c;
+
+	if ((fp=fopen(pPath, "r"))==NULL)
+		return FALSE;
+
+	for (int n=0; n<CAT_HEADER_LINES && fgets(line, sizeof(line), fp)!=NULL; ++n)
+	{
+		// Throw away the rest of a long line
+		len=strlen(line);
+		if (len && line[len-1]!='\n')
+		{
+			while ((c=fgetc(fp))!=EOF && c!='\n')
+				;
+		}
+		while (len && isspace((unsigned char)line[len-1]))
+			line[--len]='\0';
+
+		if (len==0)
+			continue;
+		if (line[0]!='#')
+			break;
+
+		p=line+1;
+		while (isspace((unsigned char)*p))
+			p++;
+		if (strncasecmp(p, CAT_KEY_PREFIX, strlen(CAT_KEY_PREFIX))!=0)
+			continue;
+		p+=strlen(CAT_KEY_PREFIX);
+		if ((pVal=strchr(p, ':'))==NULL)
+			continue;
+		*pVal++='\0';
+		while (isspace((unsigned char)*pVal))
+			pVal++;
+
+		if (strcasecmp(p, "name")==0)
+			catCopy(pScript->name, sizeof(pScript->name), pVal);
+		else if (strcasecmp(p, "category")==0)
+			catCopy(pScript->category, sizeof(pScript->category), pVal);
+		else if (strcasecmp(p, "param")==0)
+			catCopy(pScript->param, sizeof(pScript->param), pVal);
+		else if (strcasecmp(p, "node")==0)
+			pScript->needNodeNum=(*pVal=='1' || tolower((unsigned char)*pVal)=='y');
+		else if (strcasecmp(p, "timeout")==0)
+			pScript->timeout_s=atoi(pVal);
+	}
+
+	fclose(fp);
+	return pScript->name[0]!='\0';
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	catCompare
+Synopsis:
+	qsort() order: by category (none first), then by name
+Author:
+	John Gedde
+Inputs:
+	const void *a, *b: ConfScript_t
+Outputs:
+	int: <0, 0, >0
+-----------------------------------------------------------------------------*/
+static int catCompare(const void *a, const void *b)
+{
+	const ConfScript_t *pA=a, *pB=b;
+	int diff;
+
+	if ((diff=strcasecmp(pA->category, pB->category))!=0)
+		return diff;
+	return strcasecmp(pA->name, pB->name);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	catScan
+Synopsis:
+	Reads every executable file in the catalog directory that has an
+	aslLCD-name line.  Hidden files and editor backups (name~) are skipped.
+	A directory that isn't there is the same as an empty one.
+Author:
+	John Gedde
+Inputs:
+	const char *dir: the catalog directory, "" for none
+	ConfScript_t *pScripts: where to put them
+	uint16_t max: room in pScripts
+	uint16_t timeout_s: timeout for scripts that don't give one
+Outputs:
+	ConfScript_t *pScripts: the scripts, sorted by category then name
+	uint16_t: how many
+-----------------------------------------------------------------------------*/
+uint16_t catScan(const char *dir, ConfScript_t *pScripts, uint16_t max, uint16_t timeout_s)
+{
+	DIR *pDir;
+	struct dirent *pEnt;
+	struct stat st;
+	char path[PATH_MAX];
+	ConfScript_t script;
+	size_t len;
+	uint16_t num=0;
+
+	if (dir[0]=='\0')
+		return 0;
+	if ((pDir=opendir(dir))==NULL)
+	{
+		if (errno!=ENOENT)
+			fprintf(stderr, "aslLCD Error: Can't read script catalog %s\n", dir);
+		return 0;
+	}
+
+	while ((pEnt=readdir(pDir))!=NULL)
+	{
+		len=strlen(pEnt->d_name);
+		if (pEnt->d_name[0]=='.' || pEnt->d_name[len-1]=='~')
+			continue;
+
+		snprintf(path, sizeof(path), "%s/%s", dir, pEnt->d_name);
+		if (stat(path, &st)!=0 || !S_ISREG(st.st_mode) || access(path, X_OK)!=0)
+			continue;
+		if (strlen(path)>=CONF_PATH_LEN)
+		{
+			fprintf(stderr, "aslLCD Error: Script path %s is too long\n", path);
+			continue;
+		}
+
+		memset(&script, 0, sizeof(script));
+		strcpy(script.path, path);
+		script.timeout_s=timeout_s;
+		script.confNum=CONF_SCRIPT_CATALOG;
+		if (!catReadHeader(path, &script))
+			continue;
+
+		if (num==max)
+		{
+			fprintf(stderr, "aslLCD Error: More than %u scripts in %s, skipping %s\n", max, dir, pEnt->d_name);
+			continue;
+		}
+		pScripts[num++]=script;
+	}
+	closedir(pDir);
+
+	qsort(pScripts, num, sizeof(ConfScript_t), catCompare);
+	return num;
+}
@@ -0,0 +1,50 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  catalog.h
+*
+*  Synopsis:	Header file for catalog.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _CATALOG
+#define _CATALOG
+
+#include <stdint.h>
+
+#include "ini.h"
+
+// Header lines in a catalog script look like
+//		# aslLCD-name: Weather
+#define CAT_KEY_PREFIX		"aslLCD-"
+
+// Only this many lines at the top of a script are read for the header
+#define CAT_HEADER_LINES	30
+
+uint16_t catScan(const char *dir, ConfScript_t *pScripts, uint16_t max, uint16_t timeout_s);
+
+#endif
@@ -57,4 +57,26 @@ uint64_t getClock_ms()
 	retval=(unsigned long long)(tv.tv_sec) * 1000 + (unsigned long long)(tv.tv_nsec) / 1000000;
 
 	return retval;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	getClock_us   
+Synopsis:
+	Reads a monotonic clock in microseconds for timing things.  Not related
+	to the time of day.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	uint64_t: microseconds from an arbitrary starting point
+-----------------------------------------------------------------------------*/
+uint64_t getClock_us()
+{
+	struct timespec tv;
+
+	clock_gettime(CLOCK_MONOTONIC, &tv);
+
+	return (uint64_t)(tv.tv_sec) * 1000000 + (uint64_t)(tv.tv_nsec) / 1000;
 }
\ No newline at end of file
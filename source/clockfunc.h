@@ -39,6 +39,7 @@
 #include <stdint.h>
 
 uint64_t getClock_ms();
+uint64_t getClock_us();
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,315 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  cputemp.c
+*
+*  Synopsis:	CPU temperature sampler.  A thread reads the thermal zone in
+*				sysfs (millidegrees C) every sample_s seconds and keeps the
+*				last CT_HISTORY readings in a ring for the temperature
+*				screen.  Each reading goes to the status segment and is
+*				checked against the overheat threshold, with hysteresis,
+*				for the backlight.  The sysfs file stays open and is
+*				re-read from the start each time.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "cputemp.h"
+#include "ini.h"
+#include "main.h"
+#include "clockfunc.h"
+#include "statusshm.h"
+#include "ui.h"
+
+static pthread_t sampleThread;
+static pthread_mutex_t ringLock=PTHREAD_MUTEX_INITIALIZER;
+static bool sampling=FALSE;
+static bool sampleKill=FALSE;
+static bool overheat=FALSE;
+
+// Oldest sample is ring[(head+CT_HISTORY-count) % CT_HISTORY]
+static int16_t ring[CT_HISTORY];
+static uint16_t head=0;
+static uint16_t count=0;
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctRead
+Synopsis:
+	Reads the thermal zone
+Author:
+	John Gedde
+Inputs:
+	int fd: the open sysfs file
+	int16_t *pTemp_dC: where to put the temperature
+Outputs:
+	bool: TRUE if there was a reading
+-----------------------------------------------------------------------------*/
+static bool ctRead(int fd, int16_t *pTemp_dC)
+{
+	char buf[16];
+	char *end;
+	ssize_t len;
+	long mC;
+
+	len=pread(fd, buf, sizeof(buf)-1, 0);
+	if (len<=0)
+		return FALSE;
+	buf[len]='\0';
+
+	mC=strtol(buf, &end, 10);
+	if (end==buf || mC<-100000 || mC>200000)
+		return FALSE;
+
+	*pTemp_dC=(int16_t)((mC+(mC<0 ? -50 : 50))/100);
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctAdd
+Synopsis:
+	Puts a reading in the ring, publishes it and works out whether we're
+	overheating.  Overheat starts at overheat_c and ends once it's down to
+	overheat_clear_c.  An overheat_c of 0 turns it off.
+Author:
+	John Gedde
+Inputs:
+	int16_t temp_dC: the reading
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void ctAdd(int16_t temp_dC)
+{
+	const AslLcdConf_t *pConf=conf;
+	bool hot=__atomic_load_n(&overheat, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&ringLock);
+	ring[head]=temp_dC;
+	head=(head+1) % CT_HISTORY;
+	if (count<CT_HISTORY)
+		count++;
+	pthread_mutex_unlock(&ringLock);
+
+	if (pConf->overheat_dC==0)
+		hot=FALSE;
+	else if (temp_dC>=pConf->overheat_dC)
+		hot=TRUE;
+	else if (temp_dC<=pConf->overheatClear_dC)
+		hot=FALSE;
+	__atomic_store_n(&overheat, hot, __ATOMIC_RELAXED);
+
+	shmPublishTemp(temp_dC);
+	uiNotify(UI_DATA_TEMP);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	sampleThreadFn
+Synopsis:
+	Takes a reading every sample_s seconds.  Wakes every CT_POLL_MS to
+	see if it should stop.
+Author:
+	John Gedde
+Inputs:
+	void *p: the open sysfs file
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *sampleThreadFn(void *p)
+{
+	int fd=(int)(intptr_t)p;
+	uint64_t now, next=0;
+	int16_t temp_dC;
+	bool failed=FALSE;
+
+	while (!__atomic_load_n(&sampleKill, __ATOMIC_RELAXED))
+	{
+		now=getClock_ms();
+		if (now>=next)
+		{
+			if (ctRead(fd, &temp_dC))
+			{
+				ctAdd(temp_dC);
+				failed=FALSE;
+			}
+			else if (!failed)
+			{
+				fprintf(stderr, "aslLCD Error: Couldn't read %s\n", CT_SYSFS_PATH);
+				failed=TRUE;
+			}
+			next=now+(uint64_t)conf->cpuTempSample_s*1000;
+		}
+		usleep((next-now<CT_POLL_MS ? next-now : CT_POLL_MS)*1000);
+	}
+
+	close(fd);
+	return NULL;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctStart
+Synopsis:
+	Starts the sampler thread.  The first reading is taken straight away.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void ctStart()
+{
+	int fd;
+
+	if (sampling)
+		return;
+
+	fd=open(CT_SYSFS_PATH, O_RDONLY | O_CLOEXEC);
+	if (fd<0)
+	{
+		fprintf(stderr, "aslLCD Error: Couldn't open %s\n", CT_SYSFS_PATH);
+		return;
+	}
+
+	sampleKill=FALSE;
+	if (pthread_create(&sampleThread, NULL, sampleThreadFn, (void *)(intptr_t)fd)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create CPU temperature thread\n");
+		close(fd);
+		return;
+	}
+	sampling=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctStop
+Synopsis:
+	Stops the sampler thread.  Takes up to CT_POLL_MS.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void ctStop()
+{
+	if (!sampling)
+		return;
+
+	__atomic_store_n(&sampleKill, TRUE, __ATOMIC_RELAXED);
+	pthread_join(sampleThread, NULL);
+	sampling=FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctStats
+Synopsis:
+	Latest reading and the lowest and highest in the history
+Author:
+	John Gedde
+Inputs:
+	CtStats_t *pStats: where to put them
+Outputs:
+	bool: FALSE if there hasn't been a reading yet
+-----------------------------------------------------------------------------*/
+bool ctStats(CtStats_t *pStats)
+{
+	int16_t t;
+
+	pthread_mutex_lock(&ringLock);
+	pStats->count=count;
+	if (count)
+	{
+		pStats->now_dC=ring[(head+CT_HISTORY-1) % CT_HISTORY];
+		pStats->min_dC=pStats->now_dC;
+		pStats->max_dC=pStats->now_dC;
+		for (uint16_t i=0; i<count; ++i)
+		{
+			t=ring[(head+CT_HISTORY-1-i) % CT_HISTORY];
+			if (t<pStats->min_dC)
+				pStats->min_dC=t;
+			if (t>pStats->max_dC)
+				pStats->max_dC=t;
+		}
+	}
+	pthread_mutex_unlock(&ringLock);
+
+	return pStats->count>0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctHistory
+Synopsis:
+	Copies out the newest readings, oldest first
+Author:
+	John Gedde
+Inputs:
+	int16_t *pSamples: where to put them
+	uint16_t max: room in pSamples
+Outputs:
+	uint16_t: number copied
+-----------------------------------------------------------------------------*/
+uint16_t ctHistory(int16_t *pSamples, uint16_t max)
+{
+	uint16_t n;
+
+	pthread_mutex_lock(&ringLock);
+	n=(count<max) ? count : max;
+	for (uint16_t i=0; i<n; ++i)
+		pSamples[i]=ring[(head+CT_HISTORY-n+i) % CT_HISTORY];
+	pthread_mutex_unlock(&ringLock);
+
+	return n;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	ctOverheat
+Synopsis:
+	Whether the CPU is over the overheat threshold
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool: TRUE if it is
+-----------------------------------------------------------------------------*/
+bool ctOverheat()
+{
+	return __atomic_load_n(&overheat, __ATOMIC_RELAXED);
+}
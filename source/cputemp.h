@@ -0,0 +1,59 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  cputemp.h
+*
+*  Synopsis:	Header file for cputemp.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _CPUTEMP
+#define _CPUTEMP
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CT_SYSFS_PATH		"/sys/class/thermal/thermal_zone0/temp"
+#define CT_HISTORY			96			// samples kept
+#define CT_POLL_MS			250			// how quickly ctStop() is noticed
+
+// Temperatures are in tenths of a degree C, same as the status segment
+typedef struct
+{
+	int16_t now_dC;
+	int16_t min_dC;						// over the history
+	int16_t max_dC;
+	uint16_t count;						// samples in the history
+} CtStats_t;
+
+void 		ctStart();
+void 		ctStop();
+bool 		ctStats(CtStats_t *pStats);
+uint16_t 	ctHistory(int16_t *pSamples, uint16_t max);
+bool 		ctOverheat();
+
+#endif
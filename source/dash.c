@@ -0,0 +1,190 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  dash.c
+*
+*  Synopsis:	Dashboard line templates.  A template like
+*				"{node} L:{links}" is compiled once, when the conf file is
+*				read, into the fixed text and a list of fields with the
+*				column and width of each.  Drawing then only has to write
+*				the fields whose value changed since the last time.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dash.h"
+#include "main.h"
+
+// Field names as used in templates, and how wide they are unless the
+// template says otherwise ({ip:12})
+static const struct
+{
+	const char *name;
+	uint8_t width;
+} fieldDefs[DF_MAX]=
+{
+	{ "node",	6 },
+	{ "links",	2 },
+	{ "temp",	3 },
+	{ "tempf",	3 },
+	{ "ip",		15 },
+	{ "time",	5 },
+	{ "date",	6 },
+	{ "ast",	4 },
+	{ "rx",		2 },
+	{ "tx",		2 }
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	dashCompile
+Synopsis:
+	Compiles a template into a DashLine_t.  Fields are {name} or
+	{name:width}.  Anything past 16 columns is cut off.  A field name that
+	isn't known is left out.
+Author:
+	John Gedde
+Inputs:
+	const char *tmpl: the template
+	DashLine_t *pLine: where to put it
+Outputs:
+	bool: FALSE if there was something wrong with the template
+-----------------------------------------------------------------------------*/
+bool dashCompile(const char *tmpl, DashLine_t *pLine)
+{
+	const char *p=tmpl, *end;
+	char name[16];
+	size_t nameLen;
+	uint8_t col=0, width;
+	int field, w;
+	char *colon;
+	bool ok=TRUE;
+
+	memset(pLine, 0, sizeof(DashLine_t));
+	memset(pLine->text, ' ', DASH_TEXT_LEN);
+
+	while (*p && col<DASH_TEXT_LEN)
+	{
+		if (*p!='{')
+		{
+			pLine->text[col++]=*p++;
+			continue;
+		}
+
+		end=strchr(p, '}');
+		nameLen=end ? (size_t)(end-p-1) : 0;
+		if (end==NULL || nameLen==0 || nameLen>=sizeof(name))
+		{
+			fprintf(stderr, "aslLCD Error: Bad dashboard field in \"%s\"\n", tmpl);
+			ok=FALSE;
+			break;
+		}
+		memcpy(name, p+1, nameLen);
+		name[nameLen]='\0';
+		p=end+1;
+
+		width=0;
+		if ((colon=strchr(name, ':'))!=NULL)
+		{
+			*colon='\0';
+			w=atoi(colon+1);
+			width=(w>0 && w<=DASH_TEXT_LEN) ? w : 0;
+		}
+
+		for (field=0; field<DF_MAX; ++field)
+		{
+			if (strcmp(name, fieldDefs[field].name)==0)
+				break;
+		}
+		if (field==DF_MAX || pLine->numOps>=DASH_MAX_FIELDS)
+		{
+			fprintf(stderr, "aslLCD Error: Can't show dashboard field {%s}\n", name);
+			ok=FALSE;
+			continue;
+		}
+
+		if (width==0)
+			width=fieldDefs[field].width;
+		if (col+width>DASH_TEXT_LEN)
+			width=DASH_TEXT_LEN-col;
+
+		pLine->ops[pLine->numOps].field=field;
+		pLine->ops[pLine->numOps].col=col;
+		pLine->ops[pLine->numOps].width=width;
+		pLine->numOps++;
+		pLine->fields|=DASH_FIELD_BIT(field);
+		col+=width;
+	}
+
+	return ok;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dashDraw
+Synopsis:
+	Draws a dashboard line.  With all set the whole line is written;
+	otherwise only fields that look different from what was drawn last
+	time go to the LCD.
+Author:
+	John Gedde
+Inputs:
+	const DashLine_t *pLine: compiled template
+	LcdLine_t line: which LCD line
+	const DashValues_t *pVals: current values
+	DashDrawn_t *pDrawn: what was drawn last time
+	bool all: TRUE to redraw the whole line
+Outputs:
+	DashDrawn_t *pDrawn: what's drawn now
+-----------------------------------------------------------------------------*/
+void dashDraw(const DashLine_t *pLine, LcdLine_t line, const DashValues_t *pVals, DashDrawn_t *pDrawn, bool all)
+{
+	char buf[DASH_TEXT_LEN+1];
+	char field[DASH_TEXT_LEN+1];
+	const DashOp_t *pOp;
+
+	strcpy(buf, pLine->text);
+
+	for (uint8_t i=0; i<pLine->numOps; ++i)
+	{
+		pOp=&pLine->ops[i];
+		snprintf(field, sizeof(field), "%-*.*s", pOp->width, pOp->width, pVals->str[pOp->field]);
+
+		if (all)
+			memcpy(buf+pOp->col, field, pOp->width);
+		else if (strcmp(field, pDrawn->field[i])!=0)
+			lcdWriteAt(line, pOp->col, field, pOp->width);
+
+		strcpy(pDrawn->field[i], field);
+	}
+
+	if (all)
+		lcdWriteLn(buf, line, FALSE);
+}
@@ -0,0 +1,101 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  dash.h
+*
+*  Synopsis:	Header file for dash.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _DASH
+#define _DASH
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lcdfunc.h"
+
+#define DASH_MAX_PAGES			4
+#define DASH_MAX_FIELDS			8		// per line
+#define DASH_TEXT_LEN			16		// one LCD line
+
+// Things a dashboard line can show, {node} etc.
+typedef enum
+{
+	DF_NODE=0,
+	DF_LINKS,
+	DF_TEMP,
+	DF_TEMPF,
+	DF_IP,
+	DF_TIME,
+	DF_DATE,
+	DF_AST,
+	DF_RX,
+	DF_TX,
+	DF_MAX
+} DashField_t;
+
+#define DASH_FIELD_BIT(f)		(1u<<(f))
+
+// A field's place on the line
+typedef struct
+{
+	uint8_t field;						// DashField_t
+	uint8_t col;
+	uint8_t width;
+} DashOp_t;
+
+// A compiled template: the fixed text with blanks where the fields go
+typedef struct
+{
+	char text[DASH_TEXT_LEN+1];
+	DashOp_t ops[DASH_MAX_FIELDS];
+	uint8_t numOps;
+	uint32_t fields;					// DASH_FIELD_BIT()s used
+} DashLine_t;
+
+typedef struct
+{
+	DashLine_t line[2];
+} DashPage_t;
+
+// Current value of each field, already formatted
+typedef struct
+{
+	char str[DF_MAX][DASH_TEXT_LEN+1];
+} DashValues_t;
+
+// What's on the LCD for each field of a line
+typedef struct
+{
+	char field[DASH_MAX_FIELDS][DASH_TEXT_LEN+1];
+} DashDrawn_t;
+
+bool dashCompile(const char *tmpl, DashLine_t *pLine);
+void dashDraw(const DashLine_t *pLine, LcdLine_t line, const DashValues_t *pVals, DashDrawn_t *pDrawn, bool all);
+
+#endif
@@ -31,6 +31,7 @@
 *    Date    |      Eng     |               Description
 *  ----------+--------------+------------------------------------------------
 *  3/24/23		John Gedde		Orginal Version
+*  10/19/26		John Gedde		Interface names come from conf
 *  
 ****************************************************************************/
 
@@ -53,7 +54,6 @@
 #include <pthread.h>
 #include <wiringPi.h>
 #include <ctype.h>
-#include <iniparser.h>
 
 #include "getIP.h"
 #include "ini.h"
@@ -79,13 +79,12 @@ void getIPaddress(char *buf)
     int s;
 	char host[NI_MAXHOST];
 	const char *str;
-	char wifiDeviceName[32];
+	const char *wifiDeviceName;
 	
 	buf[0]='\0';
 	
-	str=iniparser_getstring(ini, "network devices:wifi interface name", "wlan0");
-	strncpy(wifiDeviceName, str, sizeof(wifiDeviceName)-1);
-	str=iniparser_getstring(ini, "network devices:wired interface name", "eth0");
+	wifiDeviceName=conf->wifiIface;
+	str=conf->wiredIface;
 
     if (getifaddrs(&ifaddr) == -1) 
     {
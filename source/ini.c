@@ -33,20 +33,828 @@
 *    Date    |      Eng     |               Description
 *  ----------+--------------+------------------------------------------------
 *  03/12/23  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Read the whole conf file once into a typed
+*            |              |  AslLcdConf_t instead of looking keys up on
+*            |              |  every screen.  iniparser_getstring_16() is
+*            |              |  gone (its static buffer wasn't thread safe.)
+*  10/19/26  | John Gedde   |  Watch the conf file with inotify and swap in
+*            |              |  a new AslLcdConf_t when it changes
+*  10/19/26  | John Gedde   |  Build the menu tree from [menu]
+*  10/19/26  | John Gedde   |  Compile the [dashboard] page templates
+*  10/19/26  | John Gedde   |  Connect/disconnect progress messages
+*  10/19/26  | John Gedde   |  Script timeouts, max_running
+*  10/19/26  | John Gedde   |  [announce] section, say_xxx menu actions
+*  10/19/26  | John Gedde   |  Read the scripts.d catalog with the conf file
+*            |              |  and reload when it changes
+*  10/19/26  | John Gedde   |  [wifi connect] scan_cache_s
+*  10/19/26  | John Gedde   |  wpa_ctrl_dir, join_timeout_s and wifi join
+*            |              |  messages
+*  10/19/26  | John Gedde   |  search_string and no_wifi are gone (no more
+*            |              |  iwconfig)
+*  10/19/26  | John Gedde   |  Shorter fast_up_down defaults for text entry
+*  10/19/26  | John Gedde   |  [recent nodes] section
+*  10/19/26  | John Gedde   |  [node search] and callsign search text
+*  10/19/26  | John Gedde   |  [cpu temp] section and overheat backlight
 *  
 ****************************************************************************/
 
+#include <unistd.h>
+#include <errno.h>
+#include <strings.h>
+#include <limits.h>
+#include <libgen.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <iniparser.h>
+
 #include "ini.h"
+#include "main.h"
+#include "catalog.h"
+#include "clockfunc.h"
+
+// Shown for any display text missing from the conf file
+#define STR_CONF_PROBLEM	"CONF PROBLEM!"
+
+// Editors write a file in bursts; wait this long after the last change
+// before reading it
+#define CONF_SETTLE_MS		250
+
+// Old confs waiting out the grace period
+#define MAX_RETIRED			8
+
+// The conf file
+const AslLcdConf_t * volatile conf=NULL;
+
+static char confPath[PATH_MAX];
+static pthread_t confWatchThread;
+static bool confWatchRunning=FALSE;
+static volatile bool confWatchKill=FALSE;
+
+static struct
+{
+	const AslLcdConf_t *pConf;
+	uint64_t retired_ms;
+} retired[MAX_RETIRED];
+
+// Where each display string comes from.  Keys with %d are a run of
+// count strings (main_menu0, main_menu1...)  def NULL means STR_CONF_PROBLEM.
+typedef struct
+{
+	ConfStr_t first;
+	const char *key;
+	uint16_t count;
+	const char *def;
+} ConfStrKey_t;
+
+static const ConfStrKey_t strKeys[]=
+{
+	{ STR_STARTUP_LINE1,			"startup:line1",							1, "Your Call" },
+	{ STR_STARTUP_LINE2,			"startup:line2",							1, "Allstar Node" },
+	{ STR_MAIN_MENU_TOP,			"main menu:main_menu_top",					1, NULL },
+	{ STR_MAIN_MENU_0,				"main menu:main_menu%d",					CONF_NUM_MAIN_MENU, NULL },
+	{ STR_NODE_INFO_TOP,			"node info menu:menu_select_info",			1, NULL },
+	{ STR_NODE_INFO_NUM_CONNS,		"node info menu:menu_num_conns",			1, NULL },
+	{ STR_NODE_INFO_UP_TIME,		"node info menu:menu_up_time",				1, NULL },
+	{ STR_HDG_LOCAL_TIME,			"headings:hdg_local_time",					1, NULL },
+	{ STR_HDG_VERSION,				"headings:hdg_version",						1, NULL },
+	{ STR_HDG_IP_ADDR,				"headings:hdg_ip_addr",						1, NULL },
+	{ STR_HDG_CPU_TEMP,				"headings:hdg_cpu_temp",					1, NULL },
+	{ STR_HDG_BL_TEST,				"headings:hdg_bl_test",						1, NULL },
+	{ STR_HDG_SEL_LOCAL_NODE,		"headings:hdg_sel_local_node",				1, NULL },
+	{ STR_HDG_ACTIVE_LOCAL_NODE,	"headings:hdg_active_local_node",			1, NULL },
+	{ STR_HDG_CONNECTIONS,			"headings:hdg_connections",					1, NULL },
+	{ STR_HDG_NUMBER_OF_CONNS,		"headings:hdg_number_of_conns",				1, NULL },
+	{ STR_HDG_UP_TIME,				"headings:hdg_up_time",						1, NULL },
+	{ STR_HDG_SELECT_SCRIPT,		"headings:hdg_select_script",				1, NULL },
+	{ STR_HDG_CURRENT_WIFI,			"headings:hdg_current_wifi",				1, NULL },
+	{ STR_HDG_ENTER_PASSWORD,		"headings:hdg_enter_password",				1, NULL },
+	{ STR_HDG_CALLSIGN,				"headings:hdg_callsign",					1, "Enter Callsign" },
+	{ STR_OTHER_INFO_TOP,			"other info menu:menu_select_info",			1, NULL },
+	{ STR_OTHER_INFO_CLOCK,			"other info menu:menu_show_clock",			1, NULL },
+	{ STR_OTHER_INFO_IP,			"other info menu:menu_show_ip",				1, NULL },
+	{ STR_OTHER_INFO_CPU_TEMP,		"other info menu:menu_show_cpu_temp",		1, NULL },
+	{ STR_OTHER_INFO_VERSION,		"other info menu:menu_aslLCD_version",		1, NULL },
+	{ STR_MENU_CONNECT,				"connect disconnect:menu_connect",			1, NULL },
+	{ STR_MENU_DISCONNECT,			"connect disconnect:menu_disconnect",		1, NULL },
+	{ STR_MENU_FAVORITES,			"connect disconnect:menu_favorites",		1, NULL },
+	{ STR_MENU_ENTER_NODE_NUM,		"connect disconnect:menu_enter_node_num",	1, NULL },
+	{ STR_MENU_CHOOSE_NODENUM,		"connect disconnect:menu_choose_nodenum",	1, NULL },
+	{ STR_MENU_SET_NODE_NUM,		"connect disconnect:menu_set_node_num",		1, NULL },
+	{ STR_MENU_CONNECTION_MODE,		"connect disconnect:menu_connection_mode",	1, NULL },
+	{ STR_CONN_TYPE_0,				"connect disconnect:menu_conn_type%d",		CONF_NUM_CONN_TYPES, NULL },
+	{ STR_MENU_DISCONNECT_ALL,		"connect disconnect:menu_disconnect_all",	1, NULL },
+	{ STR_MENU_RECENT,				"connect disconnect:menu_recent",			1, "Recent" },
+	{ STR_MENU_FIND_CALLSIGN,		"connect disconnect:menu_find_callsign",	1, "Find Callsign" },
+	{ STR_MSG_NO_FAVORITES,			"messages:msg_no_favorites",				1, NULL },
+	{ STR_MSG_NO_RECENT,			"messages:msg_no_recent",					1, "No Recent Nodes" },
+	{ STR_MSG_NO_MATCHES,			"messages:msg_no_matches",					1, "No Matches" },
+	{ STR_MSG_NO_ASTDB,				"messages:msg_no_astdb",					1, "No astdb.txt" },
+	{ STR_MSG_NEED_CALLSIGN,		"messages:msg_need_callsign",				1, "Type a callsign" },
+	{ STR_MSG_NO_LOCALNODES,		"messages:msg_no_localnodes",				1, NULL },
+	{ STR_MSG_NO_CONNECTIONS,		"messages:msg_no_connections",				1, NULL },
+	{ STR_MSG_FUTURE_FEATURE,		"messages:msg_future_feature",				1, NULL },
+	{ STR_MSG_SHUTDOWN,				"messages:msg_shutdown",					1, NULL },
+	{ STR_MSG_PLEASE_WAIT,			"messages:msg_please_wait",					1, NULL },
+	{ STR_MSG_GETTING_NODE_LIST,	"messages:msg_getting_node_list",			1, NULL },
+	{ STR_MSG_GETTING_CONNECTIONS,	"messages:msg_getting_connections",			1, NULL },
+	{ STR_MSG_CANCEL_PROMPT,		"messages:msg_cancel_prompt",				1, NULL },
+	{ STR_MSG_NO_SCRIPT_NAME,		"messages:msg_no_script_name",				1, NULL },
+	{ STR_MSG_NO_SCRIPT_PATH,		"messages:msg_no_script_path",				1, NULL },
+	{ STR_MSG_OK_SELECT_TYPE_LINE1,	"messages:msg_ok_select_type_line1",		1, NULL },
+	{ STR_MSG_OK_SELECT_TYPE_LINE2,	"messages:msg_ok_select_type_line2",		1, NULL },
+	{ STR_MSG_SCANNING_FOR_WIFI,	"messages:msg_scanning_for_wifi",			1, NULL },
+	{ STR_MSG_GETTING_INFO,			"messages:msg_getting_info",				1, NULL },
+	{ STR_MSG_NO_WIFI_AVAILABLE,	"messages:msg_no_wifi_available",			1, NULL },
+	{ STR_MSG_AT_LEAST_8_CHARS,		"messages:msg_at_least_8_chars",			1, NULL },
+	{ STR_MSG_YES,					"messages:msg_yes",							1, NULL },
+	{ STR_MSG_NO,					"messages:msg_no",							1, NULL },
+	{ STR_MSG_WAITING_ASTERISK,		"messages:msg_waiting_asterisk",			1, "Wait for Astrsk" },
+	{ STR_MSG_ASTERISK_DOWN,		"messages:msg_asterisk_down",				1, "Asterisk down" },
+	{ STR_MSG_CONNECTING,			"messages:msg_connecting",					1, "Connecting" },
+	{ STR_MSG_DISCONNECTING,		"messages:msg_disconnecting",				1, "Disconnecting" },
+	{ STR_MSG_LINKED,				"messages:msg_linked",						1, "Linked in" },
+	{ STR_MSG_UNLINKED,				"messages:msg_unlinked",					1, "Unlinked in" },
+	{ STR_MSG_LINK_FAILED,			"messages:msg_link_failed",					1, "Asterisk said no" },
+	{ STR_MSG_LINK_TIMEOUT,			"messages:msg_link_timeout",				1, "Timed out" },
+	{ STR_MSG_SCRIPT_RUNNING,		"messages:msg_script_running",				1, "Running" },
+	{ STR_MSG_SCRIPT_DONE,			"messages:msg_script_done",					1, "Done" },
+	{ STR_MSG_SCRIPT_FAILED,		"messages:msg_script_failed",				1, "Failed" },
+	{ STR_MSG_SCRIPT_TIMEOUT,		"messages:msg_script_timeout",				1, "Timed out" },
+	{ STR_MSG_SCRIPT_NO_OUTPUT,		"messages:msg_script_no_output",			1, "(no output)" },
+	{ STR_MSG_SCRIPT_ALREADY,		"messages:msg_script_already",				1, "Already running" },
+	{ STR_MSG_SCRIPT_BUSY,			"messages:msg_script_busy",					1, "Too many running" },
+	{ STR_MSG_WIFI_JOINING,			"messages:msg_wifi_joining",				1, "Joining" },
+	{ STR_MSG_WIFI_JOINED,			"messages:msg_wifi_joined",					1, "Connected" },
+	{ STR_MSG_WIFI_WRONG_KEY,		"messages:msg_wifi_wrong_key",				1, "Wrong password" },
+	{ STR_MSG_WIFI_FAILED,			"messages:msg_wifi_failed",					1, "Couldn't join" },
+	{ STR_MSG_WIFI_TIMEOUT,			"messages:msg_wifi_timeout",				1, "Timed out" },
+	{ STR_SAY_TIME,					"announce:label_say_time",					1, "Say Time" },
+	{ STR_SAY_TIME24,				"announce:label_say_time24",				1, "Say 24 hr Time" },
+	{ STR_SAY_IP,					"announce:label_say_ip",					1, "Say IP Addr" },
+	{ STR_WIFI_CHOOSE_ACTION,		"wifi menu:menu_choose_action",				1, NULL },
+	{ STR_WIFI_SHOW_CURRENT,		"wifi menu:menu_show_current",				1, NULL },
+	{ STR_WIFI_CONNECT_NEW,			"wifi menu:menu_connect_new",				1, NULL },
+	{ STR_WIFI_SELECT_SSID,			"wifi menu:menu_select_ssid",				1, NULL },
+	{ STR_WIFI_REBOOT,				"wifi menu:menu_reboot",					1, NULL },
+	{ STR_COLOR_0,					"color_names:color%d",						CONF_NUM_COLORS, NULL }
+};
+
+// conf file key suffixes for each backlight state (backlight:color_XXX, etc)
+static const char *blStateKeys[BLS_MAX]=
+{
+	"default",
+	"network_up",
+	"asterisk_down",
+	"overheat",
+	"COS",
+	"PTT",
+	"PTTCOS",
+	"TX_timeout"
+};
+
+// Backlight defaults for when the conf file doesn't have an entry
+static const BlPattern_t blDefaultPatterns[BLS_MAX]=
+{
+	{ BLC_WHITE,	BLC_BL_OFF,	BLE_SOLID,		1000 },	// idle
+	{ BLC_BLUE,		BLC_BL_OFF,	BLE_SOLID,		1000 },	// network up
+	{ BLC_RED,		BLC_BL_OFF,	BLE_BLINK,		2000 },	// asterisk down
+	{ BLC_YELLOW,	BLC_RED,	BLE_ALTERNATE,	1000 },	// CPU overheat
+	{ BLC_GREEN,	BLC_BL_OFF,	BLE_SOLID,		1000 },	// COS
+	{ BLC_RED,		BLC_BL_OFF,	BLE_SOLID,		1000 },	// PTT
+	{ BLC_VIOLET,	BLC_BL_OFF,	BLE_SOLID,		1000 },	// PTT and COS
+	{ BLC_RED,		BLC_BLUE,	BLE_ALTERNATE,	500 }	// TX timeout
+};
+
+// [menu] action names, by MenuAction_t
+static const char *menuActionNames[MA_MAX]=
+{
+	"submenu",
+	"connect",
+	"disconnect",
+	"connections",
+	"set_node",
+	"active_node",
+	"num_conns",
+	"up_time",
+	"shutdown",
+	"reboot",
+	"clock",
+	"ip",
+	"cpu_temp",
+	"version",
+	"wifi_current",
+	"wifi_connect",
+	"bl_test",
+	"scripts",
+	"script",
+	"quit",
+	"say_time",
+	"say_time24",
+	"say_ip"
+};
+
+// Label for a [menu] item that doesn't have one, by MenuAction_t.  STR_MAX
+// means there isn't a standard one.
+static const ConfStr_t menuDefaultLabels[MA_MAX]=
+{
+	STR_MAX,
+	STR_MAIN_MENU_0,
+	STR_MAIN_MENU_0+1,
+	STR_MAIN_MENU_0+2,
+	STR_MAIN_MENU_0+3,
+	STR_MAIN_MENU_0+4,
+	STR_NODE_INFO_NUM_CONNS,
+	STR_NODE_INFO_UP_TIME,
+	STR_MAIN_MENU_0+6,
+	STR_MAIN_MENU_0+7,
+	STR_OTHER_INFO_CLOCK,
+	STR_OTHER_INFO_IP,
+	STR_OTHER_INFO_CPU_TEMP,
+	STR_OTHER_INFO_VERSION,
+	STR_WIFI_SHOW_CURRENT,
+	STR_WIFI_CONNECT_NEW,
+	STR_MAIN_MENU_0+10,
+	STR_MAIN_MENU_0+11,
+	STR_MAX,
+	STR_MAIN_MENU_0+12,
+	STR_SAY_TIME,
+	STR_SAY_TIME24,
+	STR_SAY_IP
+};
+
+// The standard menus, used when the conf file has no [menu] section.  Same
+// paths as the itemX keys would have.
+typedef struct
+{
+	const char *path;
+	MenuAction_t action;
+	ConfStr_t label;
+	ConfStr_t heading;
+} MenuDefault_t;
+
+static const MenuDefault_t defaultMenu[]=
+{
+	{ "1",		MA_CONNECT,			STR_MAIN_MENU_0,	STR_MAX },
+	{ "2",		MA_DISCONNECT,		STR_MAIN_MENU_0+1,	STR_MAX },
+	{ "3",		MA_SHOW_CONNS,		STR_MAIN_MENU_0+2,	STR_MAX },
+	{ "4",		MA_SET_NODE,		STR_MAIN_MENU_0+3,	STR_MAX },
+	{ "5",		MA_ACTIVE_NODE,		STR_MAIN_MENU_0+4,	STR_MAX },
+	{ "6",		MA_SUBMENU,			STR_MAIN_MENU_0+5,	STR_NODE_INFO_TOP },
+	{ "6.1",	MA_NUM_CONNS,		STR_NODE_INFO_NUM_CONNS,	STR_MAX },
+	{ "6.2",	MA_UP_TIME,			STR_NODE_INFO_UP_TIME,		STR_MAX },
+	{ "7",		MA_SHUTDOWN,		STR_MAIN_MENU_0+6,	STR_MAX },
+	{ "8",		MA_REBOOT,			STR_MAIN_MENU_0+7,	STR_MAX },
+	{ "9",		MA_SUBMENU,			STR_MAIN_MENU_0+8,	STR_OTHER_INFO_TOP },
+	{ "9.1",	MA_CLOCK,			STR_OTHER_INFO_CLOCK,		STR_MAX },
+	{ "9.2",	MA_IP,				STR_OTHER_INFO_IP,			STR_MAX },
+	{ "9.3",	MA_CPU_TEMP,		STR_OTHER_INFO_CPU_TEMP,	STR_MAX },
+	{ "9.4",	MA_VERSION,			STR_OTHER_INFO_VERSION,		STR_MAX },
+	{ "10",		MA_SUBMENU,			STR_MAIN_MENU_0+9,	STR_WIFI_CHOOSE_ACTION },
+	{ "10.1",	MA_WIFI_CURRENT,	STR_WIFI_SHOW_CURRENT,		STR_MAX },
+	{ "10.2",	MA_WIFI_CONNECT,	STR_WIFI_CONNECT_NEW,		STR_MAX },
+	{ "11",		MA_BL_TEST,			STR_MAIN_MENU_0+10,	STR_MAX },
+	{ "12",		MA_SCRIPTS,			STR_MAIN_MENU_0+11,	STR_MAX },
+	{ "13",		MA_QUIT,			STR_MAIN_MENU_0+12,	STR_MAX }
+};
+
+// Dashboard pages for a conf file with none of its own
+static const char *defaultDashPages[][2]=
+{
+	{ "{node} L:{links}",	"{time}  {temp}C" },
+	{ "IP address:",		"{ip}" }
+};
+
+/*-----------------------------------------------------------------------------    
+Function:
+	copyStr   
+Synopsis:
+	Reads a string from the conf file into a fixed size buffer.  Anything
+	that doesn't fit is cut off.
+Author:
+	John Gedde
+Inputs:
+	const dictionary *d: the conf file
+	const char *key: section:key
+	const char *def: default value
+	char *buf: where to put it
+	size_t bufLen: size of buf
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void copyStr(const dictionary *d, const char *key, const char *def, char *buf, size_t bufLen)
+{
+	snprintf(buf, bufLen, "%s", iniparser_getstring(d, key, def));
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	readMenuItem   
+Synopsis:
+	Reads one menu item.  In the conf file an item is
+		itemX = action [number] [, label]
+	where X is the path to it (3, 3.1, 3.1.2...) and a submenu can have a
+	heading in itemX.top.  With no label the standard text for the action
+	is used.
+Author:
+	John Gedde
+Inputs:
+	const dictionary *d: the conf file, NULL for the standard menus
+	const AslLcdConf_t *pConf: scripts and display text read so far
+	const char *path: which item
+	MenuNode_t *pNode: where to put it
+Outputs:
+	bool: FALSE if there's no such item (or it's no good)
+-----------------------------------------------------------------------------*/
+static bool readMenuItem(const dictionary *d, const AslLcdConf_t *pConf, const char *path, MenuNode_t *pNode)
+{
+	char key[64], val[128], name[32];
+	char *label=NULL;
+	ConfStr_t labelStr=STR_MAX, headingStr=STR_MAX;
+	int action, num=-1, script=0;
+	
+	memset(pNode, 0, sizeof(MenuNode_t));
+	
+	if (d==NULL)
+	{
+		for (action=0; action<(int)(sizeof(defaultMenu)/sizeof(defaultMenu[0])); ++action)
+		{
+			if (strcmp(defaultMenu[action].path, path)==0)
+				break;
+		}
+		if (action==(int)(sizeof(defaultMenu)/sizeof(defaultMenu[0])))
+			return FALSE;
+		
+		labelStr=defaultMenu[action].label;
+		headingStr=defaultMenu[action].heading;
+		action=defaultMenu[action].action;
+	}
+	else
+	{
+		snprintf(key, sizeof(key), "menu:item%s", path);
+		copyStr(d, key, "", val, sizeof(val));
+		if (val[0]=='\0')
+			return FALSE;
+		
+		if ((label=strchr(val, ','))!=NULL)
+		{
+			*label++='\0';
+			label+=strspn(label, " \t");
+		}
+		if (sscanf(val, "%31s %d", name, &num)<1)
+			return FALSE;
+		
+		for (action=0; action<MA_MAX; ++action)
+		{
+			if (strcasecmp(name, menuActionNames[action])==0)
+				break;
+		}
+		if (action==MA_MAX)
+		{
+			fprintf(stderr, "aslLCD Error: Menu item%s has unknown action %s\n", path, name);
+			return FALSE;
+		}
+		labelStr=menuDefaultLabels[action];
+	}
+	
+	// A single script is picked by its number in [scripts]
+	if (action==MA_SCRIPT)
+	{
+		for (script=0; script<pConf->numScripts; ++script)
+		{
+			if (pConf->scripts[script].confNum==num)
+				break;
+		}
+		if (num<0 || script==pConf->numScripts)
+		{
+			fprintf(stderr, "aslLCD Error: Menu item%s has no script %d\n", path, num);
+			return FALSE;
+		}
+		pNode->param=script;
+	}
+	pNode->action=action;
+	
+	if (label && label[0])
+		snprintf(pNode->label, sizeof(pNode->label), "%s", label);
+	else if (labelStr<STR_MAX)
+		strcpy(pNode->label, pConf->str[labelStr]);
+	else if (action==MA_SCRIPT)
+		strcpy(pNode->label, pConf->scripts[script].name);
+	else
+		strcpy(pNode->label, STR_CONF_PROBLEM);
+	
+	if (action==MA_SUBMENU)
+	{
+		if (d==NULL)
+			strcpy(pNode->heading, pConf->str[headingStr]);
+		else
+		{
+			snprintf(key, sizeof(key), "menu:item%s.top", path);
+			copyStr(d, key, pNode->label, pNode->heading, sizeof(pNode->heading));
+		}
+	}
+	
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	compileMenu   
+Synopsis:
+	Builds the menu tree into pConf->menu.  It's done a level at a time so
+	every submenu's items end up next to each other in the array.  Missing
+	item numbers are skipped, so an item can be hidden by commenting it
+	out.  No [menu] section (or one with nothing in it) gets the standard
+	menus.
+Author:
+	John Gedde
+Inputs:
+	const dictionary *d: the conf file
+	AslLcdConf_t *pConf: where to put it (scripts and text already read)
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void compileMenu(const dictionary *d, AslLcdConf_t *pConf)
+{
+	// "NN." a level, and a spare row for the item that doesn't fit
+	char paths[MENU_MAX_NODES+1][MENU_MAX_DEPTH*3+1];
+	_Static_assert(MENU_MAX_ITEMS<100, "paths[] has room for 2 digit items");
+	uint8_t depth[MENU_MAX_NODES];
+	MenuNode_t *pMenu=pConf->menu;
+	MenuNode_t node;
+	uint16_t num;
+	int len;
+	
+	if (!iniparser_find_entry(d, "menu"))
+		d=NULL;
+	
+	while (TRUE)
+	{
+		memset(pMenu, 0, sizeof(pConf->menu));
+		pMenu[MENU_ROOT].action=MA_SUBMENU;
+		if (d)
+			copyStr(d, "menu:top", pConf->str[STR_MAIN_MENU_TOP], pMenu[MENU_ROOT].heading, sizeof(pMenu[MENU_ROOT].heading));
+		else
+			strcpy(pMenu[MENU_ROOT].heading, pConf->str[STR_MAIN_MENU_TOP]);
+		paths[MENU_ROOT][0]='\0';
+		depth[MENU_ROOT]=0;
+		num=1;
+		
+		// The array grows as it goes, so this gets to the new submenus too
+		for (uint16_t n=0; n<num; ++n)
+		{
+			if (pMenu[n].action!=MA_SUBMENU)
+				continue;
+			if (depth[n]>=MENU_MAX_DEPTH-1)
+			{
+				fprintf(stderr, "aslLCD Error: Menu item%s is nested too deep\n", paths[n]);
+				continue;
+			}
+			
+			pMenu[n].firstChild=num;
+			for (int i=1; i<=MENU_MAX_ITEMS; ++i)
+			{
+				// Can't be cut short, the depth check above keeps it to 3 levels
+				if (n==MENU_ROOT)
+					len=snprintf(paths[num], sizeof(paths[0]), "%d", i);
+				else
+					len=snprintf(paths[num], sizeof(paths[0]), "%s.%d", paths[n], i);
+				
+				if (len>=(int)sizeof(paths[0]) || !readMenuItem(d, pConf, paths[num], &node))
+					continue;
+				if (num>=MENU_MAX_NODES)
+				{
+					fprintf(stderr, "aslLCD Error: Too many menu items, item%s and after left out\n", paths[num]);
+					break;
+				}
+				
+				node.parent=n;
+				pMenu[num]=node;
+				depth[num]=depth[n]+1;
+				pMenu[n].numChildren++;
+				num++;
+			}
+			
+			if (pMenu[n].numChildren==0 && n!=MENU_ROOT)
+				fprintf(stderr, "aslLCD Error: Menu item%s is an empty submenu\n", paths[n]);
+		}
+		
+		if (pMenu[MENU_ROOT].numChildren>0 || d==NULL)
+			break;
+		
+		fprintf(stderr, "aslLCD Error: [menu] has no items, using the standard menus\n");
+		d=NULL;
+	}
+	
+	pConf->numMenuNodes=num;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	compileDashPage   
+Synopsis:
+	Adds a dashboard page to pConf
+Author:
+	John Gedde
+Inputs:
+	const char *line1, *line2: templates for each line
+	AslLcdConf_t *pConf: where to put it
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void compileDashPage(const char *line1, const char *line2, AslLcdConf_t *pConf)
+{
+	DashPage_t *pPage=&pConf->dashPages[pConf->numDashPages++];
+	
+	dashCompile(line1, &pPage->line[0]);
+	dashCompile(line2, &pPage->line[1]);
+	pConf->dashFields|=pPage->line[0].fields | pPage->line[1].fields;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	indexScriptCats   
+Synopsis:
+	Finds the runs of scripts in each category.  scripts[] is already in
+	order: the ones with no category first, then by category.
+Author:
+	John Gedde
+Inputs:
+	AslLcdConf_t *pConf: scripts read so far
+Outputs:
+	AslLcdConf_t *pConf: numTopScripts and scriptCats[]
+-----------------------------------------------------------------------------*/
+static void indexScriptCats(AslLcdConf_t *pConf)
+{
+	const ConfScript_t *pScript;
+	ConfScriptCat_t *pCat=NULL;
+	
+	for (uint16_t i=0; i<pConf->numScripts; ++i)
+	{
+		pScript=&pConf->scripts[i];
+		if (pScript->category[0]=='\0')
+			pConf->numTopScripts++;
+		else if (pCat && strcasecmp(pCat->name, pScript->category)==0)
+			pCat->count++;
+		else if (pConf->numScriptCats==CONF_MAX_SCRIPT_CATS)
+		{
+			fprintf(stderr, "aslLCD Error: More than %d script categories, skipping %s\n", 
+				CONF_MAX_SCRIPT_CATS, pScript->category);
+			pConf->numScripts=i;
+			break;
+		}
+		else
+		{
+			pCat=&pConf->scriptCats[pConf->numScriptCats++];
+			strcpy(pCat->name, pScript->category);
+			pCat->first=i;
+			pCat->count=1;
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	compileConf   
+Synopsis:
+	Reads everything aslLCD uses from the conf file into pConf
+Author:
+	John Gedde
+Inputs:
+	const dictionary *d: the conf file
+	AslLcdConf_t *pConf: where to put it
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void compileConf(const dictionary *d, AslLcdConf_t *pConf)
+{
+	char key[64];
+	const char *def;
+	ConfScript_t *pScript;
+	uint16_t scriptTimeout_s;
+	BlPattern_t *pPat;
+	char tmpl[2][CONF_PATH_LEN];
+	
+	memset(pConf, 0, sizeof(AslLcdConf_t));
+	
+	// Display text
+	for (unsigned int i=0; i<sizeof(strKeys)/sizeof(strKeys[0]); ++i)
+	{
+		def=strKeys[i].def ? strKeys[i].def : STR_CONF_PROBLEM;
+		for (int n=0; n<strKeys[i].count; ++n)
+		{
+			snprintf(key, sizeof(key), strKeys[i].key, n);
+			copyStr(d, key, def, pConf->str[strKeys[i].first+n], CONF_STR_LEN+1);
+		}
+	}
+	
+	pConf->startupDisp_ms=iniparser_getint(d, "startup:disptime_ms", 3000);
+	pConf->shutdownWait_ms=iniparser_getint(d, "shutdown:shutdown_wait", 1000);
+	
+	// Favorites
+	for (int i=0; i<CONF_MAX_FAVORITES; ++i)
+	{
+		sprintf(key, "favorites:favnode%d", i);
+		pConf->favorites[i].nodeNum=iniparser_getint(d, key, 0);
+		sprintf(key, "favorites:friendlyName%d", i);
+		copyStr(d, key, "", pConf->favorites[i].friendlyName, CONF_STR_LEN+1);
+	}
+	
+	// Recent nodes
+	copyStr(d, "recent nodes:file", "/var/lib/aslLCD/recent_nodes", pConf->recentFile, sizeof(pConf->recentFile));
+	pConf->recentHalfLife_h=iniparser_getint(d, "recent nodes:half_life_h", 72);
+	
+	// Node search
+	copyStr(d, "node search:astdb_file", "/var/log/asterisk/astdb.txt", pConf->astdbFile, sizeof(pConf->astdbFile));
+	
+	// CPU temperature.  Overheat clears a few degrees down so it can't flap.
+	pConf->cpuTempSample_s=iniparser_getint(d, "cpu temp:sample_s", 5);
+	if (pConf->cpuTempSample_s==0)
+		pConf->cpuTempSample_s=1;
+	pConf->overheat_dC=iniparser_getint(d, "cpu temp:overheat_c", 75)*10;
+	pConf->overheatClear_dC=iniparser_getint(d, "cpu temp:overheat_clear_c", 70)*10;
+	if (pConf->overheatClear_dC>pConf->overheat_dC)
+		pConf->overheatClear_dC=pConf->overheat_dC;
+	
+	// Backlight
+	pConf->statusBacklight=iniparser_getint(d, "backlight:status_backlight", 0)!=0;
+	pConf->backlightCmdPort=iniparser_getint(d, "backlight:backlight_cmd_port", 0);
+	pConf->coalesce_ms=iniparser_getint(d, "backlight:coalesce_ms", 30);
+	pConf->minDwell_ms=iniparser_getint(d, "backlight:min_dwell_ms", 300);
+	for (int i=0; i<BLS_MAX; ++i)
+	{
+		pPat=&pConf->blPatterns[i];
+		
+		sprintf(key, "backlight:color_%s", blStateKeys[i]);
+		pPat->color=iniparser_getint(d, key, blDefaultPatterns[i].color) & 7;
 
-// Global ini file
-dictionary *ini=NULL;
+		sprintf(key, "backlight:alt_color_%s", blStateKeys[i]);
+		pPat->altColor=iniparser_getint(d, key, blDefaultPatterns[i].altColor) & 7;
 
+		sprintf(key, "backlight:effect_%s", blStateKeys[i]);
+		pPat->effect=iniparser_getint(d, key, blDefaultPatterns[i].effect);
+		if (pPat->effect>=BLE_MAX)
+			pPat->effect=BLE_SOLID;
+
+		sprintf(key, "backlight:period_%s_ms", blStateKeys[i]);
+		pPat->period_ms=iniparser_getint(d, key, blDefaultPatterns[i].period_ms);
+		if (pPat->period_ms==0)
+			pPat->effect=BLE_SOLID;
+	}
+	
+	// Options
+	pConf->clock24=iniparser_getint(d, "options:clock24", 0)!=0;
+	pConf->statusShm=iniparser_getint(d, "options:status_shm", 1)!=0;
+	pConf->i2cBusKHz=iniparser_getint(d, "options:i2c_bus_khz", 100);
+	if (pConf->i2cBusKHz==0)
+		pConf->i2cBusKHz=100;
+	
+	// Scripts.  Skip any without a path or a name.
+	scriptTimeout_s=iniparser_getint(d, "scripts:timeout_s", 60);
+	pConf->maxScriptsRunning=iniparser_getint(d, "scripts:max_running", 2);
+	if (pConf->maxScriptsRunning==0)
+		pConf->maxScriptsRunning=1;
+	for (int i=0; i<CONF_MAX_SCRIPTS; ++i)
+	{
+		pScript=&pConf->scripts[pConf->numScripts];
+		
+		sprintf(key, "scripts:script_path%d", i);
+		copyStr(d, key, "", pScript->path, sizeof(pScript->path));
+		sprintf(key, "scripts:script_name%d", i);
+		copyStr(d, key, "", pScript->name, sizeof(pScript->name));
+		sprintf(key, "scripts:script_param%d", i);
+		copyStr(d, key, "", pScript->param, sizeof(pScript->param));
+		sprintf(key, "scripts:script_need_node_num%d", i);
+		pScript->needNodeNum=iniparser_getint(d, key, 0)!=0;
+		sprintf(key, "scripts:script_timeout_s%d", i);
+		pScript->timeout_s=iniparser_getint(d, key, scriptTimeout_s);
+		pScript->confNum=i;
+		
+		if (i==0)
+			pConf->noScriptsMsg=pScript->path[0] ? STR_MSG_NO_SCRIPT_NAME : STR_MSG_NO_SCRIPT_PATH;
+		
+		if (pScript->path[0] && pScript->name[0])
+			pConf->numScripts++;
+		else
+			memset(pScript, 0, sizeof(ConfScript_t));
+	}
+	
+	// Then the catalog.  The ones without a category go on the top level
+	// with the ones above.
+	copyStr(d, "scripts:catalog_dir", "/etc/aslLCD/scripts.d", pConf->catalogDir, sizeof(pConf->catalogDir));
+	pConf->numScripts+=catScan(pConf->catalogDir, &pConf->scripts[pConf->numScripts], 
+		CONF_MAX_CATALOG, scriptTimeout_s);
+	indexScriptCats(pConf);
+	
+	// Network
+	copyStr(d, "network devices:wifi interface name", "wlan0", pConf->wifiIface, sizeof(pConf->wifiIface));
+	copyStr(d, "network devices:wired interface name", "eth0", pConf->wiredIface, sizeof(pConf->wiredIface));
+	pConf->netCheckDivisor=iniparser_getint(d, "network check:divisor", 10);
+	
+	// Wifi
+	pConf->scrollStep_ms=iniparser_getint(d, "wifi connect:scroll_step_interval_ms", 500);
+	pConf->fastUpDownWait_ms=iniparser_getint(d, "wifi connect:fast_up_down_wait_ms", 400);
+	pConf->fastUpDownRate_ms=iniparser_getint(d, "wifi connect:fast_up_down_rate_ms", 50);
+	pConf->wifiScanCache_s=iniparser_getint(d, "wifi connect:scan_cache_s", 30);
+	copyStr(d, "wifi connect:wpa_supplicant_file", "/etc/wpa_supplicant/wlan0.conf", 
+		pConf->wpaSupplicantFile, sizeof(pConf->wpaSupplicantFile));
+	copyStr(d, "wifi connect:wpa_ctrl_dir", "/var/run/wpa_supplicant", pConf->wpaCtrlDir, sizeof(pConf->wpaCtrlDir));
+	pConf->wifiJoinTimeout_s=iniparser_getint(d, "wifi connect:join_timeout_s", 30);
+	
+	copyStr(d, "reboot:script", "", pConf->rebootScript, sizeof(pConf->rebootScript));
+	
+	// Announcements
+	copyStr(d, "announce:sounds_dir", "/var/lib/asterisk/sounds", pConf->soundsDir, sizeof(pConf->soundsDir));
+	copyStr(d, "announce:sound_ext", "gsm", pConf->soundExt, sizeof(pConf->soundExt));
+	
+	// Menus go last; they use the scripts and display text
+	compileMenu(d, pConf);
+	
+	// Dashboard.  Skip pages with nothing on them.
+	pConf->dashIdle_s=iniparser_getint(d, "dashboard:idle_timeout_s", 0);
+	pConf->dashPage_s=iniparser_getint(d, "dashboard:page_time_s", 5);
+	for (int i=0; i<DASH_MAX_PAGES; ++i)
+	{
+		sprintf(key, "dashboard:page%d_line1", i);
+		copyStr(d, key, "", tmpl[0], sizeof(tmpl[0]));
+		sprintf(key, "dashboard:page%d_line2", i);
+		copyStr(d, key, "", tmpl[1], sizeof(tmpl[1]));
+		if (tmpl[0][0]=='\0' && tmpl[1][0]=='\0')
+			continue;
+		
+		compileDashPage(tmpl[0], tmpl[1], pConf);
+	}
+	for (unsigned int i=0; pConf->numDashPages==0 && i<sizeof(defaultDashPages)/sizeof(defaultDashPages[0]); ++i)
+		compileDashPage(defaultDashPages[i][0], defaultDashPages[i][1], pConf);
+	
+	pConf->defaultStartupMenu=iniparser_getint(d, "main menu:default_startup_menu", 0);
+	if (pConf->defaultStartupMenu>=pConf->menu[MENU_ROOT].numChildren)
+		pConf->defaultStartupMenu=0;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	loadConf   
+Synopsis:
+	Reads and checks the conf file.  A file that doesn't parse, or is missing
+	the menus or the backlight section, is rejected.
+Author:
+	John Gedde
+Inputs:
+	const char *pName: path and filename to the conf file
+	uint32_t generation: generation number for the new conf
+Outputs:
+	AslLcdConf_t *: the new conf (caller frees), NULL if bad
+-----------------------------------------------------------------------------*/
+static AslLcdConf_t *loadConf(const char *pName, uint32_t generation)
+{
+	dictionary *ini;
+	AslLcdConf_t *pConf;
+	
+	ini = iniparser_load(pName);
+	if (ini==NULL)
+	{
+		fprintf(stderr, "aslLCD Error: Cannot open conf file %s\n", pName);
+		return NULL;
+	}
+	
+	if (!iniparser_find_entry(ini, "main menu") || !iniparser_find_entry(ini, "backlight"))
+	{
+		fprintf(stderr, "aslLCD Error: Conf file %s is missing [main menu] or [backlight]\n", pName);
+		iniparser_freedict(ini);
+		return NULL;
+	}
+	
+	pConf=malloc(sizeof(AslLcdConf_t));
+	if (pConf==NULL)
+	{
+		fprintf(stderr, "aslLCD Error: Out of memory reading conf file\n");
+		iniparser_freedict(ini);
+		return NULL;
+	}
+	
+	compileConf(ini, pConf);
+	iniparser_freedict(ini);
+	pConf->generation=generation;
+	
+	if (pConf->statusBacklight && pConf->backlightCmdPort==0)
+	{
+		fprintf(stderr, "aslLCD Error: Conf file %s has no backlight_cmd_port\n", pName);
+		free(pConf);
+		return NULL;
+	}
+	
+	return pConf;
+}
 
 /*-----------------------------------------------------------------------------    
 Function:
 	initIni   
 Synopsis:
-	Initializes access to the iniparser conf file
+	Reads the conf file into conf.  The file is only parsed here and when it
+	changes (see startConfWatch); everything else comes from conf.
+	(using iniparser library from N. Devillard)
+	(https://github.com/ndevilla/iniparser)
 Author:
 	John Gedde
 Inputs:
@@ -56,39 +864,278 @@ Outputs:
 -----------------------------------------------------------------------------*/
 void initIni(const char *pName)
 {
-	ini = iniparser_load(pName);
-    if (ini==NULL)
+	AslLcdConf_t *pConf;
+	
+	snprintf(confPath, sizeof(confPath), "%s", pName);
+	
+	pConf=loadConf(confPath, 0);
+    if (pConf==NULL)
 	{
         printf("cannot open conf file\n");
         exit(-1);
     }
+	
+	conf=pConf;
 }
 
 /*-----------------------------------------------------------------------------    
 Function:
-	iniparser_getstring_16   
+	freeRetired   
 Synopsis:
-	Read a string from ini file but only let it be 16 char max
+	Frees old confs that are past the grace period
 Author:
 	John Gedde
 Inputs:
-	const dictionary *d: pointer to the dictionary containing the conf file read.
-	const char *key: the section/key
-	const char *def: the default value	
+	bool all: free them all regardless
 Outputs:
+	uint64_t: when the next one is due (ms), 0 if none waiting
+-----------------------------------------------------------------------------*/
+static uint64_t freeRetired(bool all)
+{
+	uint64_t now=getClock_ms();
+	uint64_t next=0;
+	
+	for (int i=0; i<MAX_RETIRED; ++i)
+	{
+		if (retired[i].pConf==NULL)
+			continue;
+		
+		if (all || now>=retired[i].retired_ms+CONF_GRACE_MS)
+		{
+			free((void*)retired[i].pConf);
+			retired[i].pConf=NULL;
+		}
+		else if (next==0 || retired[i].retired_ms+CONF_GRACE_MS<next)
+			next=retired[i].retired_ms+CONF_GRACE_MS;
+	}
+	return next;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	reloadConf   
+Synopsis:
+	Reads the conf file again and, if it's good, swaps it in.  The old one
+	is freed after the grace period.  If all the retired slots are in use
+	(someone is saving the file over and over) the reload waits.
+Author:
+	John Gedde
+Inputs:
 	None
+Outputs:
+	bool: TRUE if done (good or bad file), FALSE to try again later
 -----------------------------------------------------------------------------*/
-const char* iniparser_getstring_16(const dictionary *d, const char* key, const char* def)
+static bool reloadConf()
 {
-	const char *s;
-	static char buf[17]="                ";
-	static const char* pBuf=(const char*)buf;
- 
-	// Get the raw string from the conf file
-	s=iniparser_getstring(d, key, def);
+	AslLcdConf_t *pConf;
+	const AslLcdConf_t *pOld;
+	int slot=-1;
+	
+	freeRetired(FALSE);
+	for (int i=0; i<MAX_RETIRED && slot<0; ++i)
+	{
+		if (retired[i].pConf==NULL)
+			slot=i;
+	}
+	if (slot<0)
+		return FALSE;
+	
+	pOld=conf;
+	pConf=loadConf(confPath, pOld->generation+1);
+	if (pConf==NULL)
+	{
+		fprintf(stderr, "aslLCD Warning: Keeping the old settings\n");
+		return TRUE;
+	}
+	
+	__atomic_store_n(&conf, pConf, __ATOMIC_RELEASE);
+	
+	retired[slot].pConf=pOld;
+	retired[slot].retired_ms=getClock_ms();
 	
-	// if text is more than 16 characters, it'll be truncated
-	sprintf(buf, "%-.16s", s);  
+	fprintf(stderr, "aslLCD: Reloaded %s\n", confPath);
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	watchCatalog   
+Synopsis:
+	Points the catalog watch at conf->catalogDir if it isn't already.  If
+	the directory isn't there yet this is tried again after every reload.
+Author:
+	John Gedde
+Inputs:
+	int fd: inotify fd
+	int confWd: watch on the conf file's directory
+	int catWd: catalog watch, -1 if none
+	char *watched: CONF_PATH_LEN buffer, directory catWd is on
+Outputs:
+	int: new catalog watch, -1 if none
+-----------------------------------------------------------------------------*/
+static int watchCatalog(int fd, int confWd, int catWd, char *watched)
+{
+	if (catWd>=0 && strcmp(watched, conf->catalogDir)==0)
+		return catWd;
+	
+	// Don't take the conf watch with it if they're the same directory
+	if (catWd>=0 && catWd!=confWd)
+		inotify_rm_watch(fd, catWd);
+	
+	strcpy(watched, conf->catalogDir);
+	if (watched[0]=='\0')
+		return -1;
+	
+	catWd=inotify_add_watch(fd, watched, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+		IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MASK_ADD);
+	if (catWd<0 && errno!=ENOENT)
+		fprintf(stderr, "aslLCD Error: Can't watch %s for changes\n", watched);
+	return catWd;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	confWatchThreadFn   
+Synopsis:
+	Watches the directory the conf file is in (editors often write a new
+	file and rename it over the old one, which a watch on the file itself
+	would miss.)  Once the file has been quiet for CONF_SETTLE_MS it's
+	reloaded.  Any change in the script catalog directory (new script,
+	chmod +x, edit, delete) reloads too.  Also frees old confs when their
+	grace period is up.
+Author:
+	John Gedde
+Inputs:
+	void *p: arguments
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *confWatchThreadFn(void *p)
+{
+	int fd, confWd=-1, catWd;
+	char dirBuf[PATH_MAX], baseBuf[PATH_MAX];
+	char catWatched[CONF_PATH_LEN]="";
+	const char *dirName, *baseName;
+	char evBuf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	struct pollfd pfd;
+	ssize_t len;
+	uint64_t now, reloadAt=0, freeAt=0, deadline;
+	int timeout;
+	
+	strcpy(dirBuf, confPath);
+	strcpy(baseBuf, confPath);
+	dirName=dirname(dirBuf);
+	baseName=basename(baseBuf);
+	
+	fd=inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd<0 || (confWd=inotify_add_watch(fd, dirName, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE))<0)
+	{
+		fprintf(stderr, "aslLCD Error: Can't watch %s for changes\n", confPath);
+		if (fd>=0)
+			close(fd);
+		return NULL;
+	}
+	catWd=watchCatalog(fd, confWd, -1, catWatched);
+	
+	pfd.fd=fd;
+	pfd.events=POLLIN;
+	
+	while (!confWatchKill)
+	{
+		// Wake for a change, a settled reload, a grace period ending, or
+		// at least twice a second to check for kill
+		now=getClock_ms();
+		deadline=now+500;
+		if (reloadAt && reloadAt<deadline)
+			deadline=reloadAt;
+		if (freeAt && freeAt<deadline)
+			deadline=freeAt;
+		timeout=(deadline>now) ? (int)(deadline-now) : 0;
+		
+		if (poll(&pfd, 1, timeout)>0)
+		{
+			while ((len=read(fd, evBuf, sizeof(evBuf)))>0)
+			{
+				for (char *pEv=evBuf; pEv<evBuf+len; pEv+=sizeof(struct inotify_event)+ev->len)
+				{
+					ev=(const struct inotify_event *)pEv;
+					if (ev->wd==catWd)
+					{
+						// Directory went away
+						if (ev->mask & IN_IGNORED)
+							catWd=-1;
+						reloadAt=getClock_ms()+CONF_SETTLE_MS;
+					}
+					else if (ev->wd==confWd && ev->len && strcmp(ev->name, baseName)==0)
+						reloadAt=getClock_ms()+CONF_SETTLE_MS;
+				}
+			}
+		}
+		
+		now=getClock_ms();
+		if (reloadAt && now>=reloadAt)
+		{
+			if (reloadConf())
+			{
+				reloadAt=0;
+				catWd=watchCatalog(fd, confWd, catWd, catWatched);
+			}
+			else
+				reloadAt=now+CONF_SETTLE_MS;
+		}
+		freeAt=freeRetired(FALSE);
+	}
+	
+	close(fd);
+	return p;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	startConfWatch   
+Synopsis:
+	Starts reloading the conf file whenever it changes.  Settings that are
+	only used at startup (backlight command port, status_backlight,
+	status_shm) still need a restart.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void startConfWatch()
+{
+	confWatchKill=FALSE;
+	if (pthread_create(&confWatchThread, NULL, confWatchThreadFn, NULL)!=0)
+		fprintf(stderr, "aslLCD Error: Could not create conf watch thread\n");
+	else
+		confWatchRunning=TRUE;
+}
 
-	return pBuf;
-}
\ No newline at end of file
+/*-----------------------------------------------------------------------------    
+Function:
+	closeIni   
+Synopsis:
+	Stops watching the conf file and frees it
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void closeIni()
+{
+	if (confWatchRunning)
+	{
+		confWatchKill=TRUE;
+		pthread_join(confWatchThread, NULL);
+		confWatchRunning=FALSE;
+	}
+	
+	freeRetired(TRUE);
+	free((void*)conf);
+	conf=NULL;
+}
@@ -0,0 +1,336 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD and COSmon are free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD and COSmon are distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  ini.h
+*
+*  Synopsis:	Header file for ini.c.  aslLCD.conf is read once into an
+*				AslLcdConf_t.  Display text is in str[], indexed by ConfStr_t
+*				and already cut to 16 chars; everything else is typed.
+*
+*  Projects:	Allstar Link LCD, COSmon
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  03/12/23  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Compile conf file into AslLcdConf_t
+*  10/19/26  | John Gedde   |  Reload the conf file when it changes
+*  10/19/26  | John Gedde   |  Waiting for Asterisk message
+*  10/19/26  | John Gedde   |  Asterisk down message
+*  10/19/26  | John Gedde   |  Menu tree from the [menu] section
+*  10/19/26  | John Gedde   |  Idle dashboard pages
+*  10/19/26  | John Gedde   |  Connect/disconnect progress messages
+*  10/19/26  | John Gedde   |  Script timeouts and output messages
+*  10/19/26  | John Gedde   |  Built in announcements
+*  10/19/26  | John Gedde   |  scripts.d catalog and script categories
+*  10/19/26  | John Gedde   |  Wifi scan cache time
+*  10/19/26  | John Gedde   |  Join wifi through wpa_supplicant's control socket
+*  10/19/26  | John Gedde   |  No more iwconfig search strings
+*  10/19/26  | John Gedde   |  Recent nodes
+*  10/19/26  | John Gedde   |  Callsign search
+*  10/19/26  | John Gedde   |  CPU temperature sampling and overheat
+*
+****************************************************************************/
+
+#ifndef _INI
+#define _INI
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "backlight.h"
+#include "menu.h"
+#include "dash.h"
+
+#define CONF_STR_LEN			16		// one LCD line
+#define CONF_PATH_LEN			128
+#define CONF_NAME_LEN			32
+#define CONF_MAX_FAVORITES		20
+#define CONF_MAX_SCRIPTS		10		// script_pathN in the conf file
+#define CONF_MAX_CATALOG		48		// more from scripts.d
+#define CONF_MAX_SCRIPT_CATS	16
+#define CONF_NUM_MAIN_MENU		13
+#define CONF_NUM_CONN_TYPES		4
+#define CONF_NUM_COLORS			8
+
+// Display text from the conf file
+typedef enum
+{
+	// [startup]
+	STR_STARTUP_LINE1=0,
+	STR_STARTUP_LINE2,
+
+	// [main menu]
+	STR_MAIN_MENU_TOP,
+	STR_MAIN_MENU_0,
+	STR_MAIN_MENU_LAST=STR_MAIN_MENU_0+CONF_NUM_MAIN_MENU-1,
+
+	// [node info menu]
+	STR_NODE_INFO_TOP,
+	STR_NODE_INFO_NUM_CONNS,
+	STR_NODE_INFO_UP_TIME,
+
+	// [headings]
+	STR_HDG_LOCAL_TIME,
+	STR_HDG_VERSION,
+	STR_HDG_IP_ADDR,
+	STR_HDG_CPU_TEMP,
+	STR_HDG_BL_TEST,
+	STR_HDG_SEL_LOCAL_NODE,
+	STR_HDG_ACTIVE_LOCAL_NODE,
+	STR_HDG_CONNECTIONS,
+	STR_HDG_NUMBER_OF_CONNS,
+	STR_HDG_UP_TIME,
+	STR_HDG_SELECT_SCRIPT,
+	STR_HDG_CURRENT_WIFI,
+	STR_HDG_ENTER_PASSWORD,
+	STR_HDG_CALLSIGN,
+
+	// [other info menu]
+	STR_OTHER_INFO_TOP,
+	STR_OTHER_INFO_CLOCK,
+	STR_OTHER_INFO_IP,
+	STR_OTHER_INFO_CPU_TEMP,
+	STR_OTHER_INFO_VERSION,
+
+	// [connect disconnect]
+	STR_MENU_CONNECT,
+	STR_MENU_DISCONNECT,
+	STR_MENU_FAVORITES,
+	STR_MENU_ENTER_NODE_NUM,
+	STR_MENU_CHOOSE_NODENUM,
+	STR_MENU_SET_NODE_NUM,
+	STR_MENU_CONNECTION_MODE,
+	STR_CONN_TYPE_0,
+	STR_CONN_TYPE_LAST=STR_CONN_TYPE_0+CONF_NUM_CONN_TYPES-1,
+	STR_MENU_DISCONNECT_ALL,
+	STR_MENU_RECENT,
+	STR_MENU_FIND_CALLSIGN,
+
+	// [messages]
+	STR_MSG_NO_FAVORITES,
+	STR_MSG_NO_RECENT,
+	STR_MSG_NO_MATCHES,
+	STR_MSG_NO_ASTDB,
+	STR_MSG_NEED_CALLSIGN,
+	STR_MSG_NO_LOCALNODES,
+	STR_MSG_NO_CONNECTIONS,
+	STR_MSG_FUTURE_FEATURE,
+	STR_MSG_SHUTDOWN,
+	STR_MSG_PLEASE_WAIT,
+	STR_MSG_GETTING_NODE_LIST,
+	STR_MSG_GETTING_CONNECTIONS,
+	STR_MSG_CANCEL_PROMPT,
+	STR_MSG_NO_SCRIPT_NAME,
+	STR_MSG_NO_SCRIPT_PATH,
+	STR_MSG_OK_SELECT_TYPE_LINE1,
+	STR_MSG_OK_SELECT_TYPE_LINE2,
+	STR_MSG_SCANNING_FOR_WIFI,
+	STR_MSG_GETTING_INFO,
+	STR_MSG_NO_WIFI_AVAILABLE,
+	STR_MSG_AT_LEAST_8_CHARS,
+	STR_MSG_YES,
+	STR_MSG_NO,
+	STR_MSG_WAITING_ASTERISK,
+	STR_MSG_ASTERISK_DOWN,
+	STR_MSG_CONNECTING,
+	STR_MSG_DISCONNECTING,
+	STR_MSG_LINKED,
+	STR_MSG_UNLINKED,
+	STR_MSG_LINK_FAILED,
+	STR_MSG_LINK_TIMEOUT,
+	STR_MSG_SCRIPT_RUNNING,
+	STR_MSG_SCRIPT_DONE,
+	STR_MSG_SCRIPT_FAILED,
+	STR_MSG_SCRIPT_TIMEOUT,
+	STR_MSG_SCRIPT_NO_OUTPUT,
+	STR_MSG_SCRIPT_ALREADY,
+	STR_MSG_SCRIPT_BUSY,
+	STR_MSG_WIFI_JOINING,
+	STR_MSG_WIFI_JOINED,
+	STR_MSG_WIFI_WRONG_KEY,
+	STR_MSG_WIFI_FAILED,
+	STR_MSG_WIFI_TIMEOUT,
+
+	// [announce]
+	STR_SAY_TIME,
+	STR_SAY_TIME24,
+	STR_SAY_IP,
+
+	// [wifi menu]
+	STR_WIFI_CHOOSE_ACTION,
+	STR_WIFI_SHOW_CURRENT,
+	STR_WIFI_CONNECT_NEW,
+	STR_WIFI_SELECT_SSID,
+	STR_WIFI_REBOOT,
+
+	// [color_names]
+	STR_COLOR_0,
+	STR_COLOR_LAST=STR_COLOR_0+CONF_NUM_COLORS-1,
+
+	STR_MAX
+} ConfStr_t;
+
+typedef struct
+{
+	uint32_t nodeNum;						// 0 if not set
+	char friendlyName[CONF_STR_LEN+1];		// empty if not set
+} ConfFavorite_t;
+
+typedef struct
+{
+	char path[CONF_PATH_LEN];
+	char name[CONF_STR_LEN+1];
+	char param[CONF_PATH_LEN];
+	bool needNodeNum;
+	char category[CONF_STR_LEN+1];			// "" for the top level
+	uint16_t confNum;						// N in script_pathN
+	uint16_t timeout_s;						// 0: never killed
+} ConfScript_t;
+
+// confNum of a script from the catalog
+#define CONF_SCRIPT_CATALOG		0xFFFF
+
+// A run of scripts[] in the same category
+typedef struct
+{
+	char name[CONF_STR_LEN+1];
+	uint16_t first;
+	uint16_t count;
+} ConfScriptCat_t;
+
+typedef struct
+{
+	uint32_t generation;					// goes up by one on every reload
+	
+	char str[STR_MAX][CONF_STR_LEN+1];
+
+	// [startup], [shutdown]
+	uint16_t startupDisp_ms;
+	uint16_t shutdownWait_ms;
+
+	// [favorites]
+	ConfFavorite_t favorites[CONF_MAX_FAVORITES];
+
+	// [recent nodes]
+	char recentFile[CONF_PATH_LEN];
+	uint16_t recentHalfLife_h;
+
+	// [node search]
+	char astdbFile[CONF_PATH_LEN];
+
+	// [cpu temp] temperatures in tenths of a degree C
+	uint16_t cpuTempSample_s;
+	int16_t overheat_dC;					// 0: no overheat alert
+	int16_t overheatClear_dC;
+
+	// [backlight]
+	bool statusBacklight;
+	uint16_t backlightCmdPort;
+	uint16_t coalesce_ms;
+	uint16_t minDwell_ms;
+	BlPattern_t blPatterns[BLS_MAX];
+
+	// [options]
+	bool clock24;
+	bool statusShm;
+	uint16_t i2cBusKHz;
+
+	// [scripts] only the ones with a path and a name, in order, then the
+	// catalog sorted by category and name.  The first numTopScripts have
+	// no category.
+	ConfScript_t scripts[CONF_MAX_SCRIPTS+CONF_MAX_CATALOG];
+	uint16_t numScripts;
+	uint16_t numTopScripts;
+	ConfScriptCat_t scriptCats[CONF_MAX_SCRIPT_CATS];
+	uint16_t numScriptCats;
+	char catalogDir[CONF_PATH_LEN];
+	ConfStr_t noScriptsMsg;					// what to say if there are none
+	uint16_t maxScriptsRunning;
+
+	// [announce]
+	char soundsDir[CONF_PATH_LEN];
+	char soundExt[8];
+
+	// [network devices], [network check]
+	char wifiIface[CONF_NAME_LEN];
+	char wiredIface[CONF_NAME_LEN];
+	uint16_t netCheckDivisor;
+
+	// [wifi connect]
+	uint16_t scrollStep_ms;
+	uint16_t fastUpDownWait_ms;
+	uint16_t fastUpDownRate_ms;
+	uint16_t wifiScanCache_s;				// a scan is good for this long
+	char wpaSupplicantFile[CONF_PATH_LEN];
+	char wpaCtrlDir[CONF_PATH_LEN];
+	uint16_t wifiJoinTimeout_s;
+
+	// [reboot]
+	char rebootScript[CONF_PATH_LEN];
+
+	// [main menu]
+	uint16_t defaultStartupMenu;
+
+	// [menu], or the standard menus if there isn't one
+	MenuNode_t menu[MENU_MAX_NODES];
+	uint16_t numMenuNodes;
+
+	// [dashboard] only pages with something on them, in order
+	uint16_t dashIdle_s;					// 0: no dashboard
+	uint16_t dashPage_s;					// 0: pages only change with UP/DOWN
+	DashPage_t dashPages[DASH_MAX_PAGES];
+	uint16_t numDashPages;
+	uint32_t dashFields;					// DASH_FIELD_BIT()s used on any page
+} AslLcdConf_t;
+
+// The conf file.  Read only once loaded.  When the file changes a new one
+// is built and swapped in here; the old one stays around for
+// CONF_GRACE_MS so anyone part way through using it can finish.  Just
+// follow the pointer each time - don't keep it.
+extern const AslLcdConf_t * volatile conf;
+
+#define CONF_GRACE_MS			10000
+
+void initIni(const char *pName);
+void startConfWatch();
+void closeIni();
+
+/*-----------------------------------------------------------------------------
+Function:
+	confStr
+Synopsis:
+	Display text from the conf file, 16 chars max
+Author:
+	John Gedde
+Inputs:
+	ConfStr_t id: which string
+Outputs:
+	const char *: the text
+-----------------------------------------------------------------------------*/
+static inline const char *confStr(ConfStr_t id)
+{
+	return conf->str[id];
+}
+
+#endif
@@ -0,0 +1,285 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  latency.c
+*
+*  Synopsis:	Latency histograms for each stage between a COS/PTT command
+*				coming in and the LCD being written.  Fixed log scale
+*				buckets so recording is cheap enough to leave on all the
+*				time.  Either thread can record; counters are atomic.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+
+#include "latency.h"
+
+static LatHist_t hists[LAT_MAX];
+
+static const char *stageNames[LAT_MAX]=
+{
+	"cmd_to_status",
+	"status_to_queue",
+	"queue_to_write",
+	"bl_write",
+	"line_write",
+	"end_to_end"
+};
+
+// Short names for the LCD
+static const char *stageShortNames[LAT_MAX]=
+{
+	"Cmd",
+	"Que",
+	"Dwel",
+	"BLwr",
+	"Txt",
+	"E2E"
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	bucketIndex / bucketTop
+Synopsis:
+	Maps a time to its bucket, and a bucket to the largest time it holds.
+	Under 4us each us has its own bucket.  Above that the two bits below
+	the top bit pick one of 4 buckets for that power of 2.
+Author:
+	John Gedde
+Inputs:
+	uint64_t us: time / int idx: bucket
+Outputs:
+	int: bucket / uint64_t: largest time in the bucket
+-----------------------------------------------------------------------------*/
+static int bucketIndex(uint64_t us)
+{
+	int msb, idx;
+
+	if (us<LAT_SUB_BUCKETS)
+		return (int)us;
+
+	msb=63-__builtin_clzll(us);
+	idx=LAT_SUB_BUCKETS*(msb-1) + (int)((us>>(msb-2)) & (LAT_SUB_BUCKETS-1));
+
+	return (idx<LAT_NUM_BUCKETS) ? idx : LAT_NUM_BUCKETS-1;
+}
+
+static uint64_t bucketTop(int idx)
+{
+	int shift;
+
+	if (idx<LAT_SUB_BUCKETS)
+		return idx;
+
+	shift=idx/LAT_SUB_BUCKETS-1;
+	return ((uint64_t)(LAT_SUB_BUCKETS+idx%LAT_SUB_BUCKETS+1)<<shift)-1;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latRecord
+Synopsis:
+	Adds one measurement to a stage's histogram
+Author:
+	John Gedde
+Inputs:
+	LatStage_t stage: which stage
+	uint64_t us: how long it took in microseconds
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void latRecord(LatStage_t stage, uint64_t us)
+{
+	LatHist_t *h;
+	uint64_t oldMax;
+	int bucket;
+
+	if (stage>=LAT_MAX)
+		return;
+	h=&hists[stage];
+	bucket=bucketIndex(us);
+
+	__atomic_fetch_add(&h->buckets[bucket], 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+
+	oldMax=__atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+	while (us>oldMax &&
+		!__atomic_compare_exchange_n(&h->max_us, &oldMax, us, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latGetHist
+Synopsis:
+	Takes a copy of a stage's histogram
+Author:
+	John Gedde
+Inputs:
+	LatStage_t stage: which stage
+	LatHist_t *pHist: where to put it
+Outputs:
+	LatHist_t *pHist: the copy
+-----------------------------------------------------------------------------*/
+void latGetHist(LatStage_t stage, LatHist_t *pHist)
+{
+	if (stage>=LAT_MAX || !pHist)
+		return;
+
+	pHist->count=__atomic_load_n(&hists[stage].count, __ATOMIC_RELAXED);
+	pHist->max_us=__atomic_load_n(&hists[stage].max_us, __ATOMIC_RELAXED);
+	for (int i=0; i<LAT_NUM_BUCKETS; ++i)
+		pHist->buckets[i]=__atomic_load_n(&hists[stage].buckets[i], __ATOMIC_RELAXED);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latPercentile
+Synopsis:
+	Estimates a percentile from a histogram.  The answer is the top of the
+	bucket the percentile falls in (never more than the max seen.)
+Author:
+	John Gedde
+Inputs:
+	const LatHist_t *pHist: histogram
+	uint16_t pct: percentile (e.g. 50, 99)
+Outputs:
+	uint64_t: time in us, 0 if nothing recorded
+-----------------------------------------------------------------------------*/
+uint64_t latPercentile(const LatHist_t *pHist, uint16_t pct)
+{
+	uint64_t total=0, target, top;
+
+	for (int i=0; i<LAT_NUM_BUCKETS; ++i)
+		total+=pHist->buckets[i];
+	if (total==0)
+		return 0;
+
+	target=(total*pct+99)/100;
+	if (target==0)
+		target=1;
+
+	total=0;
+	for (int i=0; i<LAT_NUM_BUCKETS; ++i)
+	{
+		total+=pHist->buckets[i];
+		if (total>=target)
+		{
+			top=bucketTop(i);
+			return (top<pHist->max_us) ? top : pHist->max_us;
+		}
+	}
+	return pHist->max_us;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latStageName / latStageShortName
+Synopsis:
+	Names for reports and for the LCD (4 chars max)
+Author:
+	John Gedde
+Inputs:
+	LatStage_t stage: which stage
+Outputs:
+	const char *: the name
+-----------------------------------------------------------------------------*/
+const char *latStageName(LatStage_t stage)
+{
+	return (stage<LAT_MAX) ? stageNames[stage] : "";
+}
+
+const char *latStageShortName(LatStage_t stage)
+{
+	return (stage<LAT_MAX) ? stageShortNames[stage] : "";
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latFormatUs
+Synopsis:
+	Formats a time in 5 chars or less (e.g. 850u, 1.2m, 350m, 2.5s)
+Author:
+	John Gedde
+Inputs:
+	char *buf: where to put it (at least 8 chars)
+	uint64_t us: time in microseconds
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void latFormatUs(char *buf, uint64_t us)
+{
+	if (us<1000)
+		sprintf(buf, "%uu", (unsigned int)us);
+	else if (us<10000)
+		sprintf(buf, "%.1fm", us/1000.0);
+	else if (us<1000000)
+		sprintf(buf, "%um", (unsigned int)(us/1000));
+	else if (us<100000000)
+		sprintf(buf, "%.1fs", us/1000000.0);
+	else
+		sprintf(buf, ">99s");
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	latReport
+Synopsis:
+	Text report of all stages for the command port: one line per stage
+	with count, p50, p99 and max in microseconds.
+Author:
+	John Gedde
+Inputs:
+	char *buf: where to put it
+	size_t bufLen: size of buf
+Outputs:
+	int: length of the report
+-----------------------------------------------------------------------------*/
+int latReport(char *buf, size_t bufLen)
+{
+	LatHist_t h;
+	int len;
+	size_t pos=0;
+
+	len=snprintf(buf, bufLen, "stage count p50_us p99_us max_us\n");
+	if (len>0 && (size_t)len<bufLen)
+		pos=len;
+
+	for (int i=0; i<LAT_MAX; ++i)
+	{
+		latGetHist(i, &h);
+		len=snprintf(buf+pos, bufLen-pos, "%s %u %llu %llu %llu\n",
+			stageNames[i], h.count,
+			(unsigned long long)latPercentile(&h, 50),
+			(unsigned long long)latPercentile(&h, 99),
+			(unsigned long long)h.max_us);
+		if (len<0 || (size_t)len>=bufLen-pos)
+			break;
+		pos+=len;
+	}
+	return pos;
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  latency.h
+*
+*  Synopsis:	Header file for latency.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _LATENCY
+#define _LATENCY
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Histogram buckets.  Each power of 2 (in us) is split into 4 buckets so
+// percentiles are good to within about 20%.  Tops out around 2 minutes.
+#define LAT_SUB_BUCKETS		4
+#define LAT_NUM_BUCKETS		(LAT_SUB_BUCKETS*26)
+
+// Stages a status change goes through on its way to the LCD
+typedef enum
+{
+	LAT_CMD_TO_STATUS=0,	// command port read -> status bits updated
+	LAT_STATUS_TO_QUEUE,	// status bits updated -> backlight change queued
+	LAT_QUEUE_TO_WRITE,		// queued -> backlight write (coalesce/dwell)
+	LAT_BL_WRITE,			// setBacklightColor() incl. waiting for the lock
+	LAT_LINE_WRITE,			// lcdWriteLn() incl. waiting for the lock
+	LAT_END_TO_END,			// command port read -> backlight written
+	LAT_MAX
+} LatStage_t;
+
+typedef struct
+{
+	uint32_t count;
+	uint64_t max_us;
+	uint32_t buckets[LAT_NUM_BUCKETS];
+} LatHist_t;
+
+void 		latRecord(LatStage_t stage, uint64_t us);
+void 		latGetHist(LatStage_t stage, LatHist_t *pHist);
+uint64_t 	latPercentile(const LatHist_t *pHist, uint16_t pct);
+const char 	*latStageName(LatStage_t stage);
+const char 	*latStageShortName(LatStage_t stage);
+void 		latFormatUs(char *buf, uint64_t us);
+int 		latReport(char *buf, size_t bufLen);
+
+#endif
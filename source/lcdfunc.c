@@ -29,20 +29,33 @@
 *    Date    |      Eng     |               Description
 *  ----------+--------------+------------------------------------------------
 *  03/12/23  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Count i2c transactions per call and time
+*            |              |  waits/holds on lcdLock for each thread
+*  10/19/26  | John Gedde   |  Probe for the LCD directly instead of
+*            |              |  running i2cdump
+*  10/19/26  | John Gedde   |  lcdWriteAt() for updating part of a line
+*  10/19/26  | John Gedde   |  Bar graph characters
+*  10/19/26  | John Gedde   |  Spark line characters, loaded over the bar
+*            |              |  graph ones when needed
 *  
 ****************************************************************************/
 
 #include "lcdfunc.h"
 #include "ini.h"
 #include "clockfunc.h"
+#include "latency.h"
+#include "main.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <wiringPi.h>
 #include <mcp23017.h>
 #include <lcd.h>
-#include <iniparser.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
 
 // Global lcd handle:
 int lcdHandle;
@@ -51,6 +64,147 @@ int lcdHandle;
 pthread_mutex_t lcdLock = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutexattr_t mutex_attr;
 
+// i2c transactions per operation with the wiringPi mcp23017 and lcd
+// drivers.  Every digitalWrite()/digitalRead() on an expander pin is one
+// register write/read.  One byte to the LCD in 4 bit mode is RS plus two
+// nibbles of 4 data pins and an E strobe (high, low) = 13 writes.
+#define I2C_WR_PER_LCD_BYTE	13
+// lcdWriteLn: position + 16 chars + the driver repositioning after the
+// 16th char wraps the cursor
+#define LCD_BYTES_PER_LINE	18
+// lcdClear: clear + home
+#define LCD_BYTES_PER_CLEAR	2
+// Bits on the wire: write reg = S + 3 bytes + P, read reg = S + 2 bytes +
+// Sr + 2 bytes + P (9 bits per byte with the ack)
+#define I2C_BITS_PER_WR		29
+#define I2C_BITS_PER_RD		39
+
+// Bus transaction and lock counters.  Both threads update these so
+// they're atomic.
+static LcdApiStats_t apiStats[LCDAPI_MAX];
+static LcdLockStats_t lockStats[LCD_ROLE_MAX];
+static uint64_t statsStart_us;
+
+// Which thread this is and when it took lcdLock
+static __thread LcdRole_t threadRole=LCD_ROLE_UI;
+static __thread uint64_t lockTaken_us;
+
+static const char *apiNames[LCDAPI_MAX]=
+{
+	"writeln",
+	"writeat",
+	"backlight",
+	"buttons",
+	"clear",
+	"other"
+};
+
+// Short names for the LCD
+static const char *apiShortNames[LCDAPI_MAX]=
+{
+	"Line",
+	"Fld",
+	"BkLt",
+	"Btns",
+	"Clr",
+	"Othr"
+};
+
+static const char *roleNames[LCD_ROLE_MAX]=
+{
+	"ui",
+	"backlight"
+};
+
+static const char *roleShortNames[LCD_ROLE_MAX]=
+{
+	"UI",
+	"BkLt"
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	countIo   
+Synopsis:
+	Counts one call to a public LCD function and the i2c transactions
+	it made
+Author:
+	John Gedde
+Inputs:
+	LcdApi_t api: which function
+	uint32_t writes: i2c register writes
+	uint32_t reads: i2c register reads
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void countIo(LcdApi_t api, uint32_t writes, uint32_t reads)
+{
+	__atomic_fetch_add(&apiStats[api].calls, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&apiStats[api].i2cWrites, writes, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&apiStats[api].i2cReads, reads, __ATOMIC_RELAXED);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	atomicMax   
+Synopsis:
+	Raises *p to val if val is bigger
+Author:
+	John Gedde
+Inputs:
+	uint64_t *p: value to raise
+	uint64_t val: new value
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void atomicMax(uint64_t *p, uint64_t val)
+{
+	uint64_t old=__atomic_load_n(p, __ATOMIC_RELAXED);
+	
+	while (val>old &&
+		!__atomic_compare_exchange_n(p, &old, val, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	takeLcdLock / giveLcdLock   
+Synopsis:
+	pthread_mutex_lock/unlock on lcdLock that also time how long this
+	thread waited for the lock and how long it held it.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool (takeLcdLock): TRUE if we got the lock
+-----------------------------------------------------------------------------*/
+static bool takeLcdLock()
+{
+	LcdLockStats_t *ls=&lockStats[threadRole];
+	uint64_t start_us=getClock_us();
+	
+	if (pthread_mutex_lock(&lcdLock)!=0)
+		return FALSE;
+	
+	lockTaken_us=getClock_us();
+	__atomic_fetch_add(&ls->locks, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&ls->wait_us, lockTaken_us-start_us, __ATOMIC_RELAXED);
+	atomicMax(&ls->maxWait_us, lockTaken_us-start_us);
+	return TRUE;
+}
+
+static void giveLcdLock()
+{
+	LcdLockStats_t *ls=&lockStats[threadRole];
+	uint64_t held_us=getClock_us()-lockTaken_us;
+	
+	pthread_mutex_unlock(&lcdLock);
+	
+	__atomic_fetch_add(&ls->hold_us, held_us, __ATOMIC_RELAXED);
+	atomicMax(&ls->maxHold_us, held_us);
+}
+
 // Custom character: degree sign
 static uint8_t degreeSign[8] = 
 {
@@ -64,6 +218,62 @@ static uint8_t degreeSign[8] =
   0b00000,
 };
 
+// Custom characters: bar graph, 1 to 5 columns filled in
+static uint8_t barChars[LCD_BAR_STEPS][8] = 
+{
+  { 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b10000, 0b00000 },
+  { 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b11000, 0b00000 },
+  { 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b11100, 0b00000 },
+  { 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b11110, 0b00000 },
+  { 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b00000 },
+};
+
+// Custom characters: spark line, 1, 3, 4, 6 and 7 rows filled in from the
+// bottom.  Same slots as the bar graph.
+static uint8_t sparkChars[LCD_SPARK_STEPS][8] = 
+{
+  { 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b11111, 0b00000 },
+  { 0b00000, 0b00000, 0b00000, 0b00000, 0b11111, 0b11111, 0b11111, 0b00000 },
+  { 0b00000, 0b00000, 0b00000, 0b11111, 0b11111, 0b11111, 0b11111, 0b00000 },
+  { 0b00000, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b00000 },
+  { 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b11111, 0b00000 },
+};
+
+// Which set is in the shared slots
+static uint8_t (*loadedChars)[8]=barChars;
+
+/*-----------------------------------------------------------------------------
+Function:
+	lcdPresent   
+Synopsis:
+	Checks the LCD's port expander answers on the i2c bus.  One read of
+	one byte - no need to fork i2cdump and dump all 256 registers.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool: TRUE if it's there
+-----------------------------------------------------------------------------*/
+static bool lcdPresent()
+{
+	int fd;
+	uint8_t val;
+	bool present;
+	
+	fd=open(LCD_I2C_DEV, O_RDWR);
+	if (fd<0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not open %s\n", LCD_I2C_DEV);
+		return FALSE;
+	}
+	
+	present=(ioctl(fd, I2C_SLAVE, LCD_I2C_ADDR)>=0 && read(fd, &val, 1)==1);
+	close(fd);
+	
+	return present;
+}
+
 /*-----------------------------------------------------------------------------
 Function:
 	initLCD   
@@ -78,30 +288,12 @@ Outputs:
 -----------------------------------------------------------------------------*/
 int16_t initLCD()
 {
-	FILE *fp;
-	char buf[100];	
-	
 	// Check to see if LCD is there
-	sprintf(buf, "i2cdump -y 1 0x%02x b > /tmp/lcdtempfile", LCD_I2C_ADDR);
-	system(buf);
-	fp=fopen("/tmp/lcdtempfile", "r");
-	if (fp)
+	if (!lcdPresent())
 	{
-		while(!feof(fp))
-		{
-			fgets(buf, sizeof(buf)-1, fp);
-			if (strchr(buf, 'X'))
-			{
-				fprintf(stderr, "aslLCD Error: LCD not present!\n");
-				return -1;
-			}
-		}
-	}
-	else
-	{
-		fprintf(stderr, "aslLCD Error: Could not open temp file\n");
+		fprintf(stderr, "aslLCD Error: LCD not present!\n");
 		return -1;
-	}	
+	}
 	
 	// Initialize wonderful wiringPi 
 	// (using wiringpi library by Gordon Henderson)
@@ -109,12 +301,17 @@ int16_t initLCD()
 	wiringPiSetupSys();
 	
 	mcp23017Setup(AF_BASE, LCD_I2C_ADDR);
+	
+	statsStart_us=getClock_us();
 		
 	// Setup LCD with initial backlight color from conf file
-	adafruitLCDSetup(iniparser_getint(ini, "backlight:color_default", BLC_WHITE));  
+	adafruitLCDSetup(conf->blPatterns[BLS_IDLE].color);  
 	
 	//Add custom characters
-	lcdCharDef(lcdHandle, 2, degreeSign);
+	lcdCharDef(lcdHandle, LCD_CHAR_DEGREE, degreeSign);
+	for (uint8_t i=0; i<LCD_BAR_STEPS; ++i)
+		lcdCharDef(lcdHandle, LCD_CHAR_BAR1+i, barChars[i]);
+	loadedChars=barChars;
 	
 	pthread_mutexattr_init(&mutex_attr);
     pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
@@ -143,15 +340,32 @@ Outputs:
 -----------------------------------------------------------------------------*/
 void setBacklightColor(BlColors_t color)
 {
+	// Last value written to each backlight pin (-1=unknown) so we only
+	// spend i2c writes on the pins that actually change
+	static int pinState[3]={ -1, -1, -1 };
+	static const int pins[3]={ AF_RED, AF_GREEN, AF_BLUE };
+	int val;
+	uint32_t writes=0;
+	uint64_t start_us=getClock_us();
+	
 	color &= 7;
 	
-	if (pthread_mutex_lock(&lcdLock)==0)
+	if (takeLcdLock())
 	{		
-		digitalWrite (AF_RED,   !(color & 1));
-		digitalWrite (AF_GREEN, !(color & 2));
-		digitalWrite (AF_BLUE,  !(color & 4));
-		pthread_mutex_unlock(&lcdLock);
+		for (int i=0; i<3; ++i)
+		{
+			val=!(color & (1<<i));
+			if (val!=pinState[i])
+			{
+				digitalWrite(pins[i], val);
+				pinState[i]=val;
+				writes++;
+			}
+		}
+		giveLcdLock();
 	}
+	countIo(LCDAPI_BACKLIGHT, writes, 0);
+	latRecord(LAT_BL_WRITE, getClock_us()-start_us);
 }
 
 /*-----------------------------------------------------------------------------
@@ -216,7 +430,7 @@ uint16_t readButtons()
 {
 	int retval=0;
 
-	if (pthread_mutex_lock(&lcdLock)==0)
+	if (takeLcdLock())
 	{	
 		if (digitalRead(AF_SELECT)==BTN_PRESSED)
 			retval|=BTN_SELECT;
@@ -228,7 +442,8 @@ uint16_t readButtons()
 			retval|=BTN_UP;
 		if (digitalRead(AF_DOWN)==BTN_PRESSED)
 			retval|=BTN_DOWN;
-		pthread_mutex_unlock(&lcdLock);
+		giveLcdLock();
+		countIo(LCDAPI_BUTTONS, 0, 5);
 	}
 	
 	return retval;
@@ -327,8 +542,9 @@ void lcdWriteLn(const char *str, LcdLine_t line, bool center)
 {
 	char temp[17];
 	char lcdBuf[17];	
+	uint64_t start_us=getClock_us();
 	
-	if (pthread_mutex_lock(&lcdLock)==0)
+	if (takeLcdLock())
 	{	
 		if (str && strlen(str)<=16)
 		{
@@ -345,9 +561,48 @@ void lcdWriteLn(const char *str, LcdLine_t line, bool center)
 			else
 				lcdPosition(lcdHandle, 0, 1);
 			lcdPuts(lcdHandle, lcdBuf);
+			countIo(LCDAPI_WRITELN, LCD_BYTES_PER_LINE*I2C_WR_PER_LCD_BYTE, 0);
 		}
-		pthread_mutex_unlock(&lcdLock);
+		giveLcdLock();
+	}
+	latRecord(LAT_LINE_WRITE, getClock_us()-start_us);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	lcdWriteAt   
+Synopsis:
+	Writes len chars of str starting at column col, leaving the rest of the
+	line alone.  For redrawing just the part of a line that changed.
+	Anything past the end of the line is cut off.
+Author:
+	John Gedde
+Inputs:
+	LcdLine_t line: which line
+	uint8_t col: starting column (0-15)
+	const char *str: the chars to write (at least len of them)
+	uint8_t len: how many
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void lcdWriteAt(LcdLine_t line, uint8_t col, const char *str, uint8_t len)
+{
+	uint64_t start_us=getClock_us();
+	
+	if (col>=16 || len==0)
+		return;
+	if (col+len>16)
+		len=16-col;
+	
+	if (takeLcdLock())
+	{
+		lcdPosition(lcdHandle, col, line);
+		for (uint8_t i=0; i<len; ++i)
+			lcdPutchar(lcdHandle, str[i]);
+		countIo(LCDAPI_WRITEAT, (1+len)*I2C_WR_PER_LCD_BYTE, 0);
+		giveLcdLock();
 	}
+	latRecord(LAT_LINE_WRITE, getClock_us()-start_us);
 }
 
 /*-----------------------------------------------------------------------------
@@ -370,6 +625,117 @@ void centerText(const char *intext, char* outtext, uint16_t fieldWidth)
     sprintf(outtext, "%*s%s%*s", padlen, "", intext, padlen, "");
 } 
 
+/*-----------------------------------------------------------------------------
+Function:
+	loadChars   
+Synopsis:
+	Puts a set of characters in the bar graph slots if they aren't there
+	already.  Anything on the screen using those slots changes with them.
+Author:
+	John Gedde
+Inputs:
+	uint8_t (*chars)[8]: barChars or sparkChars
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void loadChars(uint8_t (*chars)[8])
+{
+	if (chars==loadedChars)
+		return;
+	
+	if (takeLcdLock())
+	{
+		for (uint8_t i=0; i<LCD_BAR_STEPS; ++i)
+			lcdCharDef(lcdHandle, LCD_CHAR_BAR1+i, chars[i]);
+		loadedChars=chars;
+		giveLcdLock();
+		countIo(LCDAPI_OTHER, LCD_BAR_STEPS*9*I2C_WR_PER_LCD_BYTE, 0);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	lcdBarText   
+Synopsis:
+	Makes a bar graph out of the bar characters, five steps per character,
+	padded with spaces to the full width.
+Author:
+	John Gedde
+Inputs:
+	char *outtext: where to put it, cells+1 long
+	uint8_t cells: width of the bar in characters
+	uint16_t val: how much to fill in, 0..max
+	uint16_t max: a full bar
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void lcdBarText(char *outtext, uint8_t cells, uint16_t val, uint16_t max)
+{
+	uint32_t steps=0;
+	
+	loadChars(barChars);
+	if (max>0)
+		steps=((uint32_t)(val<max ? val : max)*cells*LCD_BAR_STEPS+max/2)/max;
+	
+	for (uint8_t i=0; i<cells; ++i)
+	{
+		if (steps>=LCD_BAR_STEPS)
+		{
+			outtext[i]=LCD_CHAR_BAR1+LCD_BAR_STEPS-1;
+			steps-=LCD_BAR_STEPS;
+		}
+		else if (steps>0)
+		{
+			outtext[i]=LCD_CHAR_BAR1+steps-1;
+			steps=0;
+		}
+		else
+			outtext[i]=' ';
+	}
+	outtext[cells]='\0';
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	lcdSparkText   
+Synopsis:
+	Makes a spark line out of the spark line characters, one value per
+	character scaled from lo (one row) to hi (seven rows).
+Author:
+	John Gedde
+Inputs:
+	char *outtext: where to put it, cells+1 long
+	const int16_t *vals: one value per character, LCD_SPARK_NONE for a blank
+	uint8_t cells: number of values
+	int16_t lo: value shown as the lowest step
+	int16_t hi: value shown as the highest step
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void lcdSparkText(char *outtext, const int16_t *vals, uint8_t cells, int16_t lo, int16_t hi)
+{
+	int32_t step;
+	int32_t span=(hi>lo) ? (int32_t)hi-lo : 1;
+	
+	loadChars(sparkChars);
+	for (uint8_t i=0; i<cells; ++i)
+	{
+		if (vals[i]==LCD_SPARK_NONE)
+		{
+			outtext[i]=' ';
+			continue;
+		}
+		
+		step=(((int32_t)vals[i]-lo)*(LCD_SPARK_STEPS-1)+span/2)/span;
+		if (step<0)
+			step=0;
+		else if (step>=LCD_SPARK_STEPS)
+			step=LCD_SPARK_STEPS-1;
+		outtext[i]=LCD_CHAR_BAR1+step;
+	}
+	outtext[cells]='\0';
+}
+
 /*-----------------------------------------------------------------------------    
 Function:
 	lcdClearScreen   
@@ -384,10 +750,11 @@ Outputs:
 -----------------------------------------------------------------------------*/
 void lcdClearScreen()
 {
-	if (pthread_mutex_lock(&lcdLock)==0)
+	if (takeLcdLock())
 	{	
 		lcdClear(lcdHandle);
-		pthread_mutex_unlock(&lcdLock);
+		giveLcdLock();
+		countIo(LCDAPI_CLEAR, LCD_BYTES_PER_CLEAR*I2C_WR_PER_LCD_BYTE, 0);
 	}
 }
 
@@ -427,7 +794,12 @@ Outputs:
 void lcdCursorEnable(bool en)
 {
 	//lcdCursor(lcdHandle, en);
-	lcdCursorBlink(lcdHandle, en);
+	if (takeLcdLock())
+	{
+		lcdCursorBlink(lcdHandle, en);
+		giveLcdLock();
+		countIo(LCDAPI_OTHER, I2C_WR_PER_LCD_BYTE, 0);
+	}
 }
 
 /*-----------------------------------------------------------------------------    
@@ -445,7 +817,12 @@ Outputs:
 -----------------------------------------------------------------------------*/
 void lcdPositionCursor(LcdLine_t line, uint8_t pos)
 {
-	lcdPosition(lcdHandle, pos, line);
+	if (takeLcdLock())
+	{
+		lcdPosition(lcdHandle, pos, line);
+		giveLcdLock();
+		countIo(LCDAPI_OTHER, I2C_WR_PER_LCD_BYTE, 0);
+	}
 }
 
 /*-----------------------------------------------------------------------------    
@@ -462,5 +839,163 @@ Outputs:
 -----------------------------------------------------------------------------*/
 void lcdChar(char c)
 {
-	lcdPutchar(lcdHandle, c);
+	if (takeLcdLock())
+	{
+		lcdPutchar(lcdHandle, c);
+		giveLcdLock();
+		countIo(LCDAPI_OTHER, I2C_WR_PER_LCD_BYTE, 0);
+	}
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	lcdSetThreadRole   
+Synopsis:
+	Tells the stats which thread is calling.  Threads are UI unless they
+	say otherwise.
+Author:
+	John Gedde
+Inputs:
+	LcdRole_t role: role of the calling thread
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void lcdSetThreadRole(LcdRole_t role)
+{
+	if (role<LCD_ROLE_MAX)
+		threadRole=role;
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	lcdGetStats   
+Synopsis:
+	Takes a copy of the bus and lock counters.  Bus busy time is worked 
+	out from the transaction counts and the bus speed.
+Author:
+	John Gedde
+Inputs:
+	LcdStats_t *pStats: where to put them
+Outputs:
+	LcdStats_t *pStats: the copy
+-----------------------------------------------------------------------------*/
+void lcdGetStats(LcdStats_t *pStats)
+{
+	uint64_t bits=0;
+	
+	pStats->elapsed_us=getClock_us()-statsStart_us;
+	
+	for (int i=0; i<LCDAPI_MAX; ++i)
+	{
+		pStats->api[i].calls=__atomic_load_n(&apiStats[i].calls, __ATOMIC_RELAXED);
+		pStats->api[i].i2cWrites=__atomic_load_n(&apiStats[i].i2cWrites, __ATOMIC_RELAXED);
+		pStats->api[i].i2cReads=__atomic_load_n(&apiStats[i].i2cReads, __ATOMIC_RELAXED);
+		bits+=pStats->api[i].i2cWrites*I2C_BITS_PER_WR + pStats->api[i].i2cReads*I2C_BITS_PER_RD;
+	}
+	pStats->busBusy_us=bits*1000/conf->i2cBusKHz;
+	
+	for (int i=0; i<LCD_ROLE_MAX; ++i)
+	{
+		pStats->lock[i].locks=__atomic_load_n(&lockStats[i].locks, __ATOMIC_RELAXED);
+		pStats->lock[i].wait_us=__atomic_load_n(&lockStats[i].wait_us, __ATOMIC_RELAXED);
+		pStats->lock[i].hold_us=__atomic_load_n(&lockStats[i].hold_us, __ATOMIC_RELAXED);
+		pStats->lock[i].maxWait_us=__atomic_load_n(&lockStats[i].maxWait_us, __ATOMIC_RELAXED);
+		pStats->lock[i].maxHold_us=__atomic_load_n(&lockStats[i].maxHold_us, __ATOMIC_RELAXED);
+	}
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	lcdApiName / lcdApiShortName / lcdRoleName / lcdRoleShortName
+Synopsis:
+	Names for reports and for the LCD (4 chars max)
+Author:
+	John Gedde
+Inputs:
+	LcdApi_t api / LcdRole_t role
+Outputs:
+	const char *: the name
+-----------------------------------------------------------------------------*/
+const char *lcdApiName(LcdApi_t api)
+{
+	return (api<LCDAPI_MAX) ? apiNames[api] : "";
+}
+
+const char *lcdApiShortName(LcdApi_t api)
+{
+	return (api<LCDAPI_MAX) ? apiShortNames[api] : "";
+}
+
+const char *lcdRoleName(LcdRole_t role)
+{
+	return (role<LCD_ROLE_MAX) ? roleNames[role] : "";
+}
+
+const char *lcdRoleShortName(LcdRole_t role)
+{
+	return (role<LCD_ROLE_MAX) ? roleShortNames[role] : "";
+}
+
+/*-----------------------------------------------------------------------------    
+Function:
+	lcdStatsReport   
+Synopsis:
+	Text report of the bus and lock counters for the command port.  Totals
+	since startup with per second averages, bus busy percentage, and lock
+	wait/hold time for each thread.
+Author:
+	John Gedde
+Inputs:
+	char *buf: where to put it
+	size_t bufLen: size of buf
+Outputs:
+	int: length of the report
+-----------------------------------------------------------------------------*/
+int lcdStatsReport(char *buf, size_t bufLen)
+{
+	LcdStats_t st;
+	double secs;
+	int len;
+	size_t pos=0;
+	
+	lcdGetStats(&st);
+	secs=st.elapsed_us/1000000.0;
+	if (secs<0.001)
+		secs=0.001;
+	
+#define STATS_OUT(...) \
+	do { \
+		len=snprintf(buf+pos, bufLen-pos, __VA_ARGS__); \
+		if (len<0 || (size_t)len>=bufLen-pos) \
+			return pos; \
+		pos+=len; \
+	} while (0)
+	
+	STATS_OUT("uptime_s %.1f i2c_khz %u bus_busy_pct %.1f\n",
+		secs, conf->i2cBusKHz, st.busBusy_us/10000.0/secs);
+	
+	STATS_OUT("api calls i2c_wr i2c_rd calls_per_s wr_per_s rd_per_s\n");
+	for (int i=0; i<LCDAPI_MAX; ++i)
+	{
+		STATS_OUT("%s %llu %llu %llu %.1f %.1f %.1f\n", apiNames[i],
+			(unsigned long long)st.api[i].calls,
+			(unsigned long long)st.api[i].i2cWrites,
+			(unsigned long long)st.api[i].i2cReads,
+			st.api[i].calls/secs, st.api[i].i2cWrites/secs, st.api[i].i2cReads/secs);
+	}
+	
+	STATS_OUT("thread locks wait_us hold_us max_wait_us max_hold_us busy_pct\n");
+	for (int i=0; i<LCD_ROLE_MAX; ++i)
+	{
+		STATS_OUT("%s %llu %llu %llu %llu %llu %.1f\n", roleNames[i],
+			(unsigned long long)st.lock[i].locks,
+			(unsigned long long)st.lock[i].wait_us,
+			(unsigned long long)st.lock[i].hold_us,
+			(unsigned long long)st.lock[i].maxWait_us,
+			(unsigned long long)st.lock[i].maxHold_us,
+			st.lock[i].hold_us/10000.0/secs);
+	}
+#undef STATS_OUT
+	
+	return pos;
 }
\ No newline at end of file
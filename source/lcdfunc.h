@@ -28,6 +28,8 @@
 *    Date    |      Eng     |               Description
 *  ----------+--------------+------------------------------------------------
 *  03/12/23  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Bar graph characters
+*  10/19/26  | John Gedde   |  Spark line characters
 *  
 ****************************************************************************/ 
 
@@ -36,6 +38,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // LCD Color codes
 typedef enum
@@ -71,7 +74,18 @@ typedef enum
 #define	AF_UP		(AF_BASE +  3)
 #define	AF_LEFT		(AF_BASE +  4)
 
+// Custom characters.  0 can't go in a string so it isn't used.
+#define LCD_CHAR_DEGREE		'\x02'
+#define LCD_CHAR_BAR1		'\x03'		// 1 to 5 columns filled in
+#define LCD_BAR_STEPS		5			// columns in a character
+
+// The spark line characters share the bar characters' slots.  Whichever
+// of lcdBarText()/lcdSparkText() was called last has its set loaded.
+#define LCD_SPARK_STEPS		5			// heights in a character
+#define LCD_SPARK_NONE		INT16_MIN	// no value: blank cell
+
 #define LCD_I2C_ADDR	0x20
+#define LCD_I2C_DEV		"/dev/i2c-1"
 
 // Defines for button press state
 #define BTN_PRESSED			LOW
@@ -101,7 +115,52 @@ typedef enum
 	LCD_LINE2
 } LcdLine_t;
 
+// Public calls we count i2c traffic for
+typedef enum
+{
+	LCDAPI_WRITELN=0,
+	LCDAPI_WRITEAT,
+	LCDAPI_BACKLIGHT,
+	LCDAPI_BUTTONS,
+	LCDAPI_CLEAR,
+	LCDAPI_OTHER,		// cursor, position, single chars
+	LCDAPI_MAX
+} LcdApi_t;
+
+// Which thread is using the LCD
+typedef enum
+{
+	LCD_ROLE_UI=0,
+	LCD_ROLE_BACKLIGHT,
+	LCD_ROLE_MAX
+} LcdRole_t;
+
+typedef struct
+{
+	uint64_t calls;
+	uint64_t i2cWrites;
+	uint64_t i2cReads;
+} LcdApiStats_t;
+
+typedef struct
+{
+	uint64_t locks;
+	uint64_t wait_us;
+	uint64_t hold_us;
+	uint64_t maxWait_us;
+	uint64_t maxHold_us;
+} LcdLockStats_t;
+
+typedef struct
+{
+	uint64_t elapsed_us;		// since initLCD()
+	uint64_t busBusy_us;		// estimated time the i2c bus was busy
+	LcdApiStats_t api[LCDAPI_MAX];
+	LcdLockStats_t lock[LCD_ROLE_MAX];
+} LcdStats_t;
+
 void lcdWriteLn(const char *str, LcdLine_t line, bool center);
+void lcdWriteAt(LcdLine_t line, uint8_t col, const char *str, uint8_t len);
 void setBacklightColor(BlColors_t color);
 void adafruitLCDSetup(BlColors_t color);
 BtnStatus_t waitForButton(uint16_t timeout, BtnStatus_t buttonsEnabled, BtnTrigger_t trigMode);
@@ -109,10 +168,19 @@ int16_t initLCD();
 uint16_t readButtons();
 uint16_t readButtons_edge();
 void centerText(const char *intext, char* outtext, uint16_t fieldWidth);
+void lcdBarText(char *outtext, uint8_t cells, uint16_t val, uint16_t max);
+void lcdSparkText(char *outtext, const int16_t *vals, uint8_t cells, int16_t lo, int16_t hi);
 void lcdClearScreen();
 void lcdShutdown();
 void lcdCursorEnable(bool en);
 void lcdPositionCursor(LcdLine_t line, uint8_t pos);
 void lcdChar(char c);
+void lcdSetThreadRole(LcdRole_t role);
+void lcdGetStats(LcdStats_t *pStats);
+const char *lcdApiName(LcdApi_t api);
+const char *lcdApiShortName(LcdApi_t api);
+const char *lcdRoleName(LcdRole_t role);
+const char *lcdRoleShortName(LcdRole_t role);
+int lcdStatsReport(char *buf, size_t bufLen);
 
 #endif
\ No newline at end of file
@@ -34,6 +34,52 @@
 *  04/19/23  | John Gedde   |   1) If a 'friendly name' is available
 *								for a node we're connected to, show that
 *                               in the disconnect menu
+*  10/19/26  | John Gedde   |   Backlight blink/pulse/alternate patterns per
+*            |              |   status.  Add TX timeout and asterisk down.
+*  10/19/26  | John Gedde   |   SUB on the command port pushes status changes.
+*  10/19/26  | John Gedde   |   Publish status in shared memory (statusshm.h)
+*  10/19/26  | John Gedde   |   Latency histograms: LAT command and hidden
+*            |              |   diagnostics screen (RIGHT on version screen)
+*  10/19/26  | John Gedde   |   STATS command and diagnostics pages for i2c
+*            |              |   traffic and LCD lock contention
+*  10/19/26  | John Gedde   |   Settings and display text come from conf
+*            |              |   (read once at startup) instead of looking
+*            |              |   up the conf file on every screen
+*  10/19/26  | John Gedde   |   Pick up conf file changes without a restart
+*  10/19/26  | John Gedde   |   Staged startup: splash first, then wait for
+*            |              |   asterisk and local nodes in the background
+*  10/19/26  | John Gedde   |   Notice asterisk restarting, show it and
+*            |              |   pick the local nodes up again
+*  10/19/26  | John Gedde   |   Screens run from one event loop (ui.c)
+*            |              |   instead of each waiting on the buttons
+*  10/19/26  | John Gedde   |   Menus come from the tree in the conf file
+*            |              |   (ini.c) instead of a fixed main menu
+*  10/19/26  | John Gedde   |   Idle dashboard (dash.c) after the buttons
+*            |              |   have been left alone for a while
+*  10/19/26  | John Gedde   |   Prefetch links, local nodes and the wifi scan
+*            |              |   (prefetch.c) while the cursor rests on a menu item
+*  10/19/26  | John Gedde   |   Connect/disconnect run on a worker (astcmd.c)
+*            |              |   with a progress screen and link confirmation
+*  10/19/26  | John Gedde   |   Scripts run in the background (scriptrun.c)
+*            |              |   with their output on the LCD
+*  10/19/26  | John Gedde   |   Built in time/IP announcements (say.c)
+*  10/19/26  | John Gedde   |   Scripts from the scripts.d catalog, with
+*            |              |   categories as submenus
+*  10/19/26  | John Gedde   |   Wifi scan over nl80211 (nlwifi.c) in the
+*            |              |   background, strongest network first
+*  10/19/26  | John Gedde   |   Join wifi through wpa_supplicant's control
+*            |              |   socket (wpactrl.c); reboot only if that fails
+*  10/19/26  | John Gedde   |   Live wifi link meter in place of iwconfig
+*            |              |   for show current connection
+*  10/19/26  | John Gedde   |   Node numbers and wifi passwords use the
+*            |              |   text entry widget (textentry.c)
+*  10/19/26  | John Gedde   |   Recent nodes (recent.c) in the connect menu
+*            |              |   and suggested while entering a node number
+*  10/19/26  | John Gedde   |   Find a node by callsign in astdb.txt
+*            |              |   (astdb.c)
+*  10/19/26  | John Gedde   |   CPU temperature from sysfs (cputemp.c) with
+*            |              |   min/max and a spark line; overheat shows on
+*            |              |   the backlight.  No more vcgencmd.
 *  
 ****************************************************************************/
 
@@ -48,11 +94,13 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/sysinfo.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <ifaddrs.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <poll.h>
 #include <wiringPi.h>
 #include <ctype.h>
 #include <stdint.h>
@@ -62,25 +110,73 @@
 #include "lcdfunc.h" 
 #include "getIP.h"
 #include "clockfunc.h"
+#include "backlight.h"
+#include "statuspub.h"
+#include "statusshm.h"
+#include "latency.h"
+#include "astwatch.h"
+#include "ui.h"
+#include "dash.h"
+#include "prefetch.h"
+#include "astcmd.h"
+#include "scriptrun.h"
+#include "say.h"
+#include "nlwifi.h"
+#include "textentry.h"
+#include "recent.h"
+#include "astdb.h"
+#include "cputemp.h"
+#include "wpactrl.h"
 
 #define MAX_LOCALNODES_IDX 	9
 #define MAX_FAVORITES_IDX 	19
-#define MAX_SCRIPT_IDX		9
 
 #define MAX_NODENUM 		99999999
 #define MAX_NODNUM_WIDTH 	8
 
-#define MAX_WIFI_COUNT		10
+#define MAX_WIFI_COUNT		24
 #define MAX_WIFI_NAME_LEN	96
 #define MAX_PASSWORD_LEN	64
 
-char strVersion[]="v1.2.0";
+// Longest the backlight thread sleeps between checks
+#define BL_POLL_MS			100
+#define BL_STARTUP_HOLD_MS	1000		// leave the startup color up this long
+#define BL_CMD_WAIT_MS		100			// a client has this long to send its command
+#define BL_MAX_CMD_CLIENTS	8			// waiting to send their command
 
-typedef enum
-{
-	STATE_MAIN_MENU=0,
-	STATE_WAIT_FOR_RETURN
-}States_t;
+// Dashboard refresh
+#define DASH_TICK_MS		1000
+
+// Prefetch - how long the cursor sits on a menu item before its data is
+// fetched, and how long each kind of data is good for
+#define FETCH_DWELL_MS			300
+#define FETCH_LINKS_MS			5000
+#define FETCH_LOCAL_NODES_MS	60000
+
+// Wifi scan progress, and how much of line 2 the name gets next to the
+// signal strength
+#define WIFI_SPIN_MS		250
+#define WIFI_SSID_COLS		11
+#define WIFI_RESULT_MS		3000		// joined message stays up this long
+#define WIFI_METER_MS		250			// link meter sample rate
+#define WIFI_METER_WINDOW	40			// low/avg/high over this many samples
+#define WIFI_METER_FLOOR	(-90)		// dBm for an empty bar
+#define WIFI_METER_CEIL		(-30)		// and a full one
+#define WIFI_METER_CELLS	9
+
+// CPU temperature spark line
+#define CPU_TEMP_CELLS		16			// CT_HISTORY/CPU_TEMP_CELLS readings each
+#define CPU_TEMP_MIN_SPAN	20			// tenths of a degree, top to bottom
+
+// Connect/disconnect progress
+#define LINK_SPIN_MS		250
+#define LINK_RESULT_MS		3000		// result stays up this long
+
+// Script output screen clock
+#define SCRIPT_TICK_MS		1000
+#define SAY_TIMEOUT_MS		30000		// rpt localplay returns right away
+
+char strVersion[]="v1.2.0";
 
 typedef enum
 {
@@ -111,65 +207,267 @@ typedef struct
 	NodeConnection_t Nodes[MAX_NODE_INFO_COUNT];
 }NodeConns_t;	
 
+// Result from a menu closed with LEFT
+#define UI_CANCEL			(-1)
+
+// Diagnostics screen pages
+enum
+{
+	DIAG_PAGE_LAT=0,
+	DIAG_PAGE_BUS=DIAG_PAGE_LAT+LAT_MAX,
+	DIAG_PAGE_API,
+	DIAG_PAGE_LOCK=DIAG_PAGE_API+LCDAPI_MAX,
+	DIAG_PAGE_MAX=DIAG_PAGE_LOCK+LCD_ROLE_MAX
+};
+
+// A heading and conf file strings to pick from
+typedef struct
+{
+	ConfStr_t heading;
+	const ConfStr_t *items;
+	uint16_t count;
+	uint16_t idx;
+	void (*select)(uint16_t idx);		// NULL: close with idx
+}TextMenu_t;
+
+// Heading plus one line that is redrawn when its data changes
+typedef struct
+{
+	ConfStr_t heading;
+	void (*draw)();
+	uint32_t redrawOn;					// UI_DATA_XXX
+}InfoScreen_t;
+
+typedef struct
+{
+	uint32_t nodeNums[MAX_FAVORITES_IDX+MAX_LOCALNODES_IDX+2];
+	char names[MAX_FAVORITES_IDX+MAX_LOCALNODES_IDX+2][17];
+	uint16_t numNodes;
+	uint16_t idx;
+	ConfStr_t emptyMsg;
+}NodeList_t;
+
+typedef struct
+{
+	NodeConns_t conns;
+	uint16_t idx;
+	bool disconnect;
+}ConnList_t;
+
+// Ways to pick a node to connect to
+typedef enum
+{
+	CONNECT_RECENT=0,
+	CONNECT_FAVORITES,
+	CONNECT_FIND,
+	CONNECT_ENTER,
+	CONNECT_MAX
+}ConnectItem_t;
+
+typedef struct
+{
+	ConnectItem_t item;
+	uint32_t nodeNum;					// picked, waiting for connection type
+}Connect_t;
+
+typedef struct
+{
+	uint32_t id;						// from acSubmit(), 0 if it wasn't taken
+	AcKind_t kind;
+	uint32_t nodeNum;
+	uint64_t start;
+	uint16_t spin;
+	bool finished;
+}LinkJob_t;
+
+typedef struct
+{
+	uint32_t id;						// from srRun()
+	uint16_t line;						// output line showing
+	bool follow;						// keep showing the newest line
+}ScriptView_t;
+
+typedef struct
+{
+	char category[CONF_STR_LEN+1];		// "" for the top level
+	uint16_t sel;
+}ScriptList_t;
+
+typedef struct
+{
+	uint16_t page;
+	LcdStats_t lastStats;
+}Diag_t;
+
+typedef struct
+{
+	NwNet_t nets[MAX_WIFI_COUNT];
+	uint16_t numFound;
+	uint16_t idx;
+	char displayName[MAX_WIFI_NAME_LEN+4];
+	bool scrollIt;
+	uint16_t scrollPos;
+	bool scanning;						// waiting for the scan
+	uint64_t scanStart;
+	uint16_t spin;
+	bool joined;						// join finished and shown
+	char pw[MAX_PASSWORD_LEN];
+}WifiList_t;
+
+// Line 2 of the link meter, UP/DOWN steps through them
+typedef enum
+{
+	WM_PAGE_SSID=0,
+	WM_PAGE_WINDOW,
+	WM_PAGE_QUALITY,
+	WM_PAGE_TX,
+	WM_PAGE_MAX
+}WifiMeterPage_t;
+
+typedef struct
+{
+	WifiMeterPage_t page;
+	NwLink_t link;
+	int16_t window[WIFI_METER_WINDOW];	// signal dBm, oldest overwritten
+	uint16_t numSamples;
+	uint16_t next;
+	uint32_t lastRetries;				// retry rate baseline
+	uint64_t retriesAt;
+	uint32_t retryRate;					// per second
+	uint16_t scrollPos;
+	char lines[2][17];					// what's on the LCD now
+}WifiMeter_t;
+
+// Slow data the prefetch thread can get ahead of time
 typedef enum
 {
-	MM_NODE_CONNECT=0,
-	MM_NODE_DISCONNECT,
-	MM_SHOW_CONNECTIONS,
-	MM_SET_ACTIVE_LOCALNODE,
-	MM_SHOW_ACTIVE_LOCALNODE,
-	MM_VIEW_NODE_INFO,
-	MM_SHUTDOWN_NODE,
-	MM_REBOOT_NODE,
-	MM_OTHER_INFO,
-	MM_WIFI_CONNECT,
-	MM_BACKLIGHT_TEST,
-	MM_SCRIPTS,
-	MM_QUIT_LCD,
-	MM_MAX
-}MainMenuItems_t;
+	FETCH_LINKS=0,
+	FETCH_LOCAL_NODES,
+	FETCH_WIFI_SCAN,
+	FETCH_MAX
+}FetchId_t;
+
+typedef struct
+{
+	uint16_t numNodes;
+	uint32_t list[MAX_LOCALNODES_IDX+1];
+}LocalNodes_t;
+
+typedef struct
+{
+	uint16_t numFound;
+	NwNet_t nets[MAX_WIFI_COUNT];		// strongest first
+}WifiScan_t;
+
+// A command port client that hasn't sent its command yet
+typedef struct
+{
+	int32_t fd;
+	uint64_t since;
+}CmdClient_t;
+
+typedef struct
+{
+	uint16_t page;
+	uint64_t pageStart;
+	bool ipStale;
+	DashValues_t vals;
+	DashDrawn_t drawn[2];
+}Dash_t;
 
 // Globals
-static char strConfProblem[]="CONF PROBLEM!";	
 static uint32_t selectedLocalNode=0;
 static bool backlightTest=FALSE;
 static bool blThreadKill=FALSE;
 pthread_t backlightColorStatusThread;
+static bool startupDone=FALSE;
+static bool doShutdown=FALSE;
+static uint16_t nodeStatus=0;			// status bits from the backlight thread
 
 // Local prototypes
-static float 				readCPUtemp();
-static void 				displayCPUtemp();
-static void 				displayIPaddr();
-static void 				displayClock();
-static void 				displayStartup();
-static void 				displayMainMenu(uint8_t menu_num);
-static void 				blColorTest();
+static void 				drawStartup();
+static void 				*startupThreadFn(void *p);
+static void 				menuDraw(uint16_t menu);
+static void 				menuSelect(uint16_t item);
+static void 				menuPrefetch(uint16_t item, bool children);
 static void 				*backlightColorStatusThreadFn(void *p);
-static void 				nodeConnectSubmenu();
-static uint32_t		 		selectFavoriteNode();
-static uint32_t		 		enterNodeNum();
-static void 				displayActiveLocalNode();
-static uint32_t 			selectNodeFromList(uint32_t* list, char names[][17], uint16_t numEntries);
-static AstConnectTypes_t 	selectConnectionType();
-static void 				displayOtherInfo();
 static void 				getNodeConnections(NodeConns_t *pNodeConns);
-static void 				showNumConnections();
-static void 				showUpTime();
-static void 				displayVersion();
+static bool 				readNodeConnections(uint32_t localNode, NodeConns_t *pNodeConns);
+static int 					astLinked(uint32_t localNode, uint32_t nodeNum);
+static void 				astCmdDone(uint32_t id);
+static void 				startLinkJob(const AcRequest_t *pReq);
+static void 				scriptChanged(uint32_t id);
 static uint16_t				getLocalNodes(uint32_t *list);
+static bool 				fetchLinks(void *buf);
+static bool 				fetchLocalNodes(void *buf);
+static bool 				fetchWifiScan(void *buf);
+static void 				fetchDone(int id);
+static void 				wifiJoinChanged();
 static uint32_t		 		initLocalNodeSel();
+static bool 				astResync();
 static void 				shutdownNode();
-static void 				scriptsSubmenu();
-static void 				nodeDisconnect();
-static void 				showWifiConnection();
-static void 				selectWifi();
-static char 				*strremove(char *str, const char *sub);
-static bool 				getWifiPassword(char *pw);
-static void 				displayPassword(uint16_t pos, char* pw);
-static uint16_t 			findCharIndex(const char *str, char c);
 static void 				rebootHandler();
-static void 				postConnectReboot();
 static void 				displaySelectedNode(uint16_t connIdx, NodeConns_t *nodeConns);
+static void 				drawIPaddr();
+static void 				drawActiveLocalNode();
+static void 				drawNumConnections();
+static void 				drawVersion();
+static void 				runScript(uint16_t idx);
+static void 				runSay(SayWhat_t what, const char *name);
+static void 				startScript(const char *name, const char *cmd, uint32_t timeout_ms);
+static void 				rebootSelect(uint16_t idx);
+static void 				uiPoll();
+
+// Screens
+static const UiScreen_t 	waitKeyScreen, textMenuScreen, nodeListScreen, infoScreen;
+static const UiScreen_t 	cpuTempScreen, clockScreen, upTimeScreen, blTestScreen;
+static const UiScreen_t 	diagScreen, connListScreen, connectScreen;
+static const UiScreen_t 	scriptsScreen, wifiMeterScreen, wifiSelectScreen, wifiJoinScreen;
+static const UiScreen_t 	menuScreen, dashScreen, linkJobScreen;
+static const UiScreen_t 	scriptViewScreen;
+
+// Menus
+static const ConfStr_t connTypeItems[CONF_NUM_CONN_TYPES]=
+{
+	STR_CONN_TYPE_0, STR_CONN_TYPE_0+1, STR_CONN_TYPE_0+2, STR_CONN_TYPE_0+3
+};
+static const ConfStr_t yesNoItems[]=
+{
+	STR_MSG_YES, STR_MSG_NO
+};
+
+static TextMenu_t connTypeMenu={ STR_MENU_CONNECTION_MODE, connTypeItems, CONF_NUM_CONN_TYPES, 0, NULL };
+static TextMenu_t rebootMenu={ STR_WIFI_REBOOT, yesNoItems, 2, 0, rebootSelect };
+
+static InfoScreen_t ipInfo={ STR_HDG_IP_ADDR, drawIPaddr, UI_DATA_NET };
+static InfoScreen_t activeNodeInfo={ STR_HDG_ACTIVE_LOCAL_NODE, drawActiveLocalNode, UI_DATA_NODE };
+static InfoScreen_t numConnsInfo={ STR_HDG_NUMBER_OF_CONNS, drawNumConnections, UI_DATA_LINKS };
+static InfoScreen_t versionInfo={ STR_HDG_VERSION, drawVersion, 0 };
+
+// Prefetch sources, indexed by FetchId_t
+static const PfSource_t pfSources[FETCH_MAX]=
+{
+	{ "links", fetchLinks, sizeof(NodeConns_t), FETCH_LINKS_MS },
+	{ "local nodes", fetchLocalNodes, sizeof(LocalNodes_t), FETCH_LOCAL_NODES_MS },
+	{ "wifi scan", fetchWifiScan, sizeof(WifiScan_t), 0 }		// conf->wifiScanCache_s
+};
+
+// Screen state
+static uint16_t menuSel[MENU_MAX_NODES];			// item showing in each menu
+static NodeList_t nodeList;
+static ConnList_t connList;
+static TextEntry_t textEntry;			// node number or wifi password
+static Connect_t nodeConnect;
+static LinkJob_t linkJob;
+static ScriptView_t scriptView;
+static Diag_t diag;
+static WifiList_t wifiList;
+static WifiMeter_t wifiMeter;
+static BlColors_t blTestColor;
+static bool clock24Hr;
+static bool cpuTempF;
+static ScriptList_t scriptLists[2];		// top level, one category
+static Dash_t dash;
 
 /*-----------------------------------------------------------------------------
 Function:
@@ -178,7 +476,12 @@ Synopsis:
 	Thread to control backlight color.   Checks network connection status,
 	COS and PTT states and control coor according to settings in asLCD.conf.
 	PTT and COS stat is picked up from commands sent to use over a socket port
-	(i.e. c, C, p and P)
+	(i.e. c, C, p and P).  T and t set/clear TX timeout.  Blink and alternate
+	patterns are timed here too; the thread sleeps until the next pattern 
+	change, network check or incoming command.  A client that sends SUB
+	stays connected and gets every status change pushed to it.  LAT gets
+	a latency report back, STATS gets i2c bus and LCD lock counters,
+	the prefetch hit rates and the backlight state change counters.
 Author:
 	John Gedde
 Inputs:
@@ -188,40 +491,43 @@ Outputs:
 -----------------------------------------------------------------------------*/
 static void *backlightColorStatusThreadFn(void *p)
 {
-	
-#define PTT_UP 			1
-#define COS_UP 			2
-#define NETWORK_UP 		4
-#define FORCE_UPDATE	8
-	
-	int32_t server_fd, listenSocket;
+	int32_t server_fd, listenSocket=-1;
     struct sockaddr_in address;
     int32_t opt = 1;
     int32_t addrlen = sizeof(address);
-    char buffer[6] = { 0 };  
+    char buffer[32] = { 0 };  
+	int32_t nRead;
 	int32_t portnum;
 	char IPaddr[17]={ 0 };
+	char lastIPaddr[17]={ 0 };
 	bool lastBacklightTest=FALSE;
 	uint16_t statusBits=0;
-	uint16_t lastStatusBits=0;	
-	uint16_t divisor, loopCount=0;
-	
-	BlColors_t colorNetworkUp, colorIdle, colorPTT, colorCOS, colorPTTCOS;
+	uint16_t lastPubBits=0;
+	uint32_t lastPubNode=0;
+	uint32_t confGen;
+	uint64_t now, nextNetCheck=0, blDeadline, deadline;
+	int32_t timeout;
+	struct pollfd pfds[1+BL_MAX_CMD_CLIENTS+MAX_SUBSCRIBERS];
+	int numPfds;
+	CmdClient_t cmdClients[BL_MAX_CMD_CLIENTS];
+	int numCmdClients=0;
+	uint16_t lastBits;
+	uint64_t event_us=0, cmd_us;
+	char reply[1536];
+	int replyLen;
+	uint64_t holdUntil;
 
-	// Just a delay so user can see the backlight color change from their default to
-	// whatever it needs to be based on the status
-	delay(1000);
+	// Leave the startup color up for a bit so the user can see it change to
+	// whatever it needs to be based on the status.  The command port and
+	// network check get going right away though.
+	holdUntil=getClock_ms()+BL_STARTUP_HOLD_MS;
 
-	colorNetworkUp=iniparser_getint(ini, "backlight:color_network_up", BLC_BLUE);
-	colorIdle=iniparser_getint(ini, "backlight:color_default", BLC_WHITE);
-	colorCOS=iniparser_getint(ini, "backlight:color_COS", BLC_GREEN);
-	colorPTT=iniparser_getint(ini, "backlight:color_PTT", BLC_RED);
-	colorPTTCOS=iniparser_getint(ini, "backlight:color_PTTCOS", BLC_VIOLET);
-	
-	divisor=iniparser_getint(ini, "network check:divisor", 10);
+	lcdSetThreadRole(LCD_ROLE_BACKLIGHT);
+	blLoadConf();
+	confGen=conf->generation;
 	
 	// Get port number from conf file
-	portnum=iniparser_getint(ini, "backlight:backlight_cmd_port", 0);
+	portnum=conf->backlightCmdPort;
 	if (portnum==0)
 	{
 		fprintf(stderr, "aslLCD Error: Backlight control couldn't read portnum from ini file\n");
@@ -265,22 +571,110 @@ static void *backlightColorStatusThreadFn(void *p)
 	
 	while(!blThreadKill)
 	{
+		now=getClock_ms();
+		
+		// Conf file changed - new colors/effects take effect right away
+		if (conf->generation!=confGen)
+		{
+			confGen=conf->generation;
+			blLoadConf();
+			blForceUpdate();
+		}
+		
 		// Check to see if we have an IP address.  That implies we have a network.
-		if ((loopCount++ % divisor)==0)
+		// Check asterisk is still there while we're at it.
+		if (now>=nextNetCheck)
 		{
+			lastBits=statusBits;
 			getIPaddress(IPaddr);
 			if (strlen(IPaddr)==0)
 				statusBits &= ~NETWORK_UP;
 			else
 				statusBits |= NETWORK_UP;
+			if (strcmp(IPaddr, lastIPaddr)!=0)
+			{
+				shmPublishIP(IPaddr);
+				strcpy(lastIPaddr, IPaddr);
+				uiNotify(UI_DATA_NET);
+			}
+			
+			if (statusBits!=lastBits)
+				event_us=getClock_us();
+			
+			nextNetCheck=now+(uint64_t)conf->netCheckDivisor*BL_POLL_MS;
+		}
+		
+		// Asterisk watch and CPU temperature threads keep these up to date,
+		// so check every time
+		lastBits=statusBits;
+		if (astIsUp())
+			statusBits &= ~ASTERISK_DOWN;
+		else
+			statusBits |= ASTERISK_DOWN;
+		if (ctOverheat())
+			statusBits |= CPU_OVERHEAT;
+		else
+			statusBits &= ~CPU_OVERHEAT;
+		if (statusBits!=lastBits)
+			event_us=getClock_us();
+		
+		// accept connections.  Nobody is waited for here - a client that
+		// hasn't sent its command yet is polled along with everything else
+		// and dropped if nothing comes in BL_CMD_WAIT_MS.
+		while ((listenSocket = accept(	server_fd, 
+										(struct sockaddr*)&address,
+										(socklen_t*)&addrlen)) >= 0) 
+		{
+			if (numCmdClients>=BL_MAX_CMD_CLIENTS)
+			{
+				close(listenSocket);
+				continue;
+			}
+			fcntl(listenSocket, F_SETFL, fcntl(listenSocket, F_GETFL) | O_NONBLOCK);
+			cmdClients[numCmdClients].fd=listenSocket;
+			cmdClients[numCmdClients].since=now;
+			numCmdClients++;
 		}
+		listenSocket=-1;
 		
-		// accept a connection
-		if ((listenSocket = accept(	server_fd, 
-									(struct sockaddr*)&address,
-									(socklen_t*)&addrlen)) >= 0) 
+		// Commands from the clients that have sent one (or run out of time)
+		for (int i=0; i<numCmdClients; )
 		{
-			read(listenSocket, buffer, sizeof(buffer));
+			listenSocket=cmdClients[i].fd;
+			nRead=recv(listenSocket, buffer, sizeof(buffer)-1, MSG_DONTWAIT);
+			if (nRead<0 && (errno==EAGAIN || errno==EWOULDBLOCK) && 
+				now<cmdClients[i].since+BL_CMD_WAIT_MS)
+			{
+				listenSocket=-1;
+				++i;
+				continue;
+			}
+			cmdClients[i]=cmdClients[--numCmdClients];
+			buffer[nRead>0 ? nRead : 0]='\0';
+			cmd_us=getClock_us();
+			lastBits=statusBits;
+			
+			// Subscribers keep the connection open for status pushes
+			if (strncmp(buffer, "SUB", 3)==0)
+			{
+				pubAddSubscriber(listenSocket, statusBits, selectedLocalNode);
+				listenSocket=-1;
+				continue;
+			}
+			
+			// Queries get an answer back
+			if (strncmp(buffer, "LAT", 3)==0)
+			{
+				replyLen=latReport(reply, sizeof(reply));
+				send(listenSocket, reply, replyLen, MSG_NOSIGNAL);
+			}
+			else if (strncmp(buffer, "STATS", 5)==0)
+			{
+				replyLen=lcdStatsReport(reply, sizeof(reply));
+				replyLen+=pfReport(reply+replyLen, sizeof(reply)-replyLen);
+				replyLen+=blReport(reply+replyLen, sizeof(reply)-replyLen);
+				send(listenSocket, reply, replyLen, MSG_NOSIGNAL);
+			}
 			
 			close(listenSocket);
 			listenSocket=-1;
@@ -294,43 +688,90 @@ static void *backlightColorStatusThreadFn(void *p)
 				case 'p':
 					statusBits &= ~PTT_UP;
 					break;
+				case 't':
+					statusBits &= ~TX_TIMEOUT;
+					break;
 				case 'C':
 					statusBits |= COS_UP;
 					break;
 				case 'P': 
 					statusBits |= PTT_UP;
 					break;
+				case 'T':
+					statusBits |= TX_TIMEOUT;
+					break;
 				default:
 					break;
-			}						
+			}
+			
+			if (statusBits!=lastBits)
+			{
+				event_us=cmd_us;
+				latRecord(LAT_CMD_TO_STATUS, getClock_us()-cmd_us);
+			}
 		}
 		
-		// Recover from backlight test
-		if (lastBacklightTest==TRUE && backlightTest==FALSE)
-			statusBits |= FORCE_UPDATE;
+		// Push status changes to subscribers
+		if (statusBits!=lastPubBits || selectedLocalNode!=lastPubNode)
+		{
+			pubPublish(statusBits, selectedLocalNode);
+			shmPublishStatus(statusBits, selectedLocalNode);
+			if (statusBits!=lastPubBits)
+			{
+				__atomic_store_n(&nodeStatus, statusBits, __ATOMIC_RELAXED);
+				uiNotify(UI_DATA_STATUS);
+			}
+			lastPubBits=statusBits;
+			lastPubNode=selectedLocalNode;
+		}
 		
-		// Only set backlight color if it needs to change to reduce the number of i2c calls	
 		// Don't change bl color if bl test is running
-		if ((statusBits != lastStatusBits) && !backlightTest)
+		blDeadline=BL_NO_DEADLINE;
+		if (now<holdUntil)
+			blDeadline=holdUntil;
+		else if (!backlightTest)
 		{
-			// Set the BL color - priority if/else
-			if ((statusBits & PTT_UP) && (statusBits & COS_UP))
-				setBacklightColor(colorPTTCOS);
-			else if (statusBits & PTT_UP)
-				setBacklightColor(colorPTT);
-			else if (statusBits & COS_UP)
-				setBacklightColor(colorCOS);
-			else if (statusBits & NETWORK_UP)
-				setBacklightColor(colorNetworkUp);
-			else
-				setBacklightColor(colorIdle);
+			// Recover from backlight test
+			if (lastBacklightTest)
+				blForceUpdate();
+			
+			blSetState(blStateFromStatus(statusBits), now, event_us);
+			blDeadline=blService(now);
 		}
-		lastStatusBits=statusBits;
 		lastBacklightTest = backlightTest;
-				
-		delay(100);	
+		
+		// Sleep until the next thing we have to do or a command comes in.
+		// Never longer than BL_POLL_MS so we notice a backlight test or kill.
+		deadline=now+BL_POLL_MS;
+		if (blDeadline<deadline)
+			deadline=blDeadline;
+		if (nextNetCheck<deadline)
+			deadline=nextNetCheck;
+		for (int i=0; i<numCmdClients; ++i)
+		{
+			if (cmdClients[i].since+BL_CMD_WAIT_MS<deadline)
+				deadline=cmdClients[i].since+BL_CMD_WAIT_MS;
+		}
+		now=getClock_ms();
+		timeout=(deadline>now) ? (int32_t)(deadline-now) : 0;
+		pfds[0].fd=server_fd;
+		pfds[0].events=POLLIN;
+		pfds[0].revents=0;
+		for (int i=0; i<numCmdClients; ++i)
+		{
+			pfds[1+i].fd=cmdClients[i].fd;
+			pfds[1+i].events=POLLIN;
+			pfds[1+i].revents=0;
+		}
+		numPfds=pubPollFds(&pfds[1+numCmdClients], MAX_SUBSCRIBERS);
+		if (poll(pfds, 1+numCmdClients+numPfds, timeout)>0)
+			pubServicePollFds(&pfds[1+numCmdClients], numPfds);
     }
 	
+	pubCloseAll();
+	for (int i=0; i<numCmdClients; ++i)
+		close(cmdClients[i].fd);
+	
 	// close the connected socket
     close(listenSocket);
     // close the listening socket
@@ -340,65 +781,6 @@ static void *backlightColorStatusThreadFn(void *p)
 }
 
 
-/*-----------------------------------------------------------------------------    
-Function:
-	strremove   
-Synopsis:
-	Removes a substring from a string
-Author:
-	stack Overflow member "chqrlie"
-Inputs:
-	char* str: string to remove substring from
-	const char* sub: the substring to remove
-Outputs:
-	float: temperature in degC
------------------------------------------------------------------------------*/
-static char *strremove(char *str, const char *sub)
-{
-    char *p, *q, *r;
-    if (*sub && (q = r = strstr(str, sub)) != NULL)
-	{
-        size_t len = strlen(sub);
-        while ((r = strstr(p = r + len, sub)) != NULL)
-		{
-            memmove(q, p, r - p);
-            q += r - p;
-        }
-        memmove(q, p, strlen(p) + 1);
-    }
-    return str;
-}
-
-/*-----------------------------------------------------------------------------    
-Function:
-	readCPUtemp   
-Synopsis:
-	Reads the CPU temperature in degC using vcgencmd
-Author:
-	John Gedde
-Inputs:
-	None
-Outputs:
-	float: temperature in degC
------------------------------------------------------------------------------*/
-static float readCPUtemp()
-{
-	float fVal=-300.0; 
-	FILE *fp=NULL;
-	
-	system("/opt/vc/bin/vcgencmd measure_temp > /tmp/lcdtempfile");
-	fp=fopen("/tmp/lcdtempfile", "rw");
-	if (fp)
-	{
-		fscanf(fp, "temp=%f", &fVal);
-		fclose(fp);
-	}
-	else
-		fprintf(stderr, "aslLCD Error: Couldn't open lcd temp file\n");
-	
-	return fVal;
-}
-
 /*-----------------------------------------------------------------------------
 Function:
 	getLocalNodes   
@@ -418,15 +800,13 @@ static uint16_t getLocalNodes(uint32_t *list)
 	char buf[80];
 	uint32_t nodeNum;
 	
+	// Read straight from a pipe - the asterisk watch thread calls this too
 	if (list)
 	{
-		system("asterisk -rx \"rpt localnodes\" > /tmp/lcdtempfile");
-		
-		if ((fp=fopen("/tmp/lcdtempfile", "r"))!=NULL)
+		if ((fp=popen("asterisk -rx \"rpt localnodes\"", "r"))!=NULL)
 		{
-			while (!feof(fp))
+			while (fgets(buf, sizeof(buf), fp))
 			{
-				fgets(buf, sizeof(buf)-1, fp);
 				if (isdigit(buf[0]))
 				{
 					sscanf(buf, "%u", &nodeNum);
@@ -434,7 +814,7 @@ static uint16_t getLocalNodes(uint32_t *list)
 						list[idx++]=nodeNum;
 				}
 			}			
-			fclose(fp);
+			pclose(fp);
 		}
 	}
 	return idx;
@@ -442,164 +822,101 @@ static uint16_t getLocalNodes(uint32_t *list)
 
 /*-----------------------------------------------------------------------------
 Function:
-	initLocalNodeSel   
+	startupThreadFn   
 Synopsis:
-	Pulls the first entry for local node in allstarlcd.conf and sets the
-	initialily selected local node.
+	The slow part of startup, run while the splash screen is up.  Waits
+	for asterisk to come up (it may still be starting at boot) and then
+	asks it for the local nodes.
 Author:
 	John Gedde
 Inputs:
-	None
+	void *p: arguments
 Outputs:
-	return uint32_t: first local node in list coming from asterisk
+	return val to caller
 -----------------------------------------------------------------------------*/
-static uint32_t initLocalNodeSel()
+static void *startupThreadFn(void *p)
 {
-	uint32_t list[MAX_LOCALNODES_IDX+1] = { 0 };
+	if (!astCtlPresent())
+	{
+		fprintf(stderr, "aslLCD: Waiting for asterisk\n");
+		astWaitForCtl(AST_WAIT_FOREVER);
+	}
 	
-	getLocalNodes(list);
+	// initialize selected local node
+	selectedLocalNode=initLocalNodeSel();
 	
-	return list[0];		
-}
+	// The backlight thread publishes status if it's running
+	if (conf->statusShm && !conf->statusBacklight)
+		shmPublishStatus(0, selectedLocalNode);
 	
+	__atomic_store_n(&startupDone, TRUE, __ATOMIC_RELEASE);
+	return p;
+}
 
 /*-----------------------------------------------------------------------------
 Function:
-	displayCPUtemp   
+	initLocalNodeSel   
 Synopsis:
-	Displays the CPU temperature with a 1000 ms update rate in degC and degF
+	Pulls the first entry for local node in allstarlcd.conf and sets the
+	initialily selected local node.
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	None
+	return uint32_t: first local node in list coming from asterisk
 -----------------------------------------------------------------------------*/
-static void displayCPUtemp()
+static uint32_t initLocalNodeSel()
 {
-	char buf[17];
-	char lcdBuf[17];
-	float fVal=0.0;
-	const char *s;
-	uint16_t buttons;
+	uint32_t list[MAX_LOCALNODES_IDX+1] = { 0 };
 	
-	lcdClearScreen();
-	s=iniparser_getstring_16(ini, "headings:hdg_cpu_temp", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
+	getLocalNodes(list);
 	
-	for (;;)
-	{
-		fVal=readCPUtemp();
-		
-		if (fVal>-273.15)
-		{
-			sprintf(buf, "%0.01f\2C, %0.01f\2F", fVal, CtoF(fVal));
-			sprintf(lcdBuf, "%-16s", buf);
-			lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);			
-		}
-		
-		buttons=waitForButton(1000, (BTN_LEFT | BTN_SELECT), BTN_TRIG_EDGE);
-
-		if (buttons & BTN_LEFT || buttons & BTN_SELECT)
-			break;
-	}	
+	return list[0];		
 }
 
-
 /*-----------------------------------------------------------------------------
 Function:
-	displayIPaddr   
+	astResync   
 Synopsis:
-	Displays the IP address.  in case of two IP addresses assigned because user
-	connected ethernet and is connected to wifi, wifi takes precidence.
+	Called from the asterisk watch thread when asterisk comes back.  Keeps
+	the selected local node if asterisk still has it, otherwise goes back
+	to the first one.  Links were all dropped by the restart.
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	None
+	return bool: FALSE if asterisk didn't answer yet
 -----------------------------------------------------------------------------*/
-static void displayIPaddr()
+static bool astResync()
 {
-	char lcdBuf[17];
-	const char *ini_str;
-	
-	getIPaddress(lcdBuf);
+	uint32_t list[MAX_LOCALNODES_IDX+1] = { 0 };
+	uint16_t numNodes, i;
 	
-	lcdClearScreen();
-	ini_str=iniparser_getstring_16(ini, "headings:hdg_ip_addr", strConfProblem);
-	lcdWriteLn(ini_str, LCD_LINE1, FALSE);		
-	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);		
+	numNodes=getLocalNodes(list);
+	if (numNodes==0)
+		return FALSE;
 	
-	for(;;)
-	{
-		if (waitForButton(0, BTN_SELECT | BTN_LEFT, BTN_TRIG_EDGE))
+	for (i=0; i<numNodes; ++i)
+		if (list[i]==selectedLocalNode)
 			break;
-	}
+	if (i==numNodes)
+		selectedLocalNode=list[0];
+	
+	shmPublishLinks(NULL, 0);
+	pfInvalidate(FETCH_LOCAL_NODES);
+	pfInvalidate(FETCH_LINKS);
+	uiNotify(UI_DATA_NODE | UI_DATA_LINKS);
+	return TRUE;
 }
-
-/*-----------------------------------------------------------------------------
-Function:
-	displayClock   
-Synopsis:
-	Displays the system clock.  UP/DOWn buttons toggle between 24 and 12 hour
-	clocks.
-Author:
-	John Gedde
-Inputs:
-	None
-Outputs:
-	None
------------------------------------------------------------------------------*/
-void displayClock()
-{
-	char buf[17];	
-	time_t seconds;
-	struct tm *localT;	
-	uint8_t clock24;
-	const char *s;
-	uint16_t buttons;
-		
-	clock24=iniparser_getint(ini, "options:clock24", 0);
-
-	s=iniparser_getstring_16(ini, "headings:hdg_local_time", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
 	
-	for (;;)
-	{
-		seconds=time(NULL);
-
-		localT = localtime(&seconds);
-		
-		if (clock24)
-			sprintf(buf, "%02d:%02d:%02d        ", 
-				localT->tm_hour, localT->tm_min, localT->tm_sec);
-		else
-			sprintf(buf, "%02d:%02d:%02d %s     ", 
-				localT->tm_hour % 12, 
-				localT->tm_min, 
-				localT->tm_sec, 
-				(localT->tm_hour>=12 ? "PM" : "AM"));
-				
-		lcdWriteLn(buf, LCD_LINE2, FALSE);
-					
-		buttons=waitForButton(50, (BTN_ANY), BTN_TRIG_EDGE);
-
-		if (buttons & BTN_LEFT || buttons & BTN_SELECT)
-			break;
 
-		if (buttons & BTN_UP || buttons & BTN_DOWN)
-			clock24 = !clock24;
-	}		
-}
-	
-	
 /*-----------------------------------------------------------------------------
 Function:
-	displayStartup   
+	drawStartup   
 Synopsis:
-	Displays the startup screen on the LCD for a time.
-	Press any key to jump out early.
+	Puts the startup screen on the LCD
 Author:
 	John Gedde
 Inputs:
@@ -607,25 +924,19 @@ Inputs:
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void displayStartup()
+static void drawStartup()
 {
 	const char *s;
-	uint16_t waittime;
 	
 	lcdClearScreen();
 		
 	// Startup screen line 1
-	s=iniparser_getstring_16(ini, "startup:line1", "Your Call");
+	s=confStr(STR_STARTUP_LINE1);
 	lcdWriteLn(s, LCD_LINE1, TRUE);
 		
 	// Startup screen line 2
-	s=iniparser_getstring_16(ini, "startup:line2", "Allstar Node");
+	s=confStr(STR_STARTUP_LINE2);
 	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	waittime=iniparser_getint(ini, "startup:disptime_ms", 3000);
-	
-	// Allow press any button to skip wait
-	waitForButton(waittime, BTN_ANY, BTN_TRIG_EDGE);
 }
 
 #ifdef ENABLE_FUTURE_FEATURE
@@ -645,7 +956,7 @@ static void displayFutureFeature()
 {
 	const char* s;
 	
-	s=iniparser_getstring_16(ini, "messages:msg_future_feature", strConfProblem);
+	s=confStr(STR_MSG_FUTURE_FEATURE);
 	
 	lcdClearScreen();
 	lcdWriteLn(s, LCD_LINE1, TRUE);
@@ -655,861 +966,519 @@ static void displayFutureFeature()
 
 /*-----------------------------------------------------------------------------
 Function:
-	displayMainMenu   
+	displaySelectedNode   
 Synopsis:
-	Displays the main menu.
+	Displays the node number of the selected node on line 2 of the display.
+	It will search the list of favorties for a match.  If it finds a match
+	in the favorites list, it'll then check to see if there's a friendly
+	name associated.  If so, it'll display the frieindly name.
 Author:
 	John Gedde
 Inputs:
-	uint8_t menu_num: menu number to display
+	connIdx: The index of the node in the node list.
+	nodeConns: Pointer to the node list structure
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void displayMainMenu(uint8_t menu_num)
+void displaySelectedNode(uint16_t connIdx, NodeConns_t *nodeConns)
 {
+	char lcdBuf[17];
+	bool foundFriendly=FALSE;
 	const char* s;
-	char temp[17];
-	
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "main menu:main_menu_top", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	sprintf(temp, "main menu:main_menu%d", menu_num);
-	s = iniparser_getstring_16(ini, temp, strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-}
-
+		
+	for (uint16_t i=0; i<CONF_MAX_FAVORITES; ++i)
+	{
+		if (nodeConns->Nodes[connIdx].nodeNum==conf->favorites[i].nodeNum)
+		{
+			// found a match, now check to see if there's a friendly name
+			s=conf->favorites[i].friendlyName;
+			if (s[0])
+			{
+				// Show the friendly name
+				strcpy(lcdBuf, s);
+				lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
+				foundFriendly=TRUE;	
+				break;								
+			}
+		}
+	}		
+	if (!foundFriendly)
+	{
+		// Just shpow the node number
+		sprintf(lcdBuf, "%u", nodeConns->Nodes[connIdx].nodeNum);
+		lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
+	}
+}
+
+	
 /*-----------------------------------------------------------------------------
 Function:
-	blColorTest   
+	getNodeConnections   
 Synopsis:
-	Backlight color test.
+	Retrieves a list of connected nodes, saying so on line 2 if they
+	haven't already been prefetched
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	None
+	NodeConns_t *pNodeConns: NodeConns_t: Num Nodes and list of nodes
 -----------------------------------------------------------------------------*/
-static void blColorTest()
+static void getNodeConnections(NodeConns_t *pNodeConns)
 {
-	BlColors_t blc;
-	const char *s;
-	uint16_t buttons;
-	char key[32];
-	
-	backlightTest=TRUE;
-			
-	s=iniparser_getstring_16(ini, "headings:hdg_bl_test", strConfProblem);
-	lcdClearScreen();
-	lcdWriteLn(s, LCD_LINE1, FALSE);
+	const char* iniStr;
 	
-	blc=iniparser_getint(ini, "backlight:color_default", BLC_WHITE);
-	setBacklightColor(blc);	
-	sprintf(key, "color_names:color%d", blc&7);
-	s=iniparser_getstring_16(ini, key, strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-
-	for (;;)
+	if (!pfReady(FETCH_LINKS))
 	{
-		buttons = waitForButton(1000, (BTN_ANY), BTN_TRIG_EDGE);
-		
-		if (buttons & BTN_UP)
-		{
-			setBacklightColor(++blc);
-			sprintf(key, "color_names:color%d", blc&7);
-			s=iniparser_getstring_16(ini, key, strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		else if (buttons & BTN_DOWN)
-		{
-			setBacklightColor(--blc);
-			sprintf(key, "color_names:color%d", blc&7);
-			s=iniparser_getstring_16(ini, key, strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		else if (buttons & BTN_LEFT || buttons & BTN_SELECT)
-			break;
+		iniStr=confStr(STR_MSG_GETTING_CONNECTIONS);
+		lcdWriteLn(iniStr, LCD_LINE2, TRUE);
 	}
-		
-	blc=iniparser_getint(ini, "backlight:color_default", BLC_WHITE);
-	setBacklightColor(blc);
-	backlightTest=FALSE;
+	
+	if (!pfGet(FETCH_LINKS, pNodeConns))
+		memset(pNodeConns, 0, sizeof(*pNodeConns));
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	selActiveLocalNode   
+	readNodeConnections   
 Synopsis:
-	Functionality to allow user to select the active local node for reading
-	data or for conects and disconnects.
+	Asks asterisk for the list of connected nodes (nothing on the LCD).
+	Reads straight from a pipe so the prefetch and asterisk command
+	threads can call it.
 Author:
 	John Gedde
 Inputs:
-	None
+	uint32_t localNode: whose connections
 Outputs:
-	Glocal variable: selectedLocalNode
+	NodeConns_t *pNodeConns: NodeConns_t: Num Nodes and list of nodes
+	return bool: FALSE if asterisk couldn't be asked
 -----------------------------------------------------------------------------*/
-void selActiveLocalNode()
+static bool readNodeConnections(uint32_t localNode, NodeConns_t *pNodeConns)
 {
-	uint32_t list[MAX_LOCALNODES_IDX+1] = { 0 };
-	uint16_t numNodes;
-	uint16_t buttons;
-	uint16_t idx=0;
-	char lcdBuf[17];
-	const char *s;
-	
-	lcdClearScreen();
-		
-	s=iniparser_getstring_16(ini, "headings:hdg_sel_local_node", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
+	FILE *fp;
+	char *token=NULL;
+	char *save=NULL;
+	uint16_t nodeIdx=0;
+	char buf[128];
+	char *s;
+	AslLcdShmLink_t links[MAX_NODE_INFO_COUNT];
 	
-	s=iniparser_getstring_16(ini, "messages:msg_getting_node_list", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
+	if (!pNodeConns)
+		return FALSE;
 	
-	numNodes=getLocalNodes(list);
+	sprintf(buf, "asterisk -rx \"rpt showvars %u\"", localNode);
+	if ((fp=popen(buf, "r"))==NULL)
+		return FALSE;
 	
-	if (numNodes==0)
-	{
-		selectedLocalNode=0;
-		fprintf(stderr, "aslLCD Warning: No local nodes set-up on device\n");
-	}
-	else
+	while (fgets(buf, sizeof(buf)-1, fp))
 	{
-		sprintf(lcdBuf, "%u", list[0]);
-		lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
-		for (;;)
+		if ((s=strstr(buf, "RPT_ALINKS="))!=NULL)
 		{
-			buttons=waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-			
-			if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
+			token = strtok_r(s, "=", &save);
+			if (token)
 			{
-				if (buttons & BTN_UP)
-				{
-					if (idx<numNodes)
-						idx=0;
-					else idx++;
-				}
-				else if (idx>0)
-					idx--;
-				else idx=numNodes-1;
-				
-				sprintf(lcdBuf, "%u", list[idx]);
-				lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
+				token=strtok_r(NULL, ",", &save);
+				if (token)
+					sscanf(token, "%hu", &pNodeConns->numNodes);
 			}
-			if (buttons & BTN_SELECT)
+		
+			while (token && nodeIdx<MAX_NODE_INFO_COUNT)
 			{
-				selectedLocalNode=list[idx];
-				break;
-			}
-			else if (buttons & BTN_LEFT)
-				break;
+				token = strtok_r(NULL, ",", &save);
+				if (token)
+				{
+					sscanf(token, "%u%9s", &(pNodeConns->Nodes[nodeIdx].nodeNum), &(pNodeConns->Nodes[nodeIdx].connType[0]));
+					nodeIdx++;
+				}
+			}	
 		}
-	}	
+	}
+	pclose(fp);
+	
+	// Let everyone else on the box see them too
+	for (uint16_t i=0; i<nodeIdx; ++i)
+	{
+		links[i].nodeNum=pNodeConns->Nodes[i].nodeNum;
+		strcpy(links[i].connType, pNodeConns->Nodes[i].connType);
+	}
+	shmPublishLinks(links, nodeIdx);
+	return TRUE;
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	displayActiveLocalNode   
+	fetchLinks / fetchLocalNodes / fetchWifiScan
 Synopsis:
-	Displays the currently selected local node.
+	Prefetch fetchers.  Run on the prefetch thread or the UI thread, so
+	they only read from pipes and never touch the LCD.
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	None
+	void *buf: NodeConns_t, LocalNodes_t or WifiScan_t
+	return bool: FALSE if the data couldn't be had
 -----------------------------------------------------------------------------*/
-static void displayActiveLocalNode()
+static bool fetchLinks(void *buf)
 {
-	const char *s;
-	char lcdBuf[17];	
+	memset(buf, 0, sizeof(NodeConns_t));
+	return readNodeConnections(selectedLocalNode, buf);
+}
+
+static bool fetchLocalNodes(void *buf)
+{
+	LocalNodes_t *pNodes=buf;
 	
-	s=iniparser_getstring_16(ini, "headings:hdg_active_local_node", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);	
+	memset(pNodes, 0, sizeof(*pNodes));
+	pNodes->numNodes=getLocalNodes(pNodes->list);
 	
-	sprintf(lcdBuf, "%u", selectedLocalNode);
-	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-}	
+	// No answer from a stopped asterisk isn't worth keeping
+	return pNodes->numNodes || astIsUp();
+}
+
+static bool fetchWifiScan(void *buf)
+{
+	WifiScan_t *pScan=buf;
+	int num;
+
+	memset(pScan, 0, sizeof(*pScan));
+	if ((num=nwScan(conf->wifiIface, pScan->nets, MAX_WIFI_COUNT))<0)
+		return FALSE;
+	pScan->numFound=num;
+	return TRUE;
+}
 
 /*-----------------------------------------------------------------------------
 Function:
-	selectConnectionType   
+	fetchDone
 Synopsis:
-	Allows user to selects the desired node conection type using lcd Menus
+	Called from the prefetch thread when a background fetch finishes, so
+	a screen waiting for it can look
 Author:
 	John Gedde
 Inputs:
-	None	
+	int id: FetchId_t
 Outputs:
-	AstConnectTypes_t: the selected connection type
+	None
 -----------------------------------------------------------------------------*/
-AstConnectTypes_t selectConnectionType()
+static void fetchDone(int id)
 {
-	const char *s;
-	uint16_t choice=0;
-	char buf[32];
-	uint16_t buttons;
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_connection_mode", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_conn_type0", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for(;;)
-	{
-		buttons=waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-		{
-			if (buttons & BTN_UP)
-			{
-				if (choice>=3)
-					choice=0;
-				else
-					choice++;
-			}
-			else if (choice==0)
-				choice=3;
-			else
-				choice--;
-		
-			sprintf(buf, "connect disconnect:menu_conn_type%u", choice);
-			s=iniparser_getstring_16(ini, buf, strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		else if (buttons & BTN_LEFT)
-			return AST_ABORT_CONNECTION;
-		else if (buttons & BTN_SELECT)
-			break;
-	}		
-	
-	return astCmdLookup[choice];
-};
+	(void)id;
+	uiNotify(UI_DATA_FETCH);
+}
 
 /*-----------------------------------------------------------------------------
 Function:
-	nodeConnectSubmenu   
+	astLinked
 Synopsis:
-	Implements the node connection submenu
+	Link list check for the asterisk command thread.  A link asterisk is
+	still setting up (mode C) doesn't count yet.
 Author:
 	John Gedde
 Inputs:
-	None	
+	uint32_t localNode: local node
+	uint32_t nodeNum: node to look for, 0 for any
 Outputs:
-	None
+	int: 1 if linked, 0 if not, -1 if asterisk couldn't be asked
 -----------------------------------------------------------------------------*/
-static void nodeConnectSubmenu()
+static int astLinked(uint32_t localNode, uint32_t nodeNum)
 {
-	const char *s;
-	bool enterMode=FALSE;
-	uint16_t buttons;
-	uint32_t nodeNum=0;
-	char astCmd[64];
-	AstConnectTypes_t connectType;	
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_connect", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_favorites", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for(;;)
+	NodeConns_t conns;
+	uint16_t i;
+
+	memset(&conns, 0, sizeof(conns));
+	if (!astIsUp() || !readNodeConnections(localNode, &conns))
+		return -1;
+
+	for (i=0; i<conns.numNodes && i<MAX_NODE_INFO_COUNT; ++i)
 	{
-		buttons=waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if (buttons & BTN_LEFT)
-			break;
-		
-		if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-		{
-			enterMode=!enterMode;
-			if (enterMode)
-				s=iniparser_getstring_16(ini, "connect disconnect:menu_enter_node_num", strConfProblem);
-			else
-				s=iniparser_getstring_16(ini, "connect disconnect:menu_favorites", strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		
-		if (buttons & BTN_SELECT)
-		{
-			if (enterMode)
-				nodeNum=enterNodeNum();
-			else
-				nodeNum=selectFavoriteNode();
-			
-			if (nodeNum)
-			{
-				s=iniparser_getstring_16(ini, "messages:msg_ok_select_type_line1", strConfProblem);
-				lcdWriteLn(s, LCD_LINE1, TRUE);
-				s=iniparser_getstring_16(ini, "messages:msg_ok_select_type_line2", strConfProblem);
-				lcdWriteLn(s, LCD_LINE2, TRUE);
-				
-				delay(1500);
-			
-				// Select connection type
-				connectType=selectConnectionType();
-				
-				if (connectType!=AST_ABORT_CONNECTION)
-				{
-					// try to connect to node
-					sprintf(astCmd, "asterisk -rx \"rpt cmd %u ilink %d %u\"", selectedLocalNode, connectType, nodeNum);
-					system(astCmd);
-				}
-				break;
-					
-			}
-			else
-				break;
-		}
+		if ((nodeNum==0 || conns.Nodes[i].nodeNum==nodeNum) && conns.Nodes[i].connType[0]!='C')
+			return 1;
 	}
+	return 0;
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	selectNodeFromList   
+	astCmdDone
 Synopsis:
-	Implements the user interfacea for selecing a node from a list
+	Called from the asterisk command thread when a connect or disconnect
+	is over.  The links have (probably) changed.  A confirmed connect goes
+	in the recent nodes whether or not its progress screen is still up.
 Author:
 	John Gedde
 Inputs:
-	uint32_t* list: pointer to the list of node numbers
-	char **: pointer to an array of nodename strings
-	uint16_t: the number of node n umbers in the list	
+	uint32_t id: the request
 Outputs:
-	uint32_t: the selected node number, or 0 if aborted.
+	None
 -----------------------------------------------------------------------------*/
-static uint32_t selectNodeFromList(uint32_t* list, char names[][17], uint16_t numEntries)
+static void astCmdDone(uint32_t id)
 {
-	uint32_t nodeNum=0;
-	unsigned int idx=0;
-	uint16_t buttons;
-	char buf[17];
-	
-	if (list && numEntries!=0)
-	{	
-		for(;;)
-		{
-			buttons=waitForButton(0, BTN_ANY, TRUE);
+	AcStatus_t st;
 
-			if ((buttons & BTN_DOWN) || (buttons & BTN_UP))
-			{
-				if (buttons & BTN_UP)
-				{
-					if (++idx>=numEntries)
-						idx=0;					
-				}
-				else if (idx==0)
-					idx=numEntries-1;
-				else
-					idx--;			
-			
-				if (strlen(names[idx])>0)
-					lcdWriteLn(names[idx], LCD_LINE2, TRUE);
-				else
-				{
-					sprintf(buf, "%u", list[idx]);
-					lcdWriteLn(buf, LCD_LINE2, TRUE);
-				}
-			}				
-			else if (buttons & BTN_SELECT)
-			{
-				nodeNum=list[idx];
-				break;
-			}
-			else if (buttons & BTN_LEFT)
-				break;
-		}
-	}
-	
-	return nodeNum;
+	if (acStatus(id, &st) && st.req.kind==AC_CONNECT && st.state==ACS_DONE)
+		rnRecord(st.req.nodeNum);
+
+	pfInvalidate(FETCH_LINKS);
+	uiNotify(UI_DATA_LINKS);
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	selectFavoriteNode   
+	shutdownNode   
 Synopsis:
-	Reads a list of favorite nodes from aslLCD.conf and allows user to 
-	select one for connection.
+	Implements node shutdown and safe power down
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	return uint32_t: selected node number
+	None
 -----------------------------------------------------------------------------*/
-uint32_t selectFavoriteNode()
+static void shutdownNode()
 {
 	const char* s;
-	uint16_t buttons;
-	uint32_t nodeNum;
-	char buf[32];
-	uint32_t nodeNums[MAX_FAVORITES_IDX+MAX_LOCALNODES_IDX+2]={ 0 };
-	char nodeNames[MAX_FAVORITES_IDX+1][17] = { 0 };
-	int NumNodes=0;
-	uint16_t i;
+	uint16_t waitTime;
+	uint16_t numNodes=0;
 	uint32_t list[MAX_LOCALNODES_IDX+1];
+	char aslCmd[64];
 	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_choose_nodenum", strConfProblem);
-	lcdWriteLn(s, 0, TRUE);
-	
-	// Build list of node numbers in favorites list
-	for (i=0; i<=MAX_FAVORITES_IDX; ++i)
-	{
-		// From favorites
-		sprintf(buf, "favorites:favnode%u", i);
-		nodeNum=iniparser_getint(ini, buf, 0);
-		if (nodeNum!=0 && nodeNum!=selectedLocalNode && nodeNum<MAX_NODENUM)
-		{
-			nodeNums[NumNodes]=nodeNum;
-			NumNodes++;
-			sprintf(buf, "favorites:friendlyName%u", i);
-			s=iniparser_getstring_16(ini, buf, "");
-			strncpy(nodeNames[i], s, 17);
-		}
-	}	
+	lcdClearScreen();
+	s=confStr(STR_MSG_SHUTDOWN);
+	lcdWriteLn(s, LCD_LINE1, FALSE);
 	
-	s=iniparser_getstring_16(ini, "messages:msg_getting_node_list", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
+	s=confStr(STR_MSG_PLEASE_WAIT);
+	lcdWriteLn(s, LCD_LINE2, FALSE);
 	
-	for (i=0; i<getLocalNodes(list); ++i)
-	{
-		if (list[i]!=0 && list[i]!=selectedLocalNode && list[i]<MAX_NODENUM)
-		{
-			nodeNums[NumNodes]=list[i];
-			NumNodes++;
-		}
-	}		
+	numNodes=getLocalNodes(list);
 	
-	if (NumNodes==0)
+	// disconnect everything for all localnodes
+	for (int i=0; i<numNodes; ++i)
 	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_favorites", strConfProblem);
-		lcdWriteLn(s, LCD_LINE2, TRUE);
-		for (;;)
-		{
-			buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-			if (buttons)
-				break;
-		}
-	}
-	else
-	{	
-		if (strlen(nodeNames[0])>0)
-			lcdWriteLn(nodeNames[0], LCD_LINE2, TRUE);
-		else
-		{
-			sprintf(buf, "%u", nodeNums[0]);
-			lcdWriteLn(buf, LCD_LINE2, TRUE);
-		}
-			
-		nodeNum=selectNodeFromList(nodeNums, nodeNames, NumNodes);
+		sprintf(aslCmd, "asterisk -rx \"rpt fun %u *76\"", list[i]);
+		system(aslCmd);
+		delay(1000);
 	}
+	system("asterisk -rx \"stop gracefully\"");
 	
-	return nodeNum;		
+	waitTime=conf->shutdownWait_ms;	
+	delay (waitTime);
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	displayOtherInfo   
+	waitKeyScreen handlers
 Synopsis:
-	Implements the display other info menu
+	Leaves whatever is on the LCD until a button is pressed.  For messages
+	like "No Connections".  ctx is the buttons that close it.
 Author:
 	John Gedde
 Inputs:
-	None
+	void *ctx: BTN_XXX bits
+	const UiEvent_t *ev: event
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void displayOtherInfo()
+static void waitKeyEvent(void *ctx, const UiEvent_t *ev)
 {
-	uint16_t item=0;
-	const char *s;
-	uint16_t buttons;
-	
-	s=iniparser_getstring_16(ini, "other info menu:menu_select_info", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "other info menu:menu_show_clock", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for(;;)
-	{
-		buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-		{
-			if (buttons & BTN_UP)
-			{
-				if (item>=3)
-					item=0;
-				else
-					item++;
-			}
-			else if (item==0)
-				item=3;
-			else
-				item--;
-			
-			switch (item)
-			{
-				case 0:
-					s=iniparser_getstring_16(ini, "other info menu:menu_show_clock", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				case 1:
-					s=iniparser_getstring_16(ini, "other info menu:menu_show_ip", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				case 2:
-					s=iniparser_getstring_16(ini, "other info menu:menu_show_cpu_temp", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				case 3:
-					s=iniparser_getstring_16(ini, "other info menu:menu_aslLCD_version", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				default:
-					item=0;
-					break;
-			}
-		}
-		else if (buttons & BTN_SELECT)
-		{
-			switch (item)
-			{
-				case 0:
-					displayClock();
-					break;
-				case 1:
-					displayIPaddr();
-					break;
-				case 2:
-					displayCPUtemp();
-					break;
-				case 3:
-					displayVersion();
-					break;
-				default:
-					item=0;
-					break;
-			}
-			break;
-		}
-		else if (buttons & BTN_LEFT)
-			break;
-	}	
+	if (ev->type==UI_EV_BUTTON && (ev->buttons & (uint16_t)(uintptr_t)ctx))
+		uiPop(0);
 }
 
+static const UiScreen_t waitKeyScreen=
+{
+	"wait key", NULL, waitKeyEvent, NULL, NULL
+};
+
 /*-----------------------------------------------------------------------------
 Function:
-	displayVersion   
+	waitKey
 Synopsis:
-	Displays the current version of aslLCD
+	Shows a message on line 2 and waits for a button
 Author:
 	John Gedde
 Inputs:
-	None
+	ConfStr_t msg: the message
+	uint16_t buttons: BTN_XXX bits that close it
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void displayVersion()
+static void waitKey(ConfStr_t msg, uint16_t buttons)
 {
-	const char *s;
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_version", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-	lcdWriteLn(strVersion, LCD_LINE2, FALSE);
-	
-	for(;;)
-	{
-		if (waitForButton(0, BTN_SELECT | BTN_LEFT, BTN_TRIG_EDGE))
-			break;
-	}
+	lcdWriteLn(confStr(msg), LCD_LINE2, TRUE);
+	uiPush(&waitKeyScreen, (void *)(uintptr_t)buttons);
 }
 
-
 /*-----------------------------------------------------------------------------
 Function:
-	displaySelectedNode   
+	closeOnLeftSelect
 Synopsis:
-	Displays the node number of the selected node on line 2 of the display.
-	It will search the list of favorties for a match.  If it finds a match
-	in the favorites list, it'll then check to see if there's a friendly
-	name associated.  If so, it'll display the frieindly name.
+	Event handler for screens that only close on LEFT or SELECT
 Author:
 	John Gedde
 Inputs:
-	connIdx: The index of the node in the node list.
-	nodeConns: Pointer to the node list structure
+	void *ctx: not used
+	const UiEvent_t *ev: event
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-void displaySelectedNode(uint16_t connIdx, NodeConns_t *nodeConns)
+static void closeOnLeftSelect(void *ctx, const UiEvent_t *ev)
 {
-	char buf[64];
-	char lcdBuf[17];
-	bool foundFriendly=FALSE;
-	uint32_t nodeRead;
-	const char* s;
-		
-	for (uint16_t i=0; i<MAX_NODE_INFO_COUNT; ++i)
-	{
-		sprintf(buf, "favorites:favnode%u", i);
-		nodeRead=iniparser_getint(ini, buf, 0);
-		if (nodeConns->Nodes[connIdx].nodeNum==nodeRead)
-		{
-			// found a match, now check to see if there's a friendly name
-			sprintf(buf, "favorites:friendlyName%u", i);
-			s=iniparser_getstring_16(ini, buf, "");
-			if (s[0])
-			{
-				// Show the friendly name
-				strcpy(lcdBuf, s);
-				lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
-				foundFriendly=TRUE;	
-				break;								
-			}
-		}
-	}		
-	if (!foundFriendly)
-	{
-		// Just shpow the node number
-		sprintf(lcdBuf, "%u", nodeConns->Nodes[connIdx].nodeNum);
-		lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
-	}
+	(void)ctx;
+	if (ev->type==UI_EV_BUTTON && ((ev->buttons & BTN_LEFT) || (ev->buttons & BTN_SELECT)))
+		uiPop(0);
 }
 
-	
 /*-----------------------------------------------------------------------------
 Function:
-	displayVersion   
+	textMenuScreen handlers
 Synopsis:
-	Retrieves a list of connected nodes and presents a list of nodes that the
-	user can disconnect from.
+	A heading and a list of conf file strings to pick from with UP/DOWN.
+	SELECT calls the menu's select function, or closes the menu with the
+	item number if it hasn't got one.  LEFT closes it with UI_CANCEL.
 Author:
 	John Gedde
 Inputs:
-	None
+	void *ctx: TextMenu_t
+	const UiEvent_t *ev: event
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void nodeDisconnect()
+static void textMenuDraw(TextMenu_t *pMenu)
 {
-	NodeConns_t nodeConns = { 0 };
-	const char *s;
-	uint16_t buttons=0;
-	uint16_t connIdx=0;
-	char astCmd[64];	
-	
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_disconnect", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-		
-	getNodeConnections(&nodeConns);
-	
-	if (nodeConns.numNodes==0)
+	lcdWriteLn(confStr(pMenu->heading), LCD_LINE1, TRUE);
+	lcdWriteLn(confStr(pMenu->items[pMenu->idx]), LCD_LINE2, TRUE);
+}
+
+static void textMenuEnter(void *ctx)
+{
+	TextMenu_t *pMenu=ctx;
+
+	pMenu->idx=0;
+	textMenuDraw(pMenu);
+}
+
+static void textMenuEvent(void *ctx, const UiEvent_t *ev)
+{
+	TextMenu_t *pMenu=ctx;
+
+	if (ev->type==UI_EV_RESULT || (ev->type==UI_EV_DATA && (ev->data & UI_DATA_CONF)))
+		textMenuDraw(pMenu);
+	else if (ev->type!=UI_EV_BUTTON)
+		return;
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
 	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_connections", strConfProblem);
-		lcdWriteLn(s, LCD_LINE2, TRUE);
-		for (;;)
-		{
-			buttons=waitForButton(0, BTN_LEFT | BTN_SELECT, BTN_TRIG_EDGE);
-			if (buttons)
-				break;
-		}
+		pMenu->idx=uiWrap(pMenu->idx, pMenu->count, ev->buttons);
+		lcdWriteLn(confStr(pMenu->items[pMenu->idx]), LCD_LINE2, TRUE);
 	}
-	else		
+	else if (ev->buttons & BTN_SELECT)
 	{
-		displaySelectedNode(connIdx, &nodeConns);
-		for (;;)
-		{
-			if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-			{	
-				if (buttons & BTN_UP)
-				{
-					if (connIdx>=nodeConns.numNodes)
-						connIdx=0;
-					else
-						connIdx++;
-				}
-				else if (connIdx==0)
-					connIdx=nodeConns.numNodes;
-				else
-					connIdx--;	
-				
-				// When connIdx equals the number of nodes (i.e. 1 index higher than we have nodes in the list)
-				// present user with a 'disconnect all' option.
-				if (connIdx==nodeConns.numNodes)
-				{
-					s=iniparser_getstring_16(ini, "connect disconnect:menu_disconnect_all", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-				}
-				else
-				{
-					displaySelectedNode(connIdx, &nodeConns);
-				}
-			}
-			else if (buttons & BTN_SELECT)
-			{
-				if (connIdx==nodeConns.numNodes)
-					// Disconnect all from selected local node
-					sprintf(astCmd, "asterisk -rx \"rpt fun %u *76\"", selectedLocalNode);
-				else
-					// Disconnect selected node.
-					sprintf(astCmd, "asterisk -rx \"rpt cmd %u ilink 11 %u\"", 
-								selectedLocalNode, 
-								nodeConns.Nodes[connIdx].nodeNum);
-						
-				system(astCmd);
-				break;
-			}
-			else if (buttons & BTN_LEFT)
-				break;
-		
-			buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		}		
+		if (pMenu->select)
+			pMenu->select(pMenu->idx);
+		else
+			uiPop(pMenu->idx);
 	}
+	else if (ev->buttons & BTN_LEFT)
+		uiPop(UI_CANCEL);
 }
 
+static const UiScreen_t textMenuScreen=
+{
+	"text menu", textMenuEnter, textMenuEvent, NULL, NULL
+};
+
 /*-----------------------------------------------------------------------------
 Function:
-	getNodeConnections   
+	nodeListScreen handlers
 Synopsis:
-	Retrieves a list of connected nodes
+	Implements the user interface for selecting a node from a list.  Shows
+	the friendly name if there is one, otherwise the node number.  Closes
+	with the node number selected, or 0 if aborted.
 Author:
 	John Gedde
 Inputs:
-	None
+	void *ctx: NodeList_t
+	const UiEvent_t *ev: event
 Outputs:
-	NodeConns_t *pNodeConns: NodeConns_t: Num Nodes and list of nodes
+	None
 -----------------------------------------------------------------------------*/
-static void getNodeConnections(NodeConns_t *pNodeConns)
+static void nodeListDraw(NodeList_t *pList)
 {
-	FILE *fp;
-	char *token=NULL;
-	uint16_t nodeIdx=0;
-	char buf[128];
-	char *s;
-	const char* iniStr;
-	
-	iniStr=iniparser_getstring_16(ini, "messages:msg_getting_connections", strConfProblem);
-	lcdWriteLn(iniStr, LCD_LINE2, TRUE);
-	
-	if (pNodeConns)
+	char buf[17];
+
+	if (strlen(pList->names[pList->idx])>0)
+		lcdWriteLn(pList->names[pList->idx], LCD_LINE2, TRUE);
+	else
 	{
-		sprintf(buf, "asterisk -rx \"rpt showvars %u\" > /tmp/lcdtempfile", selectedLocalNode);
-		system(buf);
-		
-		if ((fp=fopen("/tmp/lcdtempfile", "r"))!=NULL)
-		{
-			while(!feof(fp))
-			{
-				fgets(buf, sizeof(buf)-1, fp);
-				if ((s=strstr(buf, "RPT_ALINKS="))!=NULL)
-				{
-					token = strtok(s, "=");
-					if (token)
-					{
-						token=strtok(NULL, ",");
-						if (token)
-							sscanf(token, "%u", (unsigned int*)&pNodeConns->numNodes);
-					}
-				
-					while (token && nodeIdx<MAX_NODE_INFO_COUNT)
-					{
-						token = strtok(NULL, ",");
-						if (token)
-						{
-							sscanf(token, "%u%s", &(pNodeConns->Nodes[nodeIdx].nodeNum), &(pNodeConns->Nodes[nodeIdx].connType[0]));
-							nodeIdx++;
-						}
-					}	
-				}
-			}
-			fclose(fp);
-		}
+		sprintf(buf, "%u", pList->nodeNums[pList->idx]);
+		lcdWriteLn(buf, LCD_LINE2, TRUE);
+	}
+}
+
+static void nodeListEnter(void *ctx)
+{
+	NodeList_t *pList=ctx;
+
+	pList->idx=0;
+	if (pList->numNodes==0)
+		waitKey(pList->emptyMsg, BTN_ANY);
+	else
+		nodeListDraw(pList);
+}
+
+static void nodeListEvent(void *ctx, const UiEvent_t *ev)
+{
+	NodeList_t *pList=ctx;
+
+	// Back from the empty list message
+	if (ev->type==UI_EV_RESULT)
+		uiPop(0);
+	else if (ev->type!=UI_EV_BUTTON)
+		return;
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pList->idx=uiWrap(pList->idx, pList->numNodes, ev->buttons);
+		nodeListDraw(pList);
 	}
+	else if (ev->buttons & BTN_SELECT)
+		uiPop(pList->nodeNums[pList->idx]);
+	else if (ev->buttons & BTN_LEFT)
+		uiPop(0);
 }
 
+static const UiScreen_t nodeListScreen=
+{
+	"node list", nodeListEnter, nodeListEvent, NULL, NULL
+};
 
 /*-----------------------------------------------------------------------------
 Function:
-	getNodeConnections   
+	favoriteName
 Synopsis:
-	Implements show connected nodes fucntion
+	The friendly name of a node from the favorites in aslLCD.conf
 Author:
 	John Gedde
 Inputs:
-	None
+	uint32_t nodeNum: the node
 Outputs:
-	None
+	const char *: its name, "" if it hasn't got one
 -----------------------------------------------------------------------------*/
-static void showConnections()
+static const char *favoriteName(uint32_t nodeNum)
 {
-	NodeConns_t nodeConns = { 0 };
-	const char *s;
-	uint16_t buttons;
-	uint16_t connIdx=0;
-		
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_connections", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "messages:msg_getting_connections", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	getNodeConnections(&nodeConns);
-	
-	if (nodeConns.numNodes==0)
-	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_connections", strConfProblem);
-		lcdWriteLn(s, LCD_LINE2, TRUE);
-		for (;;)
-		{
-			buttons=waitForButton(0, BTN_LEFT | BTN_SELECT, BTN_TRIG_EDGE);
-			if (buttons)
-				break;
-		}
-	}
-	else
+	for (uint16_t i=0; i<CONF_MAX_FAVORITES; ++i)
 	{
-		displaySelectedNode(connIdx, &nodeConns);
-		
-		for (;;)
-		{
-			buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-			
-			if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-			{				
-				if (buttons & BTN_UP)
-				{
-					if (connIdx>=nodeConns.numNodes-1)
-						connIdx=0;
-					else
-						connIdx++;
-				}
-				else if (connIdx==0)
-					connIdx=nodeConns.numNodes-1;
-				else
-					connIdx--;	
-				
-				displaySelectedNode(connIdx, &nodeConns);
-			}
-			else if ((buttons & BTN_SELECT) || (buttons & BTN_LEFT))
-				break;
-		}		
+		if (conf->favorites[i].nodeNum==nodeNum && conf->favorites[i].friendlyName[0])
+			return conf->favorites[i].friendlyName;
 	}
-}	
+	return "";
+}
 
 /*-----------------------------------------------------------------------------
 Function:
-	showNumConnections   
+	openRecent
 Synopsis:
-	Implements show number of connected nodes fucntion
+	Opens the list of nodes connected to before, the ones used most and
+	most lately first, so the usual node is one SELECT away
 Author:
 	John Gedde
 Inputs:
@@ -1517,487 +1486,1977 @@ Inputs:
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void showNumConnections()
+static void openRecent()
 {
-	NodeConns_t nodeConns = { 0 };
-	const char *s;
-	char lcdBuf[17];
-	
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_number_of_conns", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-	
-	getNodeConnections(&nodeConns);
-	
-	sprintf(lcdBuf, "%u", nodeConns.numNodes);
-	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-	
-	for (;;)
+	NodeList_t *pList=&nodeList;
+	uint32_t nodes[RN_MAX_NODES];
+	uint16_t num;
+
+	memset(pList, 0, sizeof(*pList));
+	pList->emptyMsg=STR_MSG_NO_RECENT;
+
+	lcdWriteLn(confStr(STR_MENU_CHOOSE_NODENUM), LCD_LINE1, TRUE);
+
+	num=rnRanked(nodes, sizeof(nodes)/sizeof(nodes[0]));
+	for (uint16_t i=0; i<num && pList->numNodes<sizeof(pList->nodeNums)/sizeof(pList->nodeNums[0]); ++i)
 	{
-		if (waitForButton(0, (BTN_SELECT | BTN_LEFT), BTN_TRIG_EDGE))
-			break;
+		if (nodes[i]==selectedLocalNode || nodes[i]>=MAX_NODENUM)
+			continue;
+		strcpy(pList->names[pList->numNodes], favoriteName(nodes[i]));
+		pList->nodeNums[pList->numNodes]=nodes[i];
+		pList->numNodes++;
 	}
+
+	uiPush(&nodeListScreen, pList);
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	showUpTime   
+	suggestNode
 Synopsis:
-	Implements show node up time function
+	Suggests a node number from the recent list while one is being
+	entered
 Author:
 	John Gedde
 Inputs:
-	None
+	const char *typed: digits so far
+	char *pText: where to put the node number
+	char *pHint: where to put line 1, 16 chars
 Outputs:
-	None
+	bool: TRUE if there's one
 -----------------------------------------------------------------------------*/
-static void showUpTime()
+static bool suggestNode(const char *typed, char *pText, char *pHint)
 {
-	const char *s;
-	FILE *fp;
-	char strUptime[80];
-	char *token;
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_up_time", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-	
-	for (;;)
-	{
-		system("/bin/uptime > /tmp/lcdtempfile");
-		
-		fp=fopen("/tmp/lcdtempfile", "r");
-		
-		if (fp)
-		{
-			fgets(strUptime, sizeof(strUptime)-1, fp);
-			token = strstr(strUptime, "up");
-			if (token)
-			{
-				token=strtok(token, ",");
-				if (token)
-					lcdWriteLn(token, LCD_LINE2, FALSE);
-			}			
-		}
-		else
-			break;
-	
-		if (waitForButton(200, BTN_LEFT | BTN_SELECT, BTN_TRIG_EDGE))
-			break;
-	}		
+	uint32_t nodeNum=rnComplete(typed);
+
+	if (nodeNum==0)
+		return FALSE;
+	sprintf(pText, "%u", nodeNum);
+	snprintf(pHint, CONF_STR_LEN+1, "%s>%s", pText, favoriteName(nodeNum));
+	return TRUE;
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	nodeInfoSubmenu   
+	allowCallsign / suggestCallsign
 Synopsis:
-	Implements node info submenu
+	Callsign search in the node database.  UP/DOWN only offer characters
+	that some callsign has next, and nothing but blanks after a blank.
+	Line 1 shows how many nodes match so far and the first of them, and
+	RIGHT fills in as much as they all have in common.
 Author:
 	John Gedde
 Inputs:
-	None
+	const char *before: callsign up to the cursor
+	char c: character that might come next
+	const char *typed: callsign so far
+	char *pText: where to put the common part
+	char *pHint: where to put line 1, 16 chars
 Outputs:
-	None
+	bool: TRUE if c can come next / there's a hint
 -----------------------------------------------------------------------------*/
-static void nodeInfoSubmenu()
+static bool allowCallsign(const char *before, char c)
 {
-	const char *s;
-	uint16_t buttons;
-	uint16_t item=0;
-	
-	lcdClearScreen();
-	s=iniparser_getstring_16(ini, "node info menu:menu_select_info", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "node info menu:menu_num_conns", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for(;;)
+	char prefix[DB_CALL_LEN+2];
+	uint32_t first;
+
+	if (strchr(before, ' '))
+		return FALSE;
+	snprintf(prefix, sizeof(prefix), "%s%c", before, c);
+	return dbFind(prefix, &first)>0;
+}
+
+static bool suggestCallsign(const char *typed, char *pText, char *pHint)
+{
+	uint32_t first, count=dbFind(typed, &first);
+	const DbNode_t *pNode;
+	char lcdBuf[40];
+
+	if (count==0)
 	{
-		buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-		{
-			if (buttons & BTN_UP)
-			{
-				if (item>=1)
-					item=0;
-				else
-					item++;
-			}
-			else if (item==0)
-				item=1;
-			else
-				item--;
-			
-			switch (item)
-			{
-				case 0:
-					s=iniparser_getstring_16(ini, "node info menu:menu_num_conns", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				case 1:
-					s=iniparser_getstring_16(ini, "node info menu:menu_up_time", strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-					break;
-				default:
-					item=0;
-					break;
-			}
-		}
-		else if (buttons & BTN_SELECT)
-		{
-			switch (item)
-			{
-				case 0:
-					showNumConnections();
-					break;
-				case 1:
-					showUpTime();
-					break;
-				default:
-					item=0;
-					break;
-			}
-			break;
-		}
-		else if (buttons & BTN_LEFT)
-			break;
+		strcpy(pHint, confStr(STR_MSG_NO_MATCHES));
+		return TRUE;
 	}
-}
 
+	pNode=dbGet(first);
+	memcpy(pText, pNode->call, dbCommon(first, count));
+	pText[dbCommon(first, count)]='\0';
+	snprintf(lcdBuf, sizeof(lcdBuf), "%u %s %u", count, pNode->call, pNode->nodeNum);
+	lcdBuf[16]='\0';
+	strcpy(pHint, lcdBuf);
+	return TRUE;
+}
 
 /*-----------------------------------------------------------------------------
 Function:
-	shutdownNode   
+	openCallsignMatches
 Synopsis:
-	Implements node shutdown and safe power down
+	After a callsign is entered: one node goes straight on, more are put
+	up in a list (the first ones, if there are lots)
 Author:
 	John Gedde
 Inputs:
-	None
+	const char *call: callsign or the start of one
 Outputs:
-	None
+	uint32_t: the node if there was only one, otherwise 0
 -----------------------------------------------------------------------------*/
-static void shutdownNode()
+static uint32_t openCallsignMatches(const char *call)
 {
-	const char* s;
-	uint16_t waitTime;
-	uint16_t numNodes=0;
-	uint32_t list[MAX_LOCALNODES_IDX+1];
-	char aslCmd[64];
-	
-	lcdClearScreen();
-	s=iniparser_getstring_16(ini, "messages:msg_shutdown", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-	
-	s=iniparser_getstring_16(ini, "messages:msg_please_wait", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, FALSE);
-	
-	numNodes=getLocalNodes(list);
-	
-	// disconnect everything for all localnodes
-	for (int i=0; i<numNodes; ++i)
+	NodeList_t *pList=&nodeList;
+	const DbNode_t *pNode;
+	char name[DB_CALL_LEN+12];
+	uint32_t first, count=dbFind(call, &first);
+
+	if (count==1)
+		return dbGet(first)->nodeNum;
+
+	memset(pList, 0, sizeof(*pList));
+	pList->emptyMsg=STR_MSG_NO_MATCHES;
+
+	lcdWriteLn(confStr(STR_MENU_CHOOSE_NODENUM), LCD_LINE1, TRUE);
+	for (uint32_t i=0; i<count && pList->numNodes<sizeof(pList->nodeNums)/sizeof(pList->nodeNums[0]); ++i)
 	{
-		sprintf(aslCmd, "asterisk -rx \"rpt fun %u *76\"", list[i]);
-		system(aslCmd);
-		delay(1000);
+		pNode=dbGet(first+i);
+		snprintf(name, sizeof(name), "%s %u", pNode->call, pNode->nodeNum);
+		snprintf(pList->names[pList->numNodes], sizeof(pList->names[0]), "%.16s", name);
+		pList->nodeNums[pList->numNodes]=pNode->nodeNum;
+		pList->numNodes++;
 	}
-	system("asterisk -rx \"stop gracefully\"");
-	
-	waitTime=iniparser_getint(ini, "shutdown:shutdown_wait", 1000);	
-	delay (waitTime);
+
+	uiPush(&nodeListScreen, pList);
+	return 0;
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	enterNodeNum   
+	openFavorites
 Synopsis:
-	Implements manunal entry of node number to connect
+	Builds the list of favorite nodes from aslLCD.conf plus the other local
+	nodes and opens it so the user can select one for connection.
 Author:
 	John Gedde
 Inputs:
 	None
 Outputs:
-	uint32_t: node number entered or 0 if abort
+	None
+-----------------------------------------------------------------------------*/
+static void openFavorites()
+{
+	const char* s;
+	uint32_t nodeNum;
+	uint16_t i;
+	LocalNodes_t nodes;
+	NodeList_t *pList=&nodeList;
+
+	memset(pList, 0, sizeof(*pList));
+	pList->emptyMsg=STR_MSG_NO_FAVORITES;
+
+	s=confStr(STR_MENU_CHOOSE_NODENUM);
+	lcdWriteLn(s, LCD_LINE1, TRUE);
+
+	// Build list of node numbers in favorites list
+	for (i=0; i<=MAX_FAVORITES_IDX; ++i)
+	{
+		// From favorites
+		nodeNum=conf->favorites[i].nodeNum;
+		if (nodeNum!=0 && nodeNum!=selectedLocalNode && nodeNum<MAX_NODENUM)
+		{
+			strcpy(pList->names[pList->numNodes], conf->favorites[i].friendlyName);
+			pList->nodeNums[pList->numNodes]=nodeNum;
+			pList->numNodes++;
+		}
+	}
+
+	if (!pfReady(FETCH_LOCAL_NODES))
+	{
+		s=confStr(STR_MSG_GETTING_NODE_LIST);
+		lcdWriteLn(s, LCD_LINE2, TRUE);
+	}
+
+	if (!pfGet(FETCH_LOCAL_NODES, &nodes))
+		nodes.numNodes=0;
+	for (i=0; i<nodes.numNodes; ++i)
+	{
+		if (nodes.list[i]!=0 && nodes.list[i]!=selectedLocalNode && nodes.list[i]<MAX_NODENUM)
+		{
+			pList->nodeNums[pList->numNodes]=nodes.list[i];
+			pList->numNodes++;
+		}
+	}
+
+	uiPush(&nodeListScreen, pList);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	openLocalNodeSelect
+Synopsis:
+	Functionality to allow user to select the active local node for reading
+	data or for conects and disconnects.  The main menu picks up the result.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	Glocal variable: selectedLocalNode (if there are none)
+-----------------------------------------------------------------------------*/
+static void openLocalNodeSelect()
+{
+	LocalNodes_t nodes = { 0 };
+	const char *s;
+	NodeList_t *pList=&nodeList;
+
+	memset(pList, 0, sizeof(*pList));
+	pList->emptyMsg=STR_MSG_NO_LOCALNODES;
+
+	lcdClearScreen();
+
+	s=confStr(STR_HDG_SEL_LOCAL_NODE);
+	lcdWriteLn(s, LCD_LINE1, TRUE);
+
+	if (!pfReady(FETCH_LOCAL_NODES))
+	{
+		s=confStr(STR_MSG_GETTING_NODE_LIST);
+		lcdWriteLn(s, LCD_LINE2, TRUE);
+	}
+
+	if (pfGet(FETCH_LOCAL_NODES, &nodes))
+	{
+		pList->numNodes=nodes.numNodes;
+		memcpy(pList->nodeNums, nodes.list, sizeof(nodes.list));
+	}
+
+	if (pList->numNodes==0)
+	{
+		selectedLocalNode=0;
+		fprintf(stderr, "aslLCD Warning: No local nodes set-up on device\n");
+	}
+
+	uiPush(&nodeListScreen, pList);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	infoScreen handlers
+Synopsis:
+	Screens that just show something until LEFT or SELECT: the IP address,
+	the active local node, the number of connections and the version.
+	They redraw if what they show changes.  ctx is an InfoScreen_t.
+	RIGHT on the version screen is the back door to the diagnostics screen.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: InfoScreen_t
+	const UiEvent_t *ev: event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void infoEnter(void *ctx)
+{
+	const InfoScreen_t *pInfo=ctx;
+
+	lcdClearScreen();
+	lcdWriteLn(confStr(pInfo->heading), LCD_LINE1, FALSE);
+	pInfo->draw();
+}
+
+static void infoEvent(void *ctx, const UiEvent_t *ev)
+{
+	const InfoScreen_t *pInfo=ctx;
+
+	if (ev->type==UI_EV_DATA)
+	{
+		if (ev->data & UI_DATA_CONF)
+			lcdWriteLn(confStr(pInfo->heading), LCD_LINE1, FALSE);
+		if (ev->data & pInfo->redrawOn)
+			pInfo->draw();
+	}
+	else if (ev->type==UI_EV_BUTTON)
+	{
+		if ((ev->buttons & BTN_RIGHT) && pInfo==&versionInfo)
+			uiReplace(&diagScreen, &diag);
+		else if ((ev->buttons & BTN_LEFT) || (ev->buttons & BTN_SELECT))
+			uiPop(0);
+	}
+}
+
+static const UiScreen_t infoScreen=
+{
+	"info", infoEnter, infoEvent, NULL, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	drawIPaddr
+Synopsis:
+	Displays the IP address.  in case of two IP addresses assigned because user
+	connected ethernet and is connected to wifi, wifi takes precidence.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void drawIPaddr()
+{
+	char lcdBuf[17];
+
+	getIPaddress(lcdBuf);
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	drawActiveLocalNode
+Synopsis:
+	Displays the currently selected local node.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void drawActiveLocalNode()
+{
+	char lcdBuf[17];
+
+	sprintf(lcdBuf, "%u", selectedLocalNode);
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	drawNumConnections
+Synopsis:
+	Implements show number of connected nodes fucntion
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void drawNumConnections()
+{
+	NodeConns_t nodeConns = { 0 };
+	char lcdBuf[17];
+
+	getNodeConnections(&nodeConns);
+
+	sprintf(lcdBuf, "%u", nodeConns.numNodes);
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	drawVersion
+Synopsis:
+	Displays the current version of aslLCD
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void drawVersion()
+{
+	lcdWriteLn(strVersion, LCD_LINE2, FALSE);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	cpuTempScreen handlers
+Synopsis:
+	Displays the latest CPU temperature with the lowest and highest in the
+	sampler's history, and a spark line of the history with the newest
+	reading on the right.  Each character of the spark line shows the
+	hottest of its readings.  UP/DOWN switch between degC and degF.
+	Redraws when a new reading comes in.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: not used
+	const UiEvent_t *ev: event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static float cpuTempUnits(int16_t temp_dC)
+{
+	float fVal=temp_dC/10.0f;
+	
+	return cpuTempF ? CtoF(fVal) : fVal;
+}
+
+static void cpuTempDraw()
+{
+	CtStats_t temps;
+	int16_t hist[CT_HISTORY];
+	int16_t cells[CPU_TEMP_CELLS];
+	char cur[24], range[24], buf[40];
+	int16_t lo=INT16_MAX, hi=INT16_MIN;
+	int32_t start, end;
+	uint16_t n, per=CT_HISTORY/CPU_TEMP_CELLS;
+
+	if (!ctStats(&temps))
+	{
+		lcdWriteLn(confStr(STR_HDG_CPU_TEMP), LCD_LINE1, FALSE);
+		lcdWriteLn("--", LCD_LINE2, FALSE);
+		return;
+	}
+
+	snprintf(cur, sizeof(cur), "%.1f%c%c", cpuTempUnits(temps.now_dC), LCD_CHAR_DEGREE, cpuTempF ? 'F' : 'C');
+	snprintf(range, sizeof(range), "%.0f-%.0f", cpuTempUnits(temps.min_dC), cpuTempUnits(temps.max_dC));
+	snprintf(buf, sizeof(buf), "%-16.16s", cur);
+	if (strlen(range)<=16)
+		memcpy(buf+16-strlen(range), range, strlen(range));
+	lcdWriteLn(buf, LCD_LINE1, FALSE);
+
+	// Newest readings go in the rightmost character
+	n=ctHistory(hist, CT_HISTORY);
+	for (int16_t c=CPU_TEMP_CELLS-1; c>=0; --c)
+	{
+		end=(int32_t)n-(int32_t)(CPU_TEMP_CELLS-1-c)*per;
+		start=(end>per) ? end-per : 0;
+		cells[c]=LCD_SPARK_NONE;
+		for (int32_t i=start; i<end; ++i)
+		{
+			if (hist[i]>cells[c])
+				cells[c]=hist[i];
+		}
+		if (cells[c]!=LCD_SPARK_NONE)
+		{
+			if (cells[c]<lo)
+				lo=cells[c];
+			if (cells[c]>hi)
+				hi=cells[c];
+		}
+	}
+
+	// Don't blow a fraction of a degree of noise up to the full height
+	if (hi-lo<CPU_TEMP_MIN_SPAN)
+	{
+		lo=(lo+hi)/2-CPU_TEMP_MIN_SPAN/2;
+		hi=lo+CPU_TEMP_MIN_SPAN;
+	}
+
+	lcdSparkText(buf, cells, CPU_TEMP_CELLS, lo, hi);
+	lcdWriteLn(buf, LCD_LINE2, FALSE);
+}
+
+static void cpuTempEnter(void *ctx)
+{
+	(void)ctx;
+	lcdClearScreen();
+	cpuTempDraw();
+}
+
+static void cpuTempEvent(void *ctx, const UiEvent_t *ev)
+{
+	if (ev->type==UI_EV_DATA && (ev->data & (UI_DATA_TEMP | UI_DATA_CONF)))
+		cpuTempDraw();
+	else if (ev->type==UI_EV_BUTTON && ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN)))
+	{
+		cpuTempF = !cpuTempF;
+		cpuTempDraw();
+	}
+	else
+		closeOnLeftSelect(ctx, ev);
+}
+
+static const UiScreen_t cpuTempScreen=
+{
+	"cpu temp", cpuTempEnter, cpuTempEvent, NULL, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	clockScreen handlers
+Synopsis:
+	Displays the system clock.  UP/DOWN buttons toggle between 24 and 12 hour
+	clocks.  Redraws as each second ticks over.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: not used
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next update
+-----------------------------------------------------------------------------*/
+static void clockEnter(void *ctx)
+{
+	(void)ctx;
+	clock24Hr=conf->clock24;
+	lcdWriteLn(confStr(STR_HDG_LOCAL_TIME), LCD_LINE1, FALSE);
+}
+
+static void clockEvent(void *ctx, const UiEvent_t *ev)
+{
+	if (ev->type==UI_EV_BUTTON && ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN)))
+	{
+		clock24Hr = !clock24Hr;
+		uiTickAt(0);
+	}
+	else
+		closeOnLeftSelect(ctx, ev);
+}
+
+static uint64_t clockTick(void *ctx, uint64_t now)
+{
+	char buf[32];
+	struct timespec ts;
+	struct tm *localT;
+
+	(void)ctx;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	localT = localtime(&ts.tv_sec);
+
+	if (clock24Hr)
+		sprintf(buf, "%02d:%02d:%02d        ",
+			localT->tm_hour, localT->tm_min, localT->tm_sec);
+	else
+		sprintf(buf, "%02d:%02d:%02d %s     ",
+			localT->tm_hour % 12,
+			localT->tm_min,
+			localT->tm_sec,
+			(localT->tm_hour>=12 ? "PM" : "AM"));
+
+	lcdWriteLn(buf, LCD_LINE2, FALSE);
+
+	return now+1000-ts.tv_nsec/1000000;
+}
+
+static const UiScreen_t clockScreen=
+{
+	"clock", clockEnter, clockEvent, clockTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	upTimeScreen handlers
+Synopsis:
+	Implements show node up time function.  The time comes from sysinfo()
+	and is redrawn as each minute ticks over.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: not used
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next update
+-----------------------------------------------------------------------------*/
+static void upTimeEnter(void *ctx)
+{
+	(void)ctx;
+	lcdWriteLn(confStr(STR_HDG_UP_TIME), LCD_LINE1, FALSE);
+}
+
+static uint64_t upTimeTick(void *ctx, uint64_t now)
+{
+	struct sysinfo info;
+	char buf[24];
+	unsigned int days, hours, mins;
+
+	(void)ctx;
+	if (sysinfo(&info)!=0)
+	{
+		uiPop(0);
+		return UI_NO_TICK;
+	}
+
+	days=info.uptime/86400;
+	hours=(info.uptime/3600) % 24;
+	mins=(info.uptime/60) % 60;
+	if (days)
+		snprintf(buf, sizeof(buf), "up %ud %u:%02u", days, hours, mins);
+	else if (hours)
+		snprintf(buf, sizeof(buf), "up %u:%02u", hours, mins);
+	else
+		snprintf(buf, sizeof(buf), "up %u min", mins);
+	buf[16]='\0';
+	lcdWriteLn(buf, LCD_LINE2, FALSE);
+
+	// Only minutes are shown, so wake up when the next one ticks over
+	return now+(60-info.uptime%60)*1000;
+}
+
+static const UiScreen_t upTimeScreen=
+{
+	"up time", upTimeEnter, closeOnLeftSelect, upTimeTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	blTestScreen handlers
+Synopsis:
+	Backlight color test.  UP/DOWN go through the colors.  The backlight
+	thread leaves the backlight alone while this is open.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: not used
+	const UiEvent_t *ev: event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void blTestEnter(void *ctx)
+{
+	const char *s;
+
+	(void)ctx;
+	backlightTest=TRUE;
+
+	s=confStr(STR_HDG_BL_TEST);
+	lcdClearScreen();
+	lcdWriteLn(s, LCD_LINE1, FALSE);
+
+	blTestColor=conf->blPatterns[BLS_IDLE].color;
+	setBacklightColor(blTestColor);
+	s=confStr(STR_COLOR_0+(blTestColor&7));
+	lcdWriteLn(s, LCD_LINE2, TRUE);
+}
+
+static void blTestEvent(void *ctx, const UiEvent_t *ev)
+{
+	const char *s;
+
+	if (ev->type==UI_EV_BUTTON && ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN)))
+	{
+		if (ev->buttons & BTN_UP)
+			setBacklightColor(++blTestColor);
+		else
+			setBacklightColor(--blTestColor);
+		s=confStr(STR_COLOR_0+(blTestColor&7));
+		lcdWriteLn(s, LCD_LINE2, TRUE);
+	}
+	else
+		closeOnLeftSelect(ctx, ev);
+}
+
+static void blTestExit(void *ctx)
+{
+	(void)ctx;
+	setBacklightColor(conf->blPatterns[BLS_IDLE].color);
+	backlightTest=FALSE;
+}
+
+static const UiScreen_t blTestScreen=
+{
+	"backlight test", blTestEnter, blTestEvent, NULL, blTestExit
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	diagScreen handlers
+Synopsis:
+	Hidden diagnostics screen (RIGHT on the version screen).  UP/DOWN pages
+	through:
+		- latency histograms: p50, p99 and max for each stage
+		- i2c bus busy % and transactions per second
+		- calls and i2c transactions per second for each LCD function
+		- LCD lock busy %, average wait and max wait for each thread
+	Rates are over the last refresh.  Updates once a second.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: Diag_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next update
+-----------------------------------------------------------------------------*/
+static void diagEnter(void *ctx)
+{
+	Diag_t *pDiag=ctx;
+
+	pDiag->page=0;
+	lcdClearScreen();
+	lcdGetStats(&pDiag->lastStats);
+}
+
+static void diagEvent(void *ctx, const UiEvent_t *ev)
+{
+	Diag_t *pDiag=ctx;
+
+	if (ev->type==UI_EV_BUTTON && ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN)))
+	{
+		pDiag->page=uiWrap(pDiag->page, DIAG_PAGE_MAX, ev->buttons);
+		uiTickAt(0);
+	}
+	else
+		closeOnLeftSelect(ctx, ev);
+}
+
+static uint64_t diagTick(void *ctx, uint64_t now)
+{
+	Diag_t *pDiag=ctx;
+	uint16_t page=pDiag->page;
+	LatHist_t hist;
+	LcdStats_t stats;
+	const LcdStats_t *lastStats=&pDiag->lastStats;
+	const LcdApiStats_t *api, *lastApi;
+	const LcdLockStats_t *lock, *lastLock;
+	uint64_t wr=0, rd=0, lastWr=0, lastRd=0;
+	double secs;
+	char lcdBuf[40];
+	char p50[8], p99[8], pMax[8];
+
+	lcdGetStats(&stats);
+	secs=(stats.elapsed_us-lastStats->elapsed_us)/1000000.0;
+	if (secs<0.001)
+		secs=0.001;
+
+	if (page<DIAG_PAGE_BUS)
+	{
+		latGetHist(page-DIAG_PAGE_LAT, &hist);
+		sprintf(lcdBuf, "%-4s 50/99/max", latStageShortName(page-DIAG_PAGE_LAT));
+		lcdWriteLn(lcdBuf, LCD_LINE1, FALSE);
+
+		latFormatUs(p50, latPercentile(&hist, 50));
+		latFormatUs(p99, latPercentile(&hist, 99));
+		latFormatUs(pMax, hist.max_us);
+		sprintf(lcdBuf, "%-5s %-5s %-4s", p50, p99, pMax);
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	}
+	else if (page==DIAG_PAGE_BUS)
+	{
+		for (int i=0; i<LCDAPI_MAX; ++i)
+		{
+			wr+=stats.api[i].i2cWrites;
+			rd+=stats.api[i].i2cReads;
+			lastWr+=lastStats->api[i].i2cWrites;
+			lastRd+=lastStats->api[i].i2cReads;
+		}
+		snprintf(lcdBuf, 17, "I2C busy %5.1f%%",
+			(stats.busBusy_us-lastStats->busBusy_us)/10000.0/secs);
+		lcdWriteLn(lcdBuf, LCD_LINE1, FALSE);
+		snprintf(lcdBuf, 17, "wr%6u rd%5u",
+			(unsigned int)((wr-lastWr)/secs), (unsigned int)((rd-lastRd)/secs));
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	}
+	else if (page<DIAG_PAGE_LOCK)
+	{
+		api=&stats.api[page-DIAG_PAGE_API];
+		lastApi=&lastStats->api[page-DIAG_PAGE_API];
+		snprintf(lcdBuf, 17, "%-4s calls %5u", lcdApiShortName(page-DIAG_PAGE_API),
+			(unsigned int)((api->calls-lastApi->calls)/secs));
+		lcdWriteLn(lcdBuf, LCD_LINE1, FALSE);
+		snprintf(lcdBuf, 17, "wr%6u rd%5u",
+			(unsigned int)((api->i2cWrites-lastApi->i2cWrites)/secs),
+			(unsigned int)((api->i2cReads-lastApi->i2cReads)/secs));
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	}
+	else
+	{
+		lock=&stats.lock[page-DIAG_PAGE_LOCK];
+		lastLock=&lastStats->lock[page-DIAG_PAGE_LOCK];
+		snprintf(lcdBuf, 17, "%-4s lock %5.1f%%", lcdRoleShortName(page-DIAG_PAGE_LOCK),
+			(lock->hold_us-lastLock->hold_us)/10000.0/secs);
+		lcdWriteLn(lcdBuf, LCD_LINE1, FALSE);
+		latFormatUs(p50, (lock->locks>lastLock->locks) ?
+			(lock->wait_us-lastLock->wait_us)/(lock->locks-lastLock->locks) : 0);
+		latFormatUs(pMax, lock->maxWait_us);
+		sprintf(lcdBuf, "Wt %-5s Mx %-4s", p50, pMax);
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	}
+	pDiag->lastStats=stats;
+
+	return now+1000;
+}
+
+static const UiScreen_t diagScreen=
+{
+	"diagnostics", diagEnter, diagEvent, diagTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	connListScreen handlers
+Synopsis:
+	Connected nodes.  Used two ways (ctx ConnList_t says which):
+		- show connections: UP/DOWN through the list, LEFT/SELECT close.
+		  The list is read again if the connections change.
+		- disconnect: one more entry at the end to disconnect all.
+		  SELECT disconnects the one showing.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: ConnList_t
+	const UiEvent_t *ev: event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void connListDraw(ConnList_t *pList)
+{
+	const char *s;
+
+	// When idx equals the number of nodes (i.e. 1 index higher than we have nodes in the list)
+	// present user with a 'disconnect all' option.
+	if (pList->idx==pList->conns.numNodes)
+	{
+		s=confStr(STR_MENU_DISCONNECT_ALL);
+		lcdWriteLn(s, LCD_LINE2, TRUE);
+	}
+	else
+		displaySelectedNode(pList->idx, &pList->conns);
+}
+
+static void connListLoad(ConnList_t *pList)
+{
+	memset(&pList->conns, 0, sizeof(pList->conns));
+	getNodeConnections(&pList->conns);
+
+	if (pList->conns.numNodes==0)
+	{
+		lcdWriteLn(confStr(STR_MSG_NO_CONNECTIONS), LCD_LINE2, TRUE);
+		return;
+	}
+
+	if (pList->idx>=pList->conns.numNodes+(pList->disconnect ? 1 : 0))
+		pList->idx=0;
+	connListDraw(pList);
+}
+
+static void connListEnter(void *ctx)
+{
+	ConnList_t *pList=ctx;
+
+	lcdClearScreen();
+	lcdWriteLn(confStr(pList->disconnect ? STR_MENU_DISCONNECT : STR_HDG_CONNECTIONS), LCD_LINE1, TRUE);
+	pList->idx=0;
+	connListLoad(pList);
+}
+
+static void connListEvent(void *ctx, const UiEvent_t *ev)
+{
+	ConnList_t *pList=ctx;
+	AcRequest_t req = { 0 };
+
+	if (ev->type==UI_EV_DATA && (ev->data & UI_DATA_LINKS))
+		connListLoad(pList);
+	if (ev->type!=UI_EV_BUTTON)
+		return;
+
+	if (pList->conns.numNodes==0)
+		closeOnLeftSelect(ctx, ev);
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pList->idx=uiWrap(pList->idx, pList->conns.numNodes+(pList->disconnect ? 1 : 0), ev->buttons);
+		connListDraw(pList);
+	}
+	else if ((ev->buttons & BTN_SELECT) && pList->disconnect)
+	{
+		req.localNode=selectedLocalNode;
+		if (pList->idx==pList->conns.numNodes)
+			// Disconnect all from selected local node
+			req.kind=AC_DISCONNECT_ALL;
+		else
+		{
+			// Disconnect selected node.
+			req.kind=AC_DISCONNECT;
+			req.nodeNum=pList->conns.Nodes[pList->idx].nodeNum;
+		}
+		startLinkJob(&req);
+	}
+	else
+		closeOnLeftSelect(ctx, ev);
+}
+
+static const UiScreen_t connListScreen=
+{
+	"connections", connListEnter, connListEvent, NULL, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	connectScreen handlers
+Synopsis:
+	Implements the node connection submenu.  Pick a recent node, a
+	favorite, find one by callsign or enter a number, then the connection
+	type, then connect.  Recent is first if there are any.  A callsign
+	search goes straight on to the connection type.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: Connect_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: when to move on from the "OK. Now select" message
+-----------------------------------------------------------------------------*/
+static void connectDraw(Connect_t *pConn)
+{
+	static const ConfStr_t items[CONNECT_MAX]={ STR_MENU_RECENT, STR_MENU_FAVORITES, STR_MENU_FIND_CALLSIGN, STR_MENU_ENTER_NODE_NUM };
+
+	lcdWriteLn(confStr(STR_MENU_CONNECT), LCD_LINE1, TRUE);
+	lcdWriteLn(confStr(items[pConn->item]), LCD_LINE2, TRUE);
+}
+
+static void connectEnter(void *ctx)
+{
+	Connect_t *pConn=ctx;
+
+	pConn->item=(rnComplete("")!=0) ? CONNECT_RECENT : CONNECT_FAVORITES;
+	pConn->nodeNum=0;
+	connectDraw(pConn);
+}
+
+static void connectEvent(void *ctx, const UiEvent_t *ev)
+{
+	Connect_t *pConn=ctx;
+	AcRequest_t req = { 0 };
+
+	if (ev->type==UI_EV_RESULT)
+	{
+		if (ev->from==&waitKeyScreen)
+		{
+			// Back from no node database
+			connectDraw(pConn);
+		}
+		else if (ev->from==&textMenuScreen)
+		{
+			// Connection type picked - try to connect to node
+			if (ev->result!=UI_CANCEL)
+			{
+				req.kind=AC_CONNECT;
+				req.localNode=selectedLocalNode;
+				req.nodeNum=pConn->nodeNum;
+				req.ilinkCmd=astCmdLookup[ev->result];
+				startLinkJob(&req);
+			}
+			else
+				uiPop(0);
+		}
+		else if (ev->from==&textEntryScreen && ev->result && pConn->item==CONNECT_FIND)
+		{
+			// connectTick() goes on to the connection type once there's a node
+			pConn->nodeNum=openCallsignMatches(textEntry.text);
+		}
+		else if (ev->from==&nodeListScreen && ev->result && pConn->item==CONNECT_FIND)
+			pConn->nodeNum=ev->result;
+		else if ((ev->from==&nodeListScreen || ev->from==&textEntryScreen) && pConn->item==CONNECT_FIND)
+		{
+			// Callsign search given up, or nothing matched - back to the items
+			connectDraw(pConn);
+		}
+		else if (ev->result)
+		{
+			// Got a node number.  Say what's next for a moment
+			pConn->nodeNum=(ev->from==&textEntryScreen) ? strtoul(textEntry.text, NULL, 10) : (uint32_t)ev->result;
+			if (pConn->nodeNum==0)
+			{
+				uiPop(0);
+				return;
+			}
+			lcdWriteLn(confStr(STR_MSG_OK_SELECT_TYPE_LINE1), LCD_LINE1, TRUE);
+			lcdWriteLn(confStr(STR_MSG_OK_SELECT_TYPE_LINE2), LCD_LINE2, TRUE);
+			uiTickAt(getClock_ms()+1500);
+		}
+		else
+			uiPop(0);
+	}
+	else if (ev->type!=UI_EV_BUTTON || pConn->nodeNum)
+		return;
+	else if (ev->buttons & BTN_LEFT)
+		uiPop(0);
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pConn->item=uiWrap(pConn->item, CONNECT_MAX, ev->buttons);
+		connectDraw(pConn);
+	}
+	else if (ev->buttons & BTN_SELECT)
+	{
+		if (pConn->item==CONNECT_ENTER)
+		{
+			teInit(&textEntry, STR_MENU_SET_NODE_NUM, TE_DIGITS, 0, MAX_NODNUM_WIDTH, '-');
+			textEntry.suggest=suggestNode;
+			uiPush(&textEntryScreen, &textEntry);
+		}
+		else if (pConn->item==CONNECT_FIND)
+		{
+			if (dbLoad(conf->astdbFile))
+			{
+				teInit(&textEntry, STR_HDG_CALLSIGN, TE_DIGITS | TE_CLASS_BIT(TE_CLASS_UPPER), 1, DB_CALL_LEN, ' ');
+				textEntry.suggest=suggestCallsign;
+				textEntry.allow=allowCallsign;
+				textEntry.tooShort=STR_MSG_NEED_CALLSIGN;
+				uiPush(&textEntryScreen, &textEntry);
+			}
+			else
+				waitKey(STR_MSG_NO_ASTDB, BTN_ANY);
+		}
+		else if (pConn->item==CONNECT_RECENT)
+			openRecent();
+		else
+			openFavorites();
+	}
+}
+
+static uint64_t connectTick(void *ctx, uint64_t now)
+{
+	Connect_t *pConn=ctx;
+
+	(void)now;
+
+	// Select connection type
+	if (pConn->nodeNum)
+		uiPush(&textMenuScreen, &connTypeMenu);
+	return UI_NO_TICK;
+}
+
+static const UiScreen_t connectScreen=
+{
+	"connect", connectEnter, connectEvent, connectTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	startLinkJob
+Synopsis:
+	Hands a connect or disconnect to the asterisk command thread and puts
+	the progress screen up in place of the screen asking for it
+Author:
+	John Gedde
+Inputs:
+	const AcRequest_t *pReq: what to do
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void startLinkJob(const AcRequest_t *pReq)
+{
+	LinkJob_t *pJob=&linkJob;
+
+	memset(pJob, 0, sizeof(*pJob));
+	pJob->kind=pReq->kind;
+	pJob->nodeNum=pReq->nodeNum;
+	pJob->id=acSubmit(pReq);
+	uiReplace(&linkJobScreen, pJob);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	linkJobScreen handlers
+Synopsis:
+	Progress of a connect or disconnect.  The node number and a moving dot
+	with the seconds so far while asterisk is working on it, then whether
+	the link came up (went down) and how long it took.  The result goes
+	away on its own after LINK_RESULT_MS.  Any button leaves; the request
+	carries on without the screen.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: LinkJob_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next tick
+-----------------------------------------------------------------------------*/
+static void linkJobDraw(LinkJob_t *pJob, uint64_t now)
+{
+	AcStatus_t st;
+	char lcdBuf[32];
+	char node[12]="";
+	char spin[5]="    ";
+	ConfStr_t msg;
+
+	if (!acStatus(pJob->id, &st))
+	{
+		st.state=ACS_FAILED;
+		st.elapsed_ms=0;
+	}
+
+	if (!acFinished(st.state))
+	{
+		spin[pJob->spin % 4]='.';
+		if (pJob->kind!=AC_DISCONNECT_ALL)
+			sprintf(node, "%u", pJob->nodeNum);
+		snprintf(lcdBuf, sizeof(lcdBuf), "%-8s%3us%s", node, (unsigned int)((now-pJob->start)/1000), spin);
+		lcdBuf[16]='\0';
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+		return;
+	}
+
+	if (st.state==ACS_DONE && pJob->kind==AC_CONNECT)
+		msg=STR_MSG_LINKED;
+	else if (st.state==ACS_DONE)
+		msg=STR_MSG_UNLINKED;
+	else if (st.state==ACS_TIMEOUT)
+		msg=STR_MSG_LINK_TIMEOUT;
+	else
+		msg=STR_MSG_LINK_FAILED;
+
+	if (st.state==ACS_FAILED)
+		snprintf(lcdBuf, sizeof(lcdBuf), "%s", confStr(msg));
+	else
+		snprintf(lcdBuf, sizeof(lcdBuf), "%s %u.%us", confStr(msg),
+			st.elapsed_ms/1000, (st.elapsed_ms%1000)/100);
+	lcdBuf[16]='\0';
+	lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
+	pJob->finished=TRUE;
+}
+
+static void linkJobEnter(void *ctx)
+{
+	LinkJob_t *pJob=ctx;
+	ConfStr_t title;
+
+	if (pJob->kind==AC_CONNECT)
+		title=STR_MSG_CONNECTING;
+	else if (pJob->kind==AC_DISCONNECT)
+		title=STR_MSG_DISCONNECTING;
+	else
+		title=STR_MENU_DISCONNECT_ALL;
+
+	lcdClearScreen();
+	lcdWriteLn(confStr(title), LCD_LINE1, TRUE);
+	pJob->start=getClock_ms();
+	linkJobDraw(pJob, pJob->start);
+	uiTickAt(pJob->start+(pJob->finished ? LINK_RESULT_MS : LINK_SPIN_MS));
+}
+
+static void linkJobEvent(void *ctx, const UiEvent_t *ev)
+{
+	LinkJob_t *pJob=ctx;
+
+	if (ev->type==UI_EV_BUTTON)
+		uiPop(0);
+	else if (ev->type==UI_EV_DATA && (ev->data & UI_DATA_LINKS) && !pJob->finished)
+		uiTickAt(0);
+}
+
+static uint64_t linkJobTick(void *ctx, uint64_t now)
+{
+	LinkJob_t *pJob=ctx;
+
+	if (pJob->finished)
+	{
+		uiPop(0);
+		return UI_NO_TICK;
+	}
+
+	pJob->spin++;
+	linkJobDraw(pJob, now);
+	return pJob->finished ? now+LINK_RESULT_MS : now+LINK_SPIN_MS;
+}
+
+static const UiScreen_t linkJobScreen=
+{
+	"link job", linkJobEnter, linkJobEvent, linkJobTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	startScript
+Synopsis:
+	Starts a command in the background and opens its output screen, or
+	says why it couldn't be started.  The buttons keep working while it
+	runs.
+Author:
+	John Gedde
+Inputs:
+	const char *name: what to call it on the LCD
+	const char *cmd: command line
+	uint32_t timeout_ms: kill it after this long, 0 for never
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void startScript(const char *name, const char *cmd, uint32_t timeout_ms)
+{
+	ScriptView_t *pView=&scriptView;
+
+	memset(pView, 0, sizeof(*pView));
+	pView->id=srRun(name, cmd, timeout_ms, conf->maxScriptsRunning);
+	if (pView->id)
+	{
+		uiPush(&scriptViewScreen, pView);
+		return;
+	}
+
+	lcdWriteLn(name, LCD_LINE1, TRUE);
+	waitKey(srIsRunning(name) ? STR_MSG_SCRIPT_ALREADY : STR_MSG_SCRIPT_BUSY, BTN_ANY);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	runScript
+Synopsis:
+	Runs one of the scripts from aslLCD.conf, with the selected local node
+	on the end if it wants one.  A path of @say_time etc. is one of the
+	built in announcements instead.
+Author:
+	John Gedde
+Inputs:
+	uint16_t idx: index into conf->scripts
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void runScript(uint16_t idx)
+{
+	char cmd[512];
+	const ConfScript_t *pScript;
+	int what;
+
+	if (idx>=conf->numScripts)
+		return;
+	pScript=&conf->scripts[idx];
+
+	if (pScript->path[0]==SAY_PREFIX)
+	{
+		if ((what=sayLookup(pScript->path+1))<0)
+		{
+			fprintf(stderr, "aslLCD Error: No built in announcement %s\n", pScript->path);
+			lcdWriteLn(pScript->name, LCD_LINE1, TRUE);
+			waitKey(STR_MSG_SCRIPT_FAILED, BTN_ANY);
+		}
+		else
+			runSay(what, pScript->name);
+		return;
+	}
+
+	if (pScript->needNodeNum)
+		snprintf(cmd, sizeof(cmd), "%s %s %u", pScript->path, pScript->param, selectedLocalNode);
+	else
+		snprintf(cmd, sizeof(cmd), "%s %s", pScript->path, pScript->param);
+
+	startScript(pScript->name, cmd, pScript->timeout_s*1000);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	runSay
+Synopsis:
+	Built in announcement on the selected local node.  The sound file is
+	put together here, so all that's left is one rpt localplay.
+Author:
+	John Gedde
+Inputs:
+	SayWhat_t what: which one
+	const char *name: what to call it on the LCD
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void runSay(SayWhat_t what, const char *name)
+{
+	char base[64];
+	char cmd[128];
+
+	if (!sayBuild(what, base, sizeof(base)))
+	{
+		lcdWriteLn(name, LCD_LINE1, TRUE);
+		waitKey(STR_MSG_SCRIPT_FAILED, BTN_ANY);
+		return;
+	}
+
+	snprintf(cmd, sizeof(cmd), "asterisk -rx \"rpt localplay %u %s\"", selectedLocalNode, base);
+	startScript(name, cmd, SAY_TIMEOUT_MS);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	scriptChanged
+Synopsis:
+	Called from the script thread when a script has more output or ends
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: the run
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void scriptChanged(uint32_t id)
+{
+	(void)id;
+	uiNotify(UI_DATA_SCRIPT);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	scriptViewScreen handlers
+Synopsis:
+	A script's state and time on line 1, its output on line 2.  UP/DOWN
+	go back and forth through the last SR_LINES lines; while the newest
+	line is showing, new output replaces it.  LEFT or SELECT go back and
+	leave the script running.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: ScriptView_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next tick
+-----------------------------------------------------------------------------*/
+static void scriptViewDraw(ScriptView_t *pView)
+{
+	SrStatus_t st;
+	char word[32];
+	char lcdBuf[SR_LINE_LEN+16];
+
+	if (!srStatus(pView->id, &st))
+		return;
+
+	switch (st.state)
+	{
+		case SRS_RUNNING:
+			snprintf(word, sizeof(word), "%s", confStr(STR_MSG_SCRIPT_RUNNING));
+			break;
+		case SRS_DONE:
+			snprintf(word, sizeof(word), "%s", confStr(STR_MSG_SCRIPT_DONE));
+			break;
+		case SRS_TIMEOUT:
+			snprintf(word, sizeof(word), "%s", confStr(STR_MSG_SCRIPT_TIMEOUT));
+			break;
+		case SRS_FAILED:
+		default:
+			snprintf(word, sizeof(word), "%s %d", confStr(STR_MSG_SCRIPT_FAILED), st.exitCode);
+			break;
+	}
+	snprintf(lcdBuf, sizeof(lcdBuf), "%-10.10s%5us", word, st.elapsed_ms/1000);
+	lcdBuf[16]='\0';
+	lcdWriteLn(lcdBuf, LCD_LINE1, FALSE);
+
+	if (st.numLines==0)
+	{
+		lcdWriteLn(confStr(STR_MSG_SCRIPT_NO_OUTPUT), LCD_LINE2, FALSE);
+		return;
+	}
+
+	if (pView->follow || pView->line>=st.numLines)
+		pView->line=st.numLines-1;
+	srLine(pView->id, pView->line, lcdBuf, sizeof(lcdBuf));
+	lcdBuf[16]='\0';
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+}
+
+static void scriptViewEnter(void *ctx)
+{
+	ScriptView_t *pView=ctx;
+
+	pView->follow=TRUE;
+	lcdClearScreen();
+	scriptViewDraw(pView);
+}
+
+static void scriptViewEvent(void *ctx, const UiEvent_t *ev)
+{
+	ScriptView_t *pView=ctx;
+	SrStatus_t st;
+
+	if (ev->type==UI_EV_DATA && (ev->data & UI_DATA_SCRIPT))
+		scriptViewDraw(pView);
+	if (ev->type!=UI_EV_BUTTON)
+		return;
+
+	if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		if (!srStatus(pView->id, &st) || st.numLines==0)
+			return;
+		if ((ev->buttons & BTN_UP) && pView->line>0)
+			pView->line--;
+		else if ((ev->buttons & BTN_DOWN) && pView->line+1<st.numLines)
+			pView->line++;
+		pView->follow=(pView->line+1==st.numLines);
+		scriptViewDraw(pView);
+	}
+	else if ((ev->buttons & BTN_LEFT) || (ev->buttons & BTN_SELECT))
+		uiPop(0);
+}
+
+static uint64_t scriptViewTick(void *ctx, uint64_t now)
+{
+	ScriptView_t *pView=ctx;
+	SrStatus_t st;
+
+	// Only the time changes without an event
+	if (!srStatus(pView->id, &st) || st.state!=SRS_RUNNING)
+		return UI_NO_TICK;
+	scriptViewDraw(pView);
+	return now+SCRIPT_TICK_MS;
+}
+
+static const UiScreen_t scriptViewScreen=
+{
+	"script output", scriptViewEnter, scriptViewEvent, scriptViewTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	scriptListSize
+Synopsis:
+	How many entries a scripts list has.  The top level is the scripts
+	with no category followed by the categories; a category is its run of
+	conf->scripts.
+Author:
+	John Gedde
+Inputs:
+	const ScriptList_t *pList: the list
+	uint16_t *pFirst: where to put the first script's index
+Outputs:
+	uint16_t *pFirst: index into conf->scripts of the first entry
+	uint16_t: entries, 0 if the category has gone
+-----------------------------------------------------------------------------*/
+static uint16_t scriptListSize(const ScriptList_t *pList, uint16_t *pFirst)
+{
+	const AslLcdConf_t *pConf=conf;
+
+	*pFirst=0;
+	if (pList->category[0]=='\0')
+		return pConf->numTopScripts+pConf->numScriptCats;
+
+	for (uint16_t i=0; i<pConf->numScriptCats; ++i)
+	{
+		if (strcmp(pConf->scriptCats[i].name, pList->category)==0)
+		{
+			*pFirst=pConf->scriptCats[i].first;
+			return pConf->scriptCats[i].count;
+		}
+	}
+	return 0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	scriptsScreen handlers
+Synopsis:
+	Implements scripts submenu to run scripts defined in aslLCD.conf and
+	the scripts.d catalog.  Catalog categories are submenus (the same
+	screen again with the category's scripts.)
+Author:
+	John Gedde
+Inputs:
+	void *ctx: ScriptList_t
+	const UiEvent_t *ev: event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void scriptsDrawSel(ScriptList_t *pList)
+{
+	const AslLcdConf_t *pConf=conf;
+	uint16_t first;
+
+	if (pList->category[0]=='\0' && pList->sel>=pConf->numTopScripts)
+		lcdWriteLn(pConf->scriptCats[pList->sel-pConf->numTopScripts].name, LCD_LINE2, TRUE);
+	else
+	{
+		scriptListSize(pList, &first);
+		lcdWriteLn(pConf->scripts[first+pList->sel].name, LCD_LINE2, TRUE);
+	}
+}
+
+static void scriptsDraw(ScriptList_t *pList)
+{
+	lcdClearScreen();
+	lcdWriteLn(pList->category[0] ? pList->category : confStr(STR_HDG_SELECT_SCRIPT), LCD_LINE1, TRUE);
+	scriptsDrawSel(pList);
+}
+
+static void scriptsEnter(void *ctx)
+{
+	ScriptList_t *pList=ctx;
+	uint16_t first;
+
+	pList->sel=0;
+	if (scriptListSize(pList, &first)==0)
+	{
+		lcdClearScreen();
+		lcdWriteLn(confStr(STR_HDG_SELECT_SCRIPT), LCD_LINE1, TRUE);
+		waitKey(conf->noScriptsMsg, BTN_ANY);
+	}
+	else
+		scriptsDraw(pList);
+}
+
+static void scriptsEvent(void *ctx, const UiEvent_t *ev)
+{
+	ScriptList_t *pList=ctx;
+	const AslLcdConf_t *pConf=conf;
+	uint16_t first, num;
+
+	num=scriptListSize(pList, &first);
+
+	// Back from the no scripts message or from running one, or the
+	// scripts changed
+	if (ev->type==UI_EV_RESULT || (ev->type==UI_EV_DATA && (ev->data & UI_DATA_CONF)))
+	{
+		if (num==0)
+			uiPop(0);
+		else
+		{
+			if (pList->sel>=num)
+				pList->sel=0;
+			scriptsDraw(pList);
+		}
+	}
+	else if (ev->type!=UI_EV_BUTTON || num==0)
+		return;
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pList->sel=uiWrap(pList->sel, num, ev->buttons);
+		scriptsDrawSel(pList);
+	}
+	else if (ev->buttons & BTN_SELECT)
+	{
+		if (pList->category[0]=='\0' && pList->sel>=pConf->numTopScripts)
+		{
+			strcpy(scriptLists[1].category, pConf->scriptCats[pList->sel-pConf->numTopScripts].name);
+			uiPush(&scriptsScreen, &scriptLists[1]);
+		}
+		else
+			runScript(first+pList->sel);
+	}
+	else if (ev->buttons & BTN_LEFT)
+		uiPop(0);
+}
+
+static const UiScreen_t scriptsScreen=
+{
+	"scripts", scriptsEnter, scriptsEvent, NULL, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	scrollLine
+Synopsis:
+	Shows the next step of text too long for the LCD scrolling across
+	line 2
+Author:
+	John Gedde
+Inputs:
+	const char *text: the text, with some spaces on the end
+	uint16_t *pPos: where it's scrolled to
+Outputs:
+	uint16_t *pPos: next step
+-----------------------------------------------------------------------------*/
+static void scrollLine(const char *text, uint16_t *pPos)
+{
+	char lcdBuf[17];
+
+	strncpy(lcdBuf, text+*pPos, 16);
+	lcdBuf[16]='\0';
+	if (strlen(lcdBuf)<16)
+		strncat(lcdBuf, text, 16-strlen(lcdBuf));
+
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+
+	if (strlen(text+*pPos)>0)
+		(*pPos)++;
+	else
+		*pPos=0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wifiScrollTick
+Synopsis:
+	Scrolls a wifi name too long for the LCD across line 2
+Author:
+	John Gedde
+Inputs:
+	void *ctx: WifiList_t
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next scroll step
+-----------------------------------------------------------------------------*/
+static uint64_t wifiScrollTick(void *ctx, uint64_t now)
+{
+	WifiList_t *pWifi=ctx;
+
+	if (!pWifi->scrollIt)
+		return UI_NO_TICK;
+	scrollLine(pWifi->displayName, &pWifi->scrollPos);
+	return now+conf->scrollStep_ms;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wifiMeterScreen handlers
+Synopsis:
+	Live link meter for the wifi we're connected to.  The link is read
+	straight from nl80211 and /proc/net/wireless every WIFI_METER_MS - 
+	nothing is started, so it can keep up with a node dropping audio.
+	Line 1 is the signal in dBm and a bar graph.  UP/DOWN picks what
+	line 2 shows: the SSID, low/avg/high signal over the last
+	WIFI_METER_WINDOW samples, link quality and noise, or tx bitrate and
+	retries per second.  A line is only written when it changes.  LEFT or
+	SELECT closes it.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: WifiMeter_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next sample
 -----------------------------------------------------------------------------*/
-static uint32_t enterNodeNum()
+static void wifiMeterLine(WifiMeter_t *pMeter, LcdLine_t line, const char *text)
 {
-	const char* s;
-	uint16_t buttons;
-	uint8_t position=MAX_NODNUM_WIDTH-1;
-	uint32_t nodeNum=0;
-	bool cancel=FALSE;
 	char lcdBuf[17];
-	uint32_t increment=1;
-	
-	memset(lcdBuf, '0', sizeof(lcdBuf)-1);
-		
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "connect disconnect:menu_set_node_num", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-	
-	lcdWriteLn("--------", LCD_LINE2, FALSE);
-	
-	lcdPositionCursor(LCD_LINE2, position);	
-	lcdCursorEnable(TRUE);
-	
-	for(;;)
+
+	snprintf(lcdBuf, sizeof(lcdBuf), "%-16.16s", text);
+	if (strcmp(lcdBuf, pMeter->lines[line])==0)
+		return;
+	strcpy(pMeter->lines[line], lcdBuf);
+	lcdWriteLn(lcdBuf, line, FALSE);
+}
+
+static void wifiMeterSample(WifiMeter_t *pMeter, uint64_t now)
+{
+	NwLink_t *pLink=&pMeter->link;
+
+	if (!nwLink(conf->wifiIface, pLink) || !pLink->connected)
 	{
-		buttons=waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if ((buttons & BTN_LEFT) || (buttons & BTN_RIGHT))
-		{
-			if (buttons & BTN_LEFT)
-			{
-				if (position>0)
-				{
-					increment*=10;
-					position--;
-				}
-				else
-					cancel=TRUE;					
-			}
-			else if (buttons & BTN_RIGHT)
-			{
-				if (position<MAX_NODNUM_WIDTH-1 && !cancel)
-				{
-					increment/=10;
-					position++;
-				}
-				cancel=FALSE;
-			}			
-		
-			if (cancel)
-			{
-				lcdCursorEnable(FALSE);
-				s=iniparser_getstring_16(ini, "messages:msg_cancel_prompt", strConfProblem);
-				lcdWriteLn(s, LCD_LINE2, FALSE);
-			}
-			else
+		pMeter->numSamples=0;
+		pMeter->next=0;
+		pMeter->retriesAt=0;
+		pMeter->retryRate=0;
+		return;
+	}
+
+	pMeter->window[pMeter->next]=pLink->signal_dBm;
+	pMeter->next=(pMeter->next+1) % WIFI_METER_WINDOW;
+	if (pMeter->numSamples<WIFI_METER_WINDOW)
+		pMeter->numSamples++;
+
+	// Retries only ever go up until the next association
+	if (pMeter->retriesAt==0 || pLink->txRetries<pMeter->lastRetries)
+	{
+		pMeter->lastRetries=pLink->txRetries;
+		pMeter->retriesAt=now;
+	}
+	else if (now-pMeter->retriesAt>=1000)
+	{
+		pMeter->retryRate=(uint32_t)((uint64_t)(pLink->txRetries-pMeter->lastRetries)*1000/(now-pMeter->retriesAt));
+		pMeter->lastRetries=pLink->txRetries;
+		pMeter->retriesAt=now;
+	}
+}
+
+static void wifiMeterDraw(WifiMeter_t *pMeter)
+{
+	const NwLink_t *pLink=&pMeter->link;
+	char lcdBuf[NW_SSID_LEN+8];
+	char bar[WIFI_METER_CELLS+1];
+	char scroll[17];
+	int16_t lo=0, hi=0, sig;
+	int32_t sum=0;
+	size_t len;
+
+	if (!pLink->connected)
+	{
+		wifiMeterLine(pMeter, LCD_LINE1, confStr(STR_HDG_CURRENT_WIFI));
+		wifiMeterLine(pMeter, LCD_LINE2, confStr(STR_MSG_NO_CONNECTIONS));
+		return;
+	}
+
+	sig=pLink->signal_dBm;
+	if (sig<WIFI_METER_FLOOR)
+		sig=WIFI_METER_FLOOR;
+	else if (sig>WIFI_METER_CEIL)
+		sig=WIFI_METER_CEIL;
+	lcdBarText(bar, WIFI_METER_CELLS, sig-WIFI_METER_FLOOR, WIFI_METER_CEIL-WIFI_METER_FLOOR);
+	snprintf(lcdBuf, sizeof(lcdBuf), "%4ddBm%s", pLink->signal_dBm, bar);
+	wifiMeterLine(pMeter, LCD_LINE1, lcdBuf);
+
+	switch (pMeter->page)
+	{
+		case WM_PAGE_SSID:
+		default:
+			if (strlen(pLink->ssid)<=16)
 			{
-				lcdCursorEnable(TRUE);
-				sprintf(lcdBuf, "%8u        ", nodeNum);
-				for(unsigned int i=0; i<strlen(lcdBuf); ++i)
-				{
-					if (isdigit(lcdBuf[i]))
-						break;  // found the beginning of the number
-					else if (lcdBuf[i]==' ')
-						lcdBuf[i]='-';
-				}		
-				lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+				pMeter->scrollPos=0;
+				wifiMeterLine(pMeter, LCD_LINE2, pLink->ssid);
+				break;
 			}
-			lcdPositionCursor(LCD_LINE2, position);
-		}
-		else if (((buttons & BTN_UP) || (buttons & BTN_DOWN)) && !cancel)
-		{
-			if (buttons & BTN_UP)
+			// Scroll it a step a sample, with some space at the end
+			snprintf(lcdBuf, sizeof(lcdBuf), "%s   ", pLink->ssid);
+			len=strlen(lcdBuf);
+			for (uint16_t i=0; i<16; ++i)
+				scroll[i]=lcdBuf[(pMeter->scrollPos+i) % len];
+			scroll[16]='\0';
+			pMeter->scrollPos=(pMeter->scrollPos+1) % len;
+			wifiMeterLine(pMeter, LCD_LINE2, scroll);
+			break;
+
+		case WM_PAGE_WINDOW:
+			for (uint16_t i=0; i<pMeter->numSamples; ++i)
 			{
-				if (lcdBuf[position]<'9')
-					nodeNum+=increment;
+				if (i==0 || pMeter->window[i]<lo)
+					lo=pMeter->window[i];
+				if (i==0 || pMeter->window[i]>hi)
+					hi=pMeter->window[i];
+				sum+=pMeter->window[i];
 			}
+			snprintf(lcdBuf, sizeof(lcdBuf), "L%d A%d H%d", lo, 
+				pMeter->numSamples ? (int)(sum/pMeter->numSamples) : 0, hi);
+			wifiMeterLine(pMeter, LCD_LINE2, lcdBuf);
+			break;
+
+		case WM_PAGE_QUALITY:
+			if (pLink->noise_dBm==NW_NO_SIGNAL)
+				snprintf(lcdBuf, sizeof(lcdBuf), "Qual%4u Nse  --", pLink->quality);
 			else
-			{
-				if (lcdBuf[position]>'0')
-					nodeNum-=increment;
-			}
-			sprintf(lcdBuf, "%8u        ", nodeNum);
-			for(unsigned int i=0; i<strlen(lcdBuf); ++i)
-			{
-				if (isdigit(lcdBuf[i]))
-					break;  // found the beginning of the number
-				else if (lcdBuf[i]==' ')
-					lcdBuf[i]='-';
-			}				
-			lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-			lcdPositionCursor(LCD_LINE2, position);
-		}
-		else if (buttons & BTN_SELECT)
-		{
-			if (cancel)
-				nodeNum=0;
+				snprintf(lcdBuf, sizeof(lcdBuf), "Qual%4u Nse%4d", pLink->quality, pLink->noise_dBm);
+			wifiMeterLine(pMeter, LCD_LINE2, lcdBuf);
+			break;
+
+		case WM_PAGE_TX:
+			snprintf(lcdBuf, sizeof(lcdBuf), "TX%4u.%uM Rt%2u/s", pLink->txBitrate_100k/10, 
+				pLink->txBitrate_100k%10, pMeter->retryRate);
+			wifiMeterLine(pMeter, LCD_LINE2, lcdBuf);
 			break;
-		}
 	}
-	
-	lcdCursorEnable(FALSE);
-	
-	return nodeNum;
 }
 
+static void wifiMeterEnter(void *ctx)
+{
+	WifiMeter_t *pMeter=ctx;
+	WifiMeterPage_t page=pMeter->page;
+
+	// Keep the page from last time, start the rest over
+	memset(pMeter, 0, sizeof(*pMeter));
+	pMeter->page=page;
+	lcdClearScreen();
+}
+
+static void wifiMeterEvent(void *ctx, const UiEvent_t *ev)
+{
+	WifiMeter_t *pMeter=ctx;
+
+	if (ev->type!=UI_EV_BUTTON)
+		return;
+	if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pMeter->page=uiWrap(pMeter->page, WM_PAGE_MAX, ev->buttons);
+		pMeter->scrollPos=0;
+		wifiMeterDraw(pMeter);
+	}
+	else if ((ev->buttons & BTN_LEFT) || (ev->buttons & BTN_SELECT))
+		uiPop(0);
+}
+
+static uint64_t wifiMeterTick(void *ctx, uint64_t now)
+{
+	WifiMeter_t *pMeter=ctx;
+
+	wifiMeterSample(pMeter, now);
+	wifiMeterDraw(pMeter);
+	return now+WIFI_METER_MS;
+}
+
+static const UiScreen_t wifiMeterScreen=
+{
+	"wifi meter", wifiMeterEnter, wifiMeterEvent, wifiMeterTick, NULL
+};
 
 /*-----------------------------------------------------------------------------
 Function:
-	scriptsSubmenu   
+	wifiSelectScreen handlers
 Synopsis:
-	Implements scripts submenu to run scripts defined in aslLCD.conf
+	Handler for user to select a wifi network to connect to.  A kept scan
+	is shown straight away; otherwise the scan runs on the prefetch thread
+	with a timer and spinner showing (LEFT gives up waiting.)  Networks
+	are listed strongest first with their signal in dBm.  Once the
+	password is entered wifiJoinScreen takes over.
 Author:
 	John Gedde
 Inputs:
-	None
+	void *ctx: WifiList_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
 Outputs:
-	None
+	uint64_t: next spinner or scroll step
 -----------------------------------------------------------------------------*/
-static void scriptsSubmenu()
+static void wifiSelectShow(WifiList_t *pWifi)
 {
-	uint16_t buttons;
-	const char* s;
-	uint16_t scriptIdx=0;
-	bool isBad=FALSE;
-	char iniBuf[50];
-	char strParam[50];
-	char cmd[256];
-	uint16_t NumScripts=1;
-	int needNodeNum;
-			
+	const NwNet_t *pNet=&pWifi->nets[pWifi->idx];
+	char lcdBuf[NW_SSID_LEN+16];
+
+	pWifi->scrollPos=0;
+	if (strlen(pNet->ssid)<=WIFI_SSID_COLS)
+	{
+		pWifi->scrollIt=FALSE;
+		snprintf(lcdBuf, sizeof(lcdBuf), "%-*s%5d", WIFI_SSID_COLS, pNet->ssid, pNet->signal_dBm);
+		lcdBuf[16]='\0';
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	}
+	else
+	{
+		snprintf(pWifi->displayName, sizeof(pWifi->displayName), "%s %ddBm  ", pNet->ssid, pNet->signal_dBm);  // padded spaces for scrolling
+		pWifi->scrollIt=TRUE;
+		uiTickAt(0);
+	}
+}
+
+static void wifiSelectList(WifiList_t *pWifi, const WifiScan_t *pScan)
+{
+	pWifi->scanning=FALSE;
+	pWifi->numFound=pScan->numFound;
+	memcpy(pWifi->nets, pScan->nets, sizeof(pScan->nets));
+
 	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_select_script", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring(ini, "scripts:script_path0", "");
-	if (strlen(s)==0)
+	if (pWifi->numFound==0)
 	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_script_path", strConfProblem);
-		isBad=TRUE;
+		lcdWriteLn(confStr(STR_MSG_NO_WIFI_AVAILABLE), LCD_LINE1, FALSE);
+		uiPush(&waitKeyScreen, (void *)(uintptr_t)BTN_ANY);
+		return;
 	}
-	
-	s=iniparser_getstring_16(ini, "scripts:script_name0", "");
-	if (strlen(s)==0)
+
+	// Display list of available wifi
+	lcdWriteLn(confStr(STR_WIFI_SELECT_SSID), LCD_LINE1, TRUE);
+	wifiSelectShow(pWifi);
+}
+
+static void wifiSelectEnter(void *ctx)
+{
+	WifiList_t *pWifi=ctx;
+	WifiScan_t scan;
+
+	memset(pWifi, 0, sizeof(*pWifi));
+
+	if (pfPeek(FETCH_WIFI_SCAN, &scan))
 	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_script_name", strConfProblem);		
-		isBad=TRUE;
+		wifiSelectList(pWifi, &scan);
+		return;
 	}
 
-	lcdWriteLn(s, LCD_LINE2, TRUE);	
-	
-	if (isBad)
+	lcdClearScreen();
+	lcdWriteLn(confStr(STR_MSG_SCANNING_FOR_WIFI), LCD_LINE1, TRUE);
+
+	// No prefetch thread - all we can do is wait here
+	pfWant(FETCH_WIFI_SCAN);
+	if (!pfBusy(FETCH_WIFI_SCAN))
 	{
-		for(;;)
-		{
-			if (waitForButton(0, BTN_ANY, BTN_TRIG_EDGE))
-				break;
-		}
+		pfGet(FETCH_WIFI_SCAN, &scan);
+		wifiSelectList(pWifi, &scan);
+		return;
 	}
-	else
+
+	pWifi->scanning=TRUE;
+	pWifi->scanStart=getClock_ms();
+}
+
+static void wifiSelectEvent(void *ctx, const UiEvent_t *ev)
+{
+	WifiList_t *pWifi=ctx;
+	WifiScan_t scan;
+	char ctrlPath[CONF_PATH_LEN+CONF_NAME_LEN+2];
+
+	if (pWifi->scanning)
 	{
-		// Find number of good scripts in conf file
-		for(int i=1; i<=MAX_SCRIPT_IDX; ++i)
-		{
-			isBad=FALSE;
-			sprintf(iniBuf, "scripts:script_path%d", i);
-			s=iniparser_getstring(ini, iniBuf, "");
-			if (strlen(s)==0)
-				isBad=TRUE;
-			sprintf(iniBuf, "scripts:script_name%d", i);
-			s=iniparser_getstring(ini, iniBuf, "");
-			if (strlen(s)==0)
-				isBad=TRUE;
-			if (!isBad)
-				NumScripts++;
-		}
-		
-		for (;;)
+		// Done, or failed (nothing kept and nothing on the way)
+		if (ev->type==UI_EV_DATA && (ev->data & UI_DATA_FETCH))
 		{
-			buttons = waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-			
-			if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-			{
-				if (buttons & BTN_UP)
-				{
-					if (++scriptIdx>=NumScripts)
-						scriptIdx=0;					
-				}
-				else if (scriptIdx==0)
-					scriptIdx=NumScripts-1;
-				else
-					scriptIdx--;				
-				
-				sprintf(iniBuf, "scripts:script_name%u", scriptIdx);
-				s=iniparser_getstring_16(ini, iniBuf, strConfProblem);
-				lcdWriteLn(s, LCD_LINE2, TRUE);
-			}
-			else if (buttons & BTN_SELECT)
+			if (pfPeek(FETCH_WIFI_SCAN, &scan))
+				wifiSelectList(pWifi, &scan);
+			else if (!pfBusy(FETCH_WIFI_SCAN))
 			{
-				sprintf(iniBuf, "scripts:script_param%u", scriptIdx);
-				s=iniparser_getstring(ini, iniBuf, "");
-				strncpy(strParam, s, sizeof(strParam)-1);
-				sprintf(iniBuf, "scripts:script_path%u", scriptIdx);
-				s=iniparser_getstring(ini, iniBuf, "");
-				sprintf(iniBuf, "scripts:script_need_node_num%u", scriptIdx);
-				needNodeNum=iniparser_getint(ini, iniBuf, 0);
-				if (needNodeNum)
-					sprintf(cmd, "%s %s %u", s, strParam, selectedLocalNode);
-				else
-					sprintf(cmd, "%s %s", s, strParam);
-
-				system(cmd);
-				
+				memset(&scan, 0, sizeof(scan));
+				wifiSelectList(pWifi, &scan);
 			}
-			else if (buttons & BTN_LEFT)
-				break;
 		}
+		else if (ev->type==UI_EV_BUTTON && (ev->buttons & BTN_LEFT))
+			uiPop(0);
+		return;
+	}
+
+	if (ev->type==UI_EV_RESULT)
+	{
+		if (ev->from==&textEntryScreen && ev->result)
+		{
+			snprintf(pWifi->pw, sizeof(pWifi->pw), "%s", textEntry.text);
+			snprintf(ctrlPath, sizeof(ctrlPath), "%s/%s", conf->wpaCtrlDir, conf->wifiIface);
+			if (wpaJoin(ctrlPath, pWifi->nets[pWifi->idx].ssid, pWifi->pw, conf->wifiJoinTimeout_s*1000, wifiJoinChanged))
+				uiReplace(&wifiJoinScreen, pWifi);
+			else
+				uiPop(0);
+		}
+		else
+			uiPop(0);
+	}
+	else if (ev->type!=UI_EV_BUTTON)
+		return;
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pWifi->idx=uiWrap(pWifi->idx, pWifi->numFound, ev->buttons);
+		wifiSelectShow(pWifi);
+	}
+	else if (ev->buttons & BTN_SELECT)
+	{
+		teInit(&textEntry, STR_HDG_ENTER_PASSWORD, TE_ANY, 8, MAX_PASSWORD_LEN-1, ' ');
+		uiPush(&textEntryScreen, &textEntry);
 	}
-}	
+	else if (ev->buttons & BTN_LEFT)
+		uiPop(0);
+}
+
+static uint64_t wifiSelectTick(void *ctx, uint64_t now)
+{
+	WifiList_t *pWifi=ctx;
+	char spin[5]="    ";
+	char lcdBuf[32];
+
+	if (!pWifi->scanning)
+		return wifiScrollTick(ctx, now);
+
+	spin[pWifi->spin++ % 4]='.';
+	snprintf(lcdBuf, sizeof(lcdBuf), "%-8.8s%3us%s", conf->wifiIface, (unsigned int)((now-pWifi->scanStart)/1000), spin);
+	lcdBuf[16]='\0';
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	return now+WIFI_SPIN_MS;
+}
+
+static const UiScreen_t wifiSelectScreen=
+{
+	"wifi select", wifiSelectEnter, wifiSelectEvent, wifiSelectTick, NULL
+};
 
- 
 /*-----------------------------------------------------------------------------
 Function:
-	wifiMenuHandler   
+	wifiSaveOldWay
 Synopsis:
-	Implements wifi connect menus
+	Adds the network to the end of the wpa_supplicant conf file.  For when
+	the control socket can't be used, or it couldn't save.  Nothing goes
+	near a shell: the ssid is written in hex, and wpa_supplicant takes a
+	quoted psk up to the last quote on the line so any character the
+	password entry offers is fine.
 Author:
 	John Gedde
 Inputs:
-	None
+	const WifiList_t *pWifi: network picked and password
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void wifiMenuHandler()
+static void wifiSaveOldWay(const WifiList_t *pWifi)
 {
-	const char* s;
-	bool showConn=TRUE;
-	uint16_t buttons;
-		
-	lcdClearScreen();
-	
-	s=iniparser_getstring(ini, "wifi menu:menu_choose_action", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	s=iniparser_getstring(ini, "wifi menu:menu_show_current", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for (;;)
+	const char *ssid=pWifi->nets[pWifi->idx].ssid;
+	FILE *fp;
+
+	fp=fopen(conf->wpaSupplicantFile, "a");
+	if (!fp)
 	{
-		buttons=waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-		if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-		{
-			showConn=!showConn;
-			if (showConn)
-				s=iniparser_getstring(ini, "wifi menu:menu_show_current", strConfProblem);
-			else
-				s=iniparser_getstring(ini, "wifi menu:menu_connect_new", strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		else if (buttons & BTN_LEFT)
-			break;
-		else if (buttons & BTN_SELECT)
-		{
-			if (showConn)
-				showWifiConnection();
-			else
-				selectWifi();			
-			break;
-		}	
-	}	
+		fprintf(stderr, "aslLCD Error: Couldn't open %s: %s\n", conf->wpaSupplicantFile, strerror(errno));
+		return;
+	}
+
+	fprintf(fp, "\nnetwork={\n\tssid=");
+	for (int i=0; ssid[i]; ++i)
+		fprintf(fp, "%02x", (unsigned char)ssid[i]);
+	fprintf(fp, "\n\tpsk=\"%s\"\n}\n", pWifi->pw);
+
+	fflush(fp);
+	fsync(fileno(fp));
+	if (fclose(fp)!=0)
+		fprintf(stderr, "aslLCD Error: Couldn't write %s\n", conf->wpaSupplicantFile);
 }
 
-	
 /*-----------------------------------------------------------------------------
 Function:
-	showWifiConnection   
+	wifiJoinChanged
 Synopsis:
-	Handler for show wifi connection function
+	Called from the wifi join thread at each step
 Author:
 	John Gedde
 Inputs:
@@ -2005,485 +3464,676 @@ Inputs:
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void showWifiConnection()
+static void wifiJoinChanged()
 {
-	char buf[96];
-	FILE *fp=NULL;
-	char *pWifiName;
-	uint16_t scrollPos=0;
-	char lcdBuf[17];
-	const char *s;
-	char cmdBuf[80];
-	uint16_t scrollWait;
-	
+	uiNotify(UI_DATA_WIFI);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wifiJoinScreen handlers
+Synopsis:
+	Progress of joining the network just picked: its name on line 1, a
+	timer and moving dot on line 2 until wpa_supplicant says it's
+	connected or turns it down.  Connected goes away on its own after
+	WIFI_RESULT_MS; a failure stays until a button.  If wpa_supplicant's
+	control socket isn't there the network is added to its conf file and
+	the user asked about rebooting, as before.  Any button leaves while
+	it's still joining; the join carries on.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: WifiList_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next tick
+-----------------------------------------------------------------------------*/
+static void wifiJoinDraw(WifiList_t *pWifi, uint64_t now)
+{
+	WpaStatus_t st;
+	char lcdBuf[32];
+	char spin[5]="    ";
+	ConfStr_t msg;
+
+	wpaStatus(&st);
+	if (!wpaFinished(st.state))
+	{
+		spin[pWifi->spin % 4]='.';
+		snprintf(lcdBuf, sizeof(lcdBuf), "%-8.8s%3us%s", confStr(STR_MSG_WIFI_JOINING), 
+			(unsigned int)((now-pWifi->scanStart)/1000), spin);
+		lcdBuf[16]='\0';
+		lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+		return;
+	}
+
+	pWifi->joined=TRUE;
+	switch (st.state)
+	{
+		case WPA_NO_CTRL:
+			wifiSaveOldWay(pWifi);
+			uiReplace(&textMenuScreen, &rebootMenu);
+			return;
+		case WPA_CONNECTED:
+			if (!st.saved)
+				wifiSaveOldWay(pWifi);
+			snprintf(lcdBuf, sizeof(lcdBuf), "%s %u.%us", confStr(STR_MSG_WIFI_JOINED),
+				st.elapsed_ms/1000, (st.elapsed_ms%1000)/100);
+			lcdBuf[16]='\0';
+			lcdWriteLn(lcdBuf, LCD_LINE2, TRUE);
+			uiTickAt(now+WIFI_RESULT_MS);
+			return;
+		case WPA_WRONG_KEY:
+			msg=STR_MSG_WIFI_WRONG_KEY;
+			break;
+		case WPA_TIMEOUT:
+			msg=STR_MSG_WIFI_TIMEOUT;
+			break;
+		default:
+			msg=STR_MSG_WIFI_FAILED;
+			break;
+	}
+	lcdWriteLn(confStr(msg), LCD_LINE2, TRUE);
+}
+
+static void wifiJoinEnter(void *ctx)
+{
+	WifiList_t *pWifi=ctx;
+
+	pWifi->joined=FALSE;
+	pWifi->spin=0;
+	pWifi->scanStart=getClock_ms();
 	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "messages:msg_getting_info", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "messages:msg_please_wait", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	s=iniparser_getstring(ini, "wifi connect:search_string", "ESSID:");
-	
-	sprintf(cmdBuf, "iwconfig wlan0 | grep %s > /tmp/lcdtempfile", s);
-	system(cmdBuf);
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_current_wifi", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);
-		
-	if ((fp=fopen("/tmp/lcdtempfile", "r"))!=NULL) {
-		fgets(buf, sizeof(buf)-1, fp);
-		fclose(fp);
-		s=iniparser_getstring(ini, "wifi connect:search_string", "ESSID:");
-		pWifiName=strstr(buf, s);
-		if (pWifiName) {
-			strremove(pWifiName, s);
-			if (pWifiName[0]=='\"')
-				pWifiName++;  // Get rid of leading quote
-			s=iniparser_getstring(ini, "wifi connect:no_wifi", "off/any");
-			if (strstr(pWifiName, s)!=NULL) {
-				// we have no wifi.
-				s=iniparser_getstring_16(ini, "messages:msg_no_connections", strConfProblem);
-				lcdWriteLn(s, LCD_LINE2, FALSE);
-				waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-			}
-			else {
-				// terminate at last "
-				for(unsigned int i=0; i<strlen(pWifiName); ++i)	{
-					if (pWifiName[i]=='\"' || iscntrl(pWifiName[i]))
-					{
-						pWifiName[i]='\0';
-						break;
-					}
-				}
-									
-				if (strlen(pWifiName)<=16)
-				{
-					// Just display it
-					lcdWriteLn(pWifiName, LCD_LINE2, FALSE);
-					waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
-				}
-				else {
-					strcat(pWifiName, "   ");  // add a space at the end for scrolling
-					scrollWait=iniparser_getint(ini, "wifi connect:scroll_step_interval_ms", 500);
-					// Scroll it
-					for(;;)	{
-						strncpy(lcdBuf, pWifiName+scrollPos, 16);
-						lcdBuf[16]='\0';						
-						if (strlen(lcdBuf)<16)
-							strncat(lcdBuf, pWifiName, 16-strlen(lcdBuf));
-
-						lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-						
-						if (strlen(pWifiName+scrollPos)>0)
-							scrollPos++;
-						else
-							scrollPos=0;
-						if (waitForButton(scrollWait, BTN_ANY, BTN_TRIG_EDGE))
-							break;
-					}
-				}
-			}
-		}
+	lcdWriteLn(pWifi->nets[pWifi->idx].ssid, LCD_LINE1, TRUE);
+}
+
+static void wifiJoinEvent(void *ctx, const UiEvent_t *ev)
+{
+	WifiList_t *pWifi=ctx;
+
+	if (ev->type==UI_EV_BUTTON)
+		uiPop(0);
+	else if (ev->type==UI_EV_DATA && (ev->data & UI_DATA_WIFI) && !pWifi->joined)
+		uiTickAt(0);
+}
+
+static uint64_t wifiJoinTick(void *ctx, uint64_t now)
+{
+	WifiList_t *pWifi=ctx;
+	WpaStatus_t st;
+
+	if (pWifi->joined)
+	{
+		// Only the connected message times out
+		wpaStatus(&st);
+		if (st.state==WPA_CONNECTED)
+			uiPop(0);
+		return UI_NO_TICK;
 	}
+
+	pWifi->spin++;
+	wifiJoinDraw(pWifi, now);
+	return pWifi->joined ? UI_NO_TICK : now+WIFI_SPIN_MS;
+}
+
+static const UiScreen_t wifiJoinScreen=
+{
+	"wifi join", wifiJoinEnter, wifiJoinEvent, wifiJoinTick, NULL
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	rebootSelect
+Synopsis:
+	After a new wifi connection was done, the Pi needs to reboot to actually
+	connect.  This gives the user the option of rebooting now or later.
+Author:
+	John Gedde
+Inputs:
+	uint16_t idx: 0 for yes, 1 for no
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void rebootSelect(uint16_t idx)
+{
+	if (idx==0)
+		rebootHandler();
+	else
+		uiPop(0);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	menuValid
+Synopsis:
+	Checks a menu that's open is still there after a conf file reload
+	(the tree may have been rearranged) and keeps its item in range
+Author:
+	John Gedde
+Inputs:
+	uint16_t menu: node number of the menu
+Outputs:
+	bool: FALSE if it's gone
+-----------------------------------------------------------------------------*/
+static bool menuValid(uint16_t menu)
+{
+	const AslLcdConf_t *pConf=conf;
+
+	if (menu>=pConf->numMenuNodes || pConf->menu[menu].action!=MA_SUBMENU)
+		return FALSE;
+	if (menuSel[menu]>=pConf->menu[menu].numChildren)
+		menuSel[menu]=0;
+	return TRUE;
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	displayPassword   
+	menuDrawItem / menuDraw
 Synopsis:
-	Handler for display of password while entering one.
+	Shows the item selected in a menu on line 2 / the whole menu.  The
+	main menu heading says so if asterisk is down.
 Author:
 	John Gedde
 Inputs:
-	uint16_t pos: the position in the password to start displaying from...
-	char *pw: the password string.
+	uint16_t menu: node number of the menu
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void displayPassword(uint16_t pos, char* pw)
+static void menuDrawItem(uint16_t menu)
 {
-	char lcdBuf[17];
-	
-	memset(lcdBuf, 0, sizeof(lcdBuf));
-	if (pos<16)
-		strncpy(lcdBuf, pw, 16);
+	const AslLcdConf_t *pConf=conf;
+	const MenuNode_t *pMenu=&pConf->menu[menu];
+
+	if (pMenu->numChildren)
+		lcdWriteLn(pConf->menu[pMenu->firstChild+menuSel[menu]].label, LCD_LINE2, TRUE);
 	else
-		strncpy(lcdBuf, pw+pos-16, 16);
-	lcdBuf[16]='\0';
-	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-	
-	if (pos>15)
-		lcdPositionCursor(LCD_LINE2, 15);
+		lcdWriteLn("", LCD_LINE2, TRUE);
+}
+
+static void menuDraw(uint16_t menu)
+{
+	lcdClearScreen();
+
+	if (menu==MENU_ROOT && !astIsUp())
+		lcdWriteLn(confStr(STR_MSG_ASTERISK_DOWN), LCD_LINE1, TRUE);
 	else
-		lcdPositionCursor(LCD_LINE2, pos);
+		lcdWriteLn(conf->menu[menu].heading, LCD_LINE1, TRUE);
+
+	menuDrawItem(menu);
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	findCharIndex   
+	menuSelect
 Synopsis:
-	Finds the index into an array where the first instance of a character is
-	present.  This function doesn't handle the case where the character is
-	not present.
+	Does what a menu item is set up to do in the conf file
 Author:
 	John Gedde
 Inputs:
-	const char *str: The string to search
-	char c: the character to look for
+	uint16_t item: node number of the item
 Outputs:
-	uint16_t: the array index where the character exists
+	None
 -----------------------------------------------------------------------------*/
-static uint16_t findCharIndex(const char *str, char c)
+static void menuSelect(uint16_t item)
 {
-	uint16_t retval=0;
-	for (uint16_t i=0; i<strlen(str); ++i)
+	const MenuNode_t *pItem=&conf->menu[item];
+
+	switch (pItem->action)
 	{
-		if (str[i]==c)
-		{
-			retval=i;
+		case MA_SUBMENU:
+			if (pItem->numChildren)
+				uiPush(&menuScreen, (void *)(uintptr_t)item);
 			break;
-		}
-	}	
-	return retval;
+		case MA_CONNECT:
+			uiPush(&connectScreen, &nodeConnect);
+			break;
+		case MA_DISCONNECT:
+			connList.disconnect=TRUE;
+			uiPush(&connListScreen, &connList);
+			break;
+		case MA_SHOW_CONNS:
+			connList.disconnect=FALSE;
+			uiPush(&connListScreen, &connList);
+			break;
+		case MA_SET_NODE:
+			openLocalNodeSelect();
+			break;
+		case MA_ACTIVE_NODE:
+			uiPush(&infoScreen, &activeNodeInfo);
+			break;
+		case MA_NUM_CONNS:
+			uiPush(&infoScreen, &numConnsInfo);
+			break;
+		case MA_UP_TIME:
+			uiPush(&upTimeScreen, NULL);
+			break;
+		case MA_SHUTDOWN:
+			doShutdown=TRUE;
+			shutdownNode();
+			uiQuit();
+			break;
+		case MA_REBOOT:
+			rebootHandler();
+			break;
+		case MA_CLOCK:
+			uiPush(&clockScreen, NULL);
+			break;
+		case MA_IP:
+			uiPush(&infoScreen, &ipInfo);
+			break;
+		case MA_CPU_TEMP:
+			uiPush(&cpuTempScreen, NULL);
+			break;
+		case MA_VERSION:
+			uiPush(&infoScreen, &versionInfo);
+			break;
+		case MA_WIFI_CURRENT:
+			uiPush(&wifiMeterScreen, &wifiMeter);
+			break;
+		case MA_WIFI_CONNECT:
+			uiPush(&wifiSelectScreen, &wifiList);
+			break;
+		case MA_BL_TEST:
+			uiPush(&blTestScreen, NULL);
+			break;
+		case MA_SCRIPTS:
+			uiPush(&scriptsScreen, &scriptLists[0]);
+			break;
+		case MA_SCRIPT:
+			runScript(pItem->param);
+			break;
+		case MA_SAY_TIME:
+		case MA_SAY_TIME24:
+		case MA_SAY_IP:
+			runSay(SAY_TIME+(pItem->action-MA_SAY_TIME), pItem->label);
+			break;
+		case MA_QUIT:
+			uiQuit();
+			break;
+		default:
+			break;
+	}
 }
 
 /*-----------------------------------------------------------------------------
 Function:
-	selectWifi   
+	menuPrefetch
 Synopsis:
-	Handler for user to select a wifi network to connect to
+	Asks the prefetch thread for whatever selecting a menu item is going to
+	need.  For a submenu that's what any of its items need.
 Author:
 	John Gedde
 Inputs:
-	None
+	uint16_t item: node number of the item
+	bool children: TRUE to look into a submenu's items
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void selectWifi()
+static void menuPrefetch(uint16_t item, bool children)
 {
-	char buf[128];
-	const char *s;
-	char wifiNames[MAX_WIFI_COUNT][MAX_WIFI_NAME_LEN] = { 0 };
-	char *pWifiName;
-	FILE *fp;
-	uint16_t nameIdx=0;
-	uint16_t NumFound=0;
-	bool scrollIt=FALSE;
-	uint16_t scrollWait;
-	char lcdBuf[17];
-	uint16_t scrollPos=0;
-	uint16_t buttons;
-	char pw[MAX_PASSWORD_LEN];
-	bool gotPW;
-	char cmdBuf[256];
-	char displayName[128];
-	
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "messages:msg_scanning_for_wifi", strConfProblem);			
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	
-	s=iniparser_getstring_16(ini, "messages:msg_please_wait", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	// Get list of available wifi from system
-	s=iniparser_getstring(ini, "wifi connect:search_string", "ESSID:");	
-	sprintf(buf, "iwlist wlan0 scanning | grep %s > /tmp/lcdtempfile", s);
-	system(buf);
-	
-	// lcdtempfile should now have list of available wifi names
-	fp=fopen("/tmp/lcdtempfile", "r");
-	if (fp)
+	const MenuNode_t *pItem=&conf->menu[item];
+
+	switch (pItem->action)
 	{
-		// Read each line, up to a maximum number of lines
-		while (!feof(fp) && nameIdx<MAX_WIFI_COUNT)
-		{
-			if (fgets(buf, sizeof(buf)-1, fp))
+		case MA_SHOW_CONNS:
+		case MA_DISCONNECT:
+		case MA_NUM_CONNS:
+			pfWant(FETCH_LINKS);
+			break;
+		case MA_CONNECT:
+		case MA_SET_NODE:
+			pfWant(FETCH_LOCAL_NODES);
+			break;
+		case MA_WIFI_CONNECT:
+			pfWant(FETCH_WIFI_SCAN);
+			break;
+		case MA_SUBMENU:
+			if (children)
 			{
-				pWifiName=strstr(buf, s);  // Search for ESSID: 
-				if (pWifiName)
-				{
-					strremove(pWifiName, s);
-					pWifiName++;  // Get rid of leading quote					
-					// terminate at last "
-					for(uint16_t i=0; i<strlen(pWifiName); ++i)
-					{
-						if (pWifiName[i]=='\"' || iscntrl(pWifiName[i]))
-						{
-							pWifiName[i]='\0';
-							break;
-						}
-					}
-					if (pWifiName[0])
-					{
-						// Add to list
-						strncpy(wifiNames[nameIdx], pWifiName, MAX_WIFI_NAME_LEN-1);
-						nameIdx++;
-					}
-				}
+				for (uint16_t i=0; i<pItem->numChildren; ++i)
+					menuPrefetch(pItem->firstChild+i, FALSE);
 			}
+			break;
+		default:
+			break;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	menuScreen handlers
+Synopsis:
+	A menu from the tree in the conf file; the main menu is node
+	MENU_ROOT.  UP/DOWN through the items, SELECT does one, LEFT goes back
+	to the menu above.  Submenus start at their first item each time; the
+	main menu stays where it was left.  Once the cursor has sat on an item
+	for FETCH_DWELL_MS the tick starts prefetching what it needs, so scrolling
+	past items doesn't set off a pile of fetches.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: node number of the menu
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next tick
+-----------------------------------------------------------------------------*/
+static void menuEnter(void *ctx)
+{
+	uint16_t menu=(uint16_t)(uintptr_t)ctx;
+
+	if (menu!=MENU_ROOT)
+		menuSel[menu]=0;
+	menuValid(menu);
+	menuDraw(menu);
+	uiTickAt(getClock_ms()+FETCH_DWELL_MS);
+}
+
+static void menuEvent(void *ctx, const UiEvent_t *ev)
+{
+	uint16_t menu=(uint16_t)(uintptr_t)ctx;
+	const MenuNode_t *pMenu;
+
+	if (ev->type==UI_EV_RESULT || ev->type==UI_EV_DATA)
+	{
+		// Back from selecting the local node
+		if (ev->type==UI_EV_RESULT && ev->from==&nodeListScreen && ev->result)
+		{
+			selectedLocalNode=ev->result;
+			pfInvalidate(FETCH_LINKS);
+			uiNotify(UI_DATA_NODE);
 		}
-		NumFound=nameIdx;
-		fclose(fp);
+
+		if (!menuValid(menu))
+			uiPop(UI_CANCEL);
+		else if (ev->type==UI_EV_RESULT || (ev->data & UI_DATA_CONF) ||
+				 (menu==MENU_ROOT && (ev->data & UI_DATA_ASTERISK)))
+			menuDraw(menu);
+		uiTickAt(getClock_ms()+FETCH_DWELL_MS);
+		return;
 	}
-	
-	if (NumFound==0)
+	if (ev->type!=UI_EV_BUTTON)
+		return;
+
+	// The conf file may have been swapped since the last UI_DATA_CONF
+	if (!menuValid(menu))
 	{
-		s=iniparser_getstring_16(ini, "messages:msg_no_wifi_available", strConfProblem);
-		lcdWriteLn(s, LCD_LINE1, FALSE);
-		waitForButton(0, BTN_ANY, BTN_TRIG_EDGE);
+		uiPop(UI_CANCEL);
+		return;
 	}
-	else
+	pMenu=&conf->menu[menu];
+	if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
 	{
-		// Display list of available wifi
-		scrollWait=iniparser_getint(ini, "wifi connect:scroll_step_interval_ms", 500);
-		nameIdx=0;
-		pWifiName=wifiNames[0];
-		if (strlen(pWifiName)<=16)
-			lcdWriteLn(pWifiName, LCD_LINE2, FALSE);
-		else
-		{
-			strcpy(displayName, pWifiName);
-			strcat(displayName, "  ");  // padded spaces for scrolling
-			scrollIt=TRUE;
-		}
-		s=iniparser_getstring_16(ini, "wifi menu:menu_select_ssid", strConfProblem);
-		lcdWriteLn(s, LCD_LINE1, TRUE);
-		
-		for(;;)
+		if (pMenu->numChildren)
 		{
-			if (scrollIt)
-			{
-				strncpy(lcdBuf, displayName+scrollPos, 16);
-				lcdBuf[16]='\0';						
-				if (strlen(lcdBuf)<16)
-					strncat(lcdBuf, displayName, 16-strlen(lcdBuf));
-
-				lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
-		
-				if (strlen(displayName+scrollPos)>0)
-					scrollPos++;
-				else
-					scrollPos=0;
-			}
-			buttons = waitForButton(scrollWait, BTN_ANY, BTN_TRIG_EDGE);
-			if ((buttons & BTN_UP) || (buttons & BTN_DOWN))
-			{
-				if (buttons & BTN_UP)
-				{
-					if (++nameIdx>=NumFound)
-						nameIdx=0;					
-				}
-				else if (nameIdx==0)
-					nameIdx=NumFound-1;
-				else
-					nameIdx--;	
-				pWifiName=wifiNames[nameIdx];
-				scrollPos=0;
-				if (strlen(pWifiName)<=16)
-				{
-					scrollIt=FALSE;
-					lcdWriteLn(pWifiName, LCD_LINE2, FALSE);
-				}
-				else
-				{
-					strcpy(displayName, pWifiName);
-					strcat(displayName, "  ");  // padded spaces for scrolling
-					scrollIt=TRUE;
-				}
-			}
-			else if (buttons & BTN_SELECT)
-			{
-				gotPW=getWifiPassword(pw);
-				if (gotPW)
-				{					
-					s=iniparser_getstring(ini, "wifi connect:wpa_supplicant_file", "/etc/wpa_supplicant/wlan0.conf");
-					sprintf(cmdBuf, "wpa_passphrase \"%s\" \"%s\" >> %s", pWifiName, pw, s);
-					system(cmdBuf);
-					postConnectReboot();
-				}
-				break;
-			}
-			else if (buttons & BTN_LEFT)
-				break;
+			menuSel[menu]=uiWrap(menuSel[menu], pMenu->numChildren, ev->buttons);
+			menuDrawItem(menu);
+			uiTickAt(getClock_ms()+FETCH_DWELL_MS);
 		}
 	}
+	else if (ev->buttons & BTN_SELECT)
+	{
+		if (pMenu->numChildren)
+			menuSelect(pMenu->firstChild+menuSel[menu]);
+	}
+	else if ((ev->buttons & BTN_LEFT) && menu!=MENU_ROOT)
+		uiPop(UI_CANCEL);
+}
+
+static uint64_t menuTick(void *ctx, uint64_t now)
+{
+	uint16_t menu=(uint16_t)(uintptr_t)ctx;
+	const MenuNode_t *pMenu;
+
+	(void)now;
+	if (!menuValid(menu))
+		return UI_NO_TICK;
+	pMenu=&conf->menu[menu];
+	if (pMenu->numChildren && menuSel[menu]<pMenu->numChildren)
+		menuPrefetch(pMenu->firstChild+menuSel[menu], TRUE);
+	return UI_NO_TICK;
 }
 
+static const UiScreen_t menuScreen=
+{
+	"menu", menuEnter, menuEvent, menuTick, NULL
+};
 
 /*-----------------------------------------------------------------------------
 Function:
-	getWifiPassword   
+	dashSample
 Synopsis:
-	Handler for user to select a wifi network to connect to
+	Gets fresh values for the dashboard fields that are in use.  The cheap
+	ones are read every time; links are fetched in the background and the
+	CPU temperature is the sampler's latest reading.
 Author:
 	John Gedde
 Inputs:
-	char *pw: pointer to the password string that will contain the entered
-	password.
+	Dash_t *pDash: the dashboard
 Outputs:
-	bool: TRUE if password was entered, FALSE if user cancelled.
+	Dash_t *pDash: new values
 -----------------------------------------------------------------------------*/
-static bool getWifiPassword(char *pw)
+static void dashSample(Dash_t *pDash)
 {
-	static const char wifiPasswordChars[]={" 0123456789abcdefghijklmnopqrstuvwxyxABCDEFGHIJKLMNOPQRSTUVWXYZ!\"#$%&\'()*+-./:;<=>?@[]_"};
-	int16_t pos=0;
-	uint16_t charIdx=0;
-	uint16_t buttons;
-	const char* s;
-	uint64_t pressStartTime;
-	bool lastWasUD=FALSE;
-	uint16_t FastUpDownWaitms;
-	uint16_t FastUpDownRatems;
-	bool retval=FALSE;
-	
-	FastUpDownWaitms=iniparser_getint(ini, "wifi connect:fast_up_down_wait_ms", 2000);
-	FastUpDownRatems=iniparser_getint(ini, "wifi connect:fast_up_down_rate_ms", 200);
-	
-	memset(pw, ' ', MAX_PASSWORD_LEN-1);
-	pw[MAX_PASSWORD_LEN-1]='\0';
-	
-	lcdClearScreen();
-	
-	s=iniparser_getstring_16(ini, "headings:hdg_enter_password", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, FALSE);	
-	
-	lcdCursorEnable(true);
-	lcdPositionCursor(LCD_LINE2, 0);
-	
-	for(;;)
+	uint32_t fields=conf->dashFields;
+	DashValues_t *pVals=&pDash->vals;
+	NodeConns_t nodeConns;
+	uint16_t status=__atomic_load_n(&nodeStatus, __ATOMIC_RELAXED);
+	time_t t;
+	struct tm *localT;
+	CtStats_t temps;
+	float fVal;
+
+	if (fields & DASH_FIELD_BIT(DF_NODE))
+		sprintf(pVals->str[DF_NODE], "%u", selectedLocalNode);
+
+	// Links come from the prefetch thread so asking asterisk never holds
+	// up the buttons.  The last count stays up until a new one is in.
+	if (fields & DASH_FIELD_BIT(DF_LINKS))
+	{
+		if (pfPeek(FETCH_LINKS, &nodeConns))
+			sprintf(pVals->str[DF_LINKS], "%u", nodeConns.numNodes);
+		else
+			pfWant(FETCH_LINKS);
+	}
+
+	if (fields & (DASH_FIELD_BIT(DF_TEMP) | DASH_FIELD_BIT(DF_TEMPF)))
 	{
-		if (lastWasUD && getClock_ms()>(pressStartTime+FastUpDownWaitms))
+		if (ctStats(&temps))
 		{
-			buttons=waitForButton(50, BTN_ANY, BTN_TRIG_LEVEL);
-			if (buttons==0)
-				lastWasUD=FALSE;
-			delay(FastUpDownRatems);
+			fVal=temps.now_dC/10.0f;
+			sprintf(pVals->str[DF_TEMP], "%.0f", fVal);
+			sprintf(pVals->str[DF_TEMPF], "%.0f", CtoF(fVal));
 		}
 		else
-			buttons=waitForButton(50, BTN_ANY, BTN_TRIG_EDGE);
-		
-		if (buttons & BTN_UP || buttons & BTN_DOWN)
 		{
-			if (lastWasUD==FALSE)
-			{
-				pressStartTime=getClock_ms();
-			}
-			if (buttons & BTN_UP)
-			{
-				if (++charIdx>=sizeof(wifiPasswordChars)-1)
-					charIdx=0;
-			}
-			else if (charIdx==0)
-				charIdx=sizeof(wifiPasswordChars)-2;
-			else
-				charIdx--;
-			pw[pos]=wifiPasswordChars[charIdx];
-			displayPassword(pos, pw);
-			lastWasUD=TRUE;
+			strcpy(pVals->str[DF_TEMP], "--");
+			strcpy(pVals->str[DF_TEMPF], "--");
 		}
-		else if (buttons & BTN_LEFT)
+	}
+
+	if ((fields & DASH_FIELD_BIT(DF_IP)) && pDash->ipStale)
+	{
+		getIPaddress(pVals->str[DF_IP]);
+		pDash->ipStale=FALSE;
+	}
+
+	if (fields & (DASH_FIELD_BIT(DF_TIME) | DASH_FIELD_BIT(DF_DATE)))
+	{
+		t=time(NULL);
+		localT=localtime(&t);
+		if (conf->clock24)
+			strftime(pVals->str[DF_TIME], sizeof(pVals->str[DF_TIME]), "%H:%M", localT);
+		else
+			sprintf(pVals->str[DF_TIME], "%2d:%02d",
+				(localT->tm_hour % 12) ? localT->tm_hour % 12 : 12, localT->tm_min);
+		strftime(pVals->str[DF_DATE], sizeof(pVals->str[DF_DATE]), "%b %d", localT);
+	}
+
+	strcpy(pVals->str[DF_AST], astIsUp() ? "Up" : "Down");
+	strcpy(pVals->str[DF_RX], (status & COS_UP) ? "RX" : "");
+	strcpy(pVals->str[DF_TX], (status & PTT_UP) ? "TX" : "");
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dashShow
+Synopsis:
+	Draws the current dashboard page; only what changed unless all is set
+Author:
+	John Gedde
+Inputs:
+	Dash_t *pDash: the dashboard
+	bool all: TRUE to draw the whole page
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void dashShow(Dash_t *pDash, bool all)
+{
+	const DashPage_t *pPage=&conf->dashPages[pDash->page];
+
+	dashDraw(&pPage->line[0], LCD_LINE1, &pDash->vals, &pDash->drawn[0], all);
+	dashDraw(&pPage->line[1], LCD_LINE2, &pDash->vals, &pDash->drawn[1], all);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	dashScreen handlers
+Synopsis:
+	The idle dashboard, opened by uiPoll() when the buttons haven't been
+	touched for a while.  Pages change every page_time_s, or with UP/DOWN.
+	Any other button goes back to the menu it was opened from.  Fields are
+	redrawn only when their value changes.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: Dash_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next tick
+-----------------------------------------------------------------------------*/
+static void dashEnter(void *ctx)
+{
+	Dash_t *pDash=ctx;
+	uint64_t now=getClock_ms();
+
+	pDash->page=0;
+	pDash->pageStart=now;
+	pDash->ipStale=TRUE;
+
+	dashSample(pDash);
+	dashShow(pDash, TRUE);
+}
+
+static void dashEvent(void *ctx, const UiEvent_t *ev)
+{
+	Dash_t *pDash=ctx;
+
+	if (ev->type==UI_EV_DATA)
+	{
+		if (ev->data & UI_DATA_NET)
+			pDash->ipStale=TRUE;
+
+		if (ev->data & UI_DATA_CONF)
 		{
-			if (pos>-1)
-				pos--;
-			if (pos==-1)
-			{
-				s=iniparser_getstring_16(ini, "messages:msg_cancel_prompt", strConfProblem);
-				lcdWriteLn(s, LCD_LINE2, FALSE);
-				lcdCursorEnable(FALSE);
-			}
-			else
+			if (conf->numDashPages==0)
 			{
-				displayPassword(pos, pw);
-				charIdx=findCharIndex(wifiPasswordChars, pw[pos]);
+				uiPop(0);
+				return;
 			}
-			lastWasUD=FALSE;
-		}
-		else if (buttons & BTN_RIGHT)
-		{
-			lcdCursorEnable(TRUE);
-			if (pos<MAX_PASSWORD_LEN-1)
-				pos++;
-			displayPassword(pos, pw);
-			charIdx=findCharIndex(wifiPasswordChars, pw[pos]);
-			lastWasUD=FALSE;
+			if (pDash->page>=conf->numDashPages)
+				pDash->page=0;
+			pDash->ipStale=TRUE;
+			dashSample(pDash);
+			dashShow(pDash, TRUE);
 		}
-		else if (buttons & BTN_SELECT)
-		{
-			if (pos>-1)
-			{
-				for(uint16_t i=strlen(pw)-1; i; --i)
-				{
-					if (isspace(pw[i]))
-						pw[i]='\0';
-					else
-						break;
-				}
-				if (strlen(pw)<8)
-				{
-					s=iniparser_getstring_16(ini, "messages:msg_at_least_8_chars", strConfProblem);
-					lcdWriteLn(s, LCD_LINE1, FALSE);
-					continue;
-				}
-				retval=TRUE;
-			}	
-			lcdCursorEnable(FALSE);
-			break;
-		}		
+		else
+			uiTickAt(0);
+	}
+	else if (ev->type!=UI_EV_BUTTON)
+		return;
+	else if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		pDash->page=uiWrap(pDash->page, conf->numDashPages, ev->buttons);
+		pDash->pageStart=getClock_ms();
+		dashShow(pDash, TRUE);
+	}
+	else
+		uiPop(0);
+}
+
+static uint64_t dashTick(void *ctx, uint64_t now)
+{
+	Dash_t *pDash=ctx;
+	uint64_t pageTime=(uint64_t)conf->dashPage_s*1000;
+	bool newPage=FALSE;
+
+	if (pageTime && conf->numDashPages>1 && now>=pDash->pageStart+pageTime)
+	{
+		pDash->page=uiWrap(pDash->page, conf->numDashPages, BTN_UP);
+		pDash->pageStart=now;
+		newPage=TRUE;
 	}
-	return retval;
-}		
+
+	dashSample(pDash);
+	dashShow(pDash, newPage);
+
+	return now+DASH_TICK_MS;
+}
+
+static const UiScreen_t dashScreen=
+{
+	"dashboard", dashEnter, dashEvent, dashTick, NULL
+};
 
 /*-----------------------------------------------------------------------------
 Function:
-	postConnectReboot   
+	uiPoll
 Synopsis:
-	After a new wifi connection was done, the Pi needs to reboot to actually
-	connect.  This gives the user the option of rebooting now or later.
+	Called by the UI loop every pass.  Turns conf file reloads and asterisk
+	going up or down into UI_DATA_XXX changes for whatever is showing.
+	Opens the dashboard if a menu has been left alone long enough.
 Author:
 	John Gedde
 Inputs:
-	None	
+	None
 Outputs:
 	None
 -----------------------------------------------------------------------------*/
-static void postConnectReboot()
+static void uiPoll()
 {
-	const char *s;
-	bool yesNo=TRUE;
-	uint16_t buttons;
-	
-	s=iniparser_getstring_16(ini, "wifi menu:menu_reboot", strConfProblem);
-	lcdWriteLn(s, LCD_LINE1, TRUE);
-	s=iniparser_getstring_16(ini, "messages:msg_yes", strConfProblem);
-	lcdWriteLn(s, LCD_LINE2, TRUE);
-	
-	for(;;)
+	static uint32_t confGen=0;
+	static bool astWasUp=FALSE;
+	static bool first=TRUE;
+
+	if (first)
 	{
-		buttons=waitForButton(50, BTN_ANY, BTN_TRIG_EDGE);
-		if (buttons & BTN_UP || buttons & BTN_DOWN)
-		{
-			yesNo=!yesNo;
-			if (yesNo)
-				s=iniparser_getstring_16(ini, "messages:msg_yes", strConfProblem);
-			else
-				s=iniparser_getstring_16(ini, "messages:msg_no", strConfProblem);
-			lcdWriteLn(s, LCD_LINE2, TRUE);
-		}
-		else if (buttons & BTN_SELECT)
-		{
-			if (yesNo)
-				rebootHandler();
-			else
-				break;
-		}
+		confGen=conf->generation;
+		astWasUp=astIsUp();
+		first=FALSE;
 	}
-}
-	
 
+	// Conf file changed - show the new text
+	if (conf->generation!=confGen)
+	{
+		confGen=conf->generation;
+		pfSetFresh(FETCH_WIFI_SCAN, conf->wifiScanCache_s*1000);
+		uiNotify(UI_DATA_CONF);
+	}
 
+	// Asterisk went down or came back
+	if (astIsUp()!=astWasUp)
+	{
+		astWasUp=!astWasUp;
+		uiNotify(UI_DATA_ASTERISK);
+	}
+	
+	// Only from a menu - don't take over a screen someone is looking at
+	if (conf->dashIdle_s && conf->numDashPages && uiTop()==&menuScreen &&
+		uiIdle_ms()>=(uint64_t)conf->dashIdle_s*1000)
+		uiPush(&dashScreen, &dash);
+}
 
 /*-----------------------------------------------------------------------------
 Function:
@@ -2503,17 +4153,23 @@ static void rebootHandler()
 	
 	blThreadKill=TRUE;
 	pthread_join(backlightColorStatusThread, NULL);
+	astStopWatch();
+	ctStop();
+	acStop();
+	srStop();
+	wpaStop();
+	pfStop();
 	
 	lcdShutdown();	
-	
-	// clean up
-	remove("/tmp/lcdtempfile");
+	shmClose();
 
-	s=iniparser_getstring(ini, "reboot:script", "");
+	s=conf->rebootScript;
 	system(s);	
 	
-	// Close out ini - if we actually get here
-	iniparser_freedict(ini);
+	// Close out ini - if we actually get here.  Everything's shut down
+	// so there's nothing to go back to.
+	closeIni();
+	exit(0);
 }
 
 
@@ -2532,43 +4188,51 @@ Outputs:
 -----------------------------------------------------------------------------*/
 int main()
 {
-	uint16_t buttons;
-	uint16_t menu_num=0;
-	States_t state=STATE_MAIN_MENU;
-	char temp[32];
-	const char* s;
 	int16_t threadRes=-1;
-	bool done=FALSE;
-	bool doShutdown=FALSE;	
+	uint64_t start_us;
+	pthread_t startupThread;
 	
 	//signal(SIGINT, shutdownHandler);
 	
-	// initialize conf file access. 
-	// (using iniparser library from N. Devillard)
-	// (https://github.com/ndevilla/iniparser)
+	start_us=getClock_us();
+	
+	// read the conf file and reload it if it changes
 	initIni("/etc/aslLCD.conf");
+	startConfWatch();
+	rnLoad(conf->recentFile, conf->recentHalfLife_h);
 	
-	// initialize LCD
+	// initialize LCD and get the splash screen up before anything slow
 	if (initLCD() != 0)
 	{
 		fprintf(stderr, "aslLCD Error: Error initializing LCD\n");
 		exit(-1);
 	}
+	drawStartup();
+	fprintf(stderr, "aslLCD: First frame in %u ms\n", (unsigned int)((getClock_us()-start_us)/1000));
 	
-	// Check to see if asterisk is up
-	if (access("/var/run/asterisk.ctl", F_OK) != 0)
+	// status in shared memory for other programs
+	if (conf->statusShm)
 	{
-		fprintf(stderr, "aslLCD Error: Asterisk needs to be running first!");
-		exit(-1);
+		shmInit();
+		shmPublishStatus(0, selectedLocalNode);
 	}
 	
-	// initialize selected local node
-	selectedLocalNode=initLocalNodeSel();
+	// CPU temperature readings for the screen, dashboard, backlight and
+	// status segment.  The first one is published straight away, so the
+	// segment has to be there first.
+	ctStart();
+	
+	// Asterisk and the local node list come in the background
+	if (pthread_create(&startupThread, NULL, startupThreadFn, NULL)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create startup thread\n");
+		exit(-1);
+	}
 		
-	menu_num=iniparser_getint(ini, "main menu:default_startup_menu", 0);
+	menuSel[MENU_ROOT]=conf->defaultStartupMenu;
 
 	// if enabled, start the backlight control thread
-	if (iniparser_getint(ini, "backlight:status_backlight", 0))
+	if (conf->statusBacklight)
 	{
 		threadRes=pthread_create(&backlightColorStatusThread, NULL, backlightColorStatusThreadFn, NULL);
 		if (threadRes!=0)
@@ -2578,119 +4242,42 @@ int main()
 		}
 	}
 
-	displayStartup();
-	displayMainMenu(menu_num);
+	// Leave the splash up for its time.  Any key skips it.
+	waitForButton(conf->startupDisp_ms, BTN_ANY, BTN_TRIG_EDGE);
 	
-	// Main loop
-	while(!done)
-	{
-		buttons=waitForButton(50, BTN_ANY, TRUE);
-		
-		switch (state)
-		{
-			case STATE_MAIN_MENU:
-				// Handle menu changes
-				if ((buttons & BTN_UP || buttons & BTN_DOWN))
-				{
-					if (buttons & BTN_UP)
-					{
-						if (menu_num<MM_MAX-1)
-							menu_num++;
-						else
-							menu_num=0;
-					}						
-					else if (menu_num==0)
-						menu_num=MM_MAX-1;
-					else 
-						menu_num--;
-					
-					sprintf(temp, "main menu:main_menu%d", menu_num);
-					s = iniparser_getstring_16(ini, temp, strConfProblem);
-					lcdWriteLn(s, LCD_LINE2, TRUE);
-				} 
-				else if (buttons & BTN_SELECT)
-				{
-					// Do selected action
-					switch (menu_num)
-					{
-						case MM_SHUTDOWN_NODE:
-							done=TRUE;
-							doShutdown=TRUE;
-							shutdownNode();
-							break;	
-						case MM_REBOOT_NODE:
-							rebootHandler();
-							break;
-						case MM_WIFI_CONNECT:
-							wifiMenuHandler();
-							break;					
-						case MM_SHOW_ACTIVE_LOCALNODE:
-							displayActiveLocalNode();
-							state = STATE_WAIT_FOR_RETURN;
-							break;						
-						case MM_SET_ACTIVE_LOCALNODE:
-							selActiveLocalNode();
-							break;								
-						case MM_VIEW_NODE_INFO:
-							nodeInfoSubmenu();
-							break;							
-						case MM_NODE_CONNECT:
-							nodeConnectSubmenu();
-							break;							
-						case MM_NODE_DISCONNECT:
-							nodeDisconnect();
-							break;						
-						case MM_SHOW_CONNECTIONS:
-							showConnections();
-							break;							
-						case MM_BACKLIGHT_TEST:
-							blColorTest();
-							break;	
-						case MM_SCRIPTS:
-							scriptsSubmenu();
-							break;	
-						case MM_QUIT_LCD:
-							done=TRUE;
-							break;							
-						case MM_OTHER_INFO:
-							displayOtherInfo();
-							break;												
-						default:
-							menu_num=0;
-							break;
-					}
-					if (state != STATE_WAIT_FOR_RETURN)
-						displayMainMenu(menu_num);
-				}
-				break;
-				
-			case STATE_WAIT_FOR_RETURN:
-				if (buttons & BTN_LEFT || buttons & BTN_SELECT)
-				{
-					displayMainMenu(menu_num);					
-					state = STATE_MAIN_MENU;
-				}
-				break;
-				
-			default:
-				// Ought not to ever get here, buuuuut...
-				state = STATE_MAIN_MENU;
-				menu_num=0;
-				displayStartup();			
-				break;
-		}
-	}
+	// Menus need asterisk
+	if (!__atomic_load_n(&startupDone, __ATOMIC_ACQUIRE))
+		lcdWriteLn(confStr(STR_MSG_WAITING_ASTERISK), LCD_LINE2, TRUE);
+	pthread_join(startupThread, NULL);
+	fprintf(stderr, "aslLCD: Ready in %u ms\n", (unsigned int)((getClock_us()-start_us)/1000));
+	
+	// From here on notice asterisk restarting
+	astStartWatch(astResync);
+	
+	// Slow menu data can be fetched ahead of time from here on
+	pfStart(pfSources, FETCH_MAX, fetchDone);
+	pfSetFresh(FETCH_WIFI_SCAN, conf->wifiScanCache_s*1000);
+	acStart(astLinked, astCmdDone);
+	srStart(scriptChanged);
+	
+	// Run the menus until the user quits or shuts down
+	uiPush(&menuScreen, (void *)(uintptr_t)MENU_ROOT);
+	uiRun(uiPoll);
 	
 	blThreadKill=TRUE;
 	pthread_join(backlightColorStatusThread, NULL);
+	astStopWatch();
+	ctStop();
+	acStop();
+	srStop();
+	wpaStop();
+	pfStop();
 	
 	lcdShutdown();
-	
-	// clean up
-	remove("/tmp/lcdtempfile");
+	shmClose();
 	
 	// Close out ini
-	iniparser_freedict(ini);
+	closeIni();
 	
 	if (doShutdown)
 		system("/usr/bin/poweroff");
@@ -2698,3 +4285,4 @@ int main()
 	return(0);
 }
 
+
@@ -0,0 +1,90 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  menu.h
+*
+*  Synopsis:	Header file for menu.c.  The menu tree is kept as one array
+*				of MenuNode_t.  Node 0 is the main menu and the children of
+*				any submenu are next to each other, so moving through a
+*				menu is just adding to an index.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  say_time, say_time24, say_ip actions
+*
+****************************************************************************/
+
+#ifndef _MENU
+#define _MENU
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MENU_LABEL_LEN			16		// one LCD line
+#define MENU_MAX_NODES			64
+#define MENU_MAX_ITEMS			20		// item1..item20 in each menu
+#define MENU_MAX_DEPTH			4		// main menu plus 3 levels of submenus
+#define MENU_ROOT				0
+
+// What a menu item does when selected
+typedef enum
+{
+	MA_SUBMENU=0,
+	MA_CONNECT,
+	MA_DISCONNECT,
+	MA_SHOW_CONNS,
+	MA_SET_NODE,
+	MA_ACTIVE_NODE,
+	MA_NUM_CONNS,
+	MA_UP_TIME,
+	MA_SHUTDOWN,
+	MA_REBOOT,
+	MA_CLOCK,
+	MA_IP,
+	MA_CPU_TEMP,
+	MA_VERSION,
+	MA_WIFI_CURRENT,
+	MA_WIFI_CONNECT,
+	MA_BL_TEST,
+	MA_SCRIPTS,
+	MA_SCRIPT,
+	MA_QUIT,
+	MA_SAY_TIME,
+	MA_SAY_TIME24,
+	MA_SAY_IP,
+	MA_MAX
+} MenuAction_t;
+
+typedef struct
+{
+	char label[MENU_LABEL_LEN+1];
+	char heading[MENU_LABEL_LEN+1];		// line 1 when it's a submenu
+	uint8_t action;						// MenuAction_t
+	uint8_t param;						// MA_SCRIPT: index into scripts[]
+	uint16_t parent;
+	uint16_t firstChild;
+	uint16_t numChildren;
+} MenuNode_t;
+
+#endif
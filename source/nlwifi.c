@@ -0,0 +1,682 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  nlwifi.c
+*
+*  Synopsis:	Wifi scanning over nl80211 (generic netlink), so there's no
+*				iwlist to start and parse.  Only plain netlink sockets are
+*				used - no libnl.  A scan is asked for, the scan results
+*				event waited for, then the kernel's BSS list read back.
+*
+*				nwLink() reads the current link (station info and
+*				/proc/net/wireless) quickly enough to call several times
+*				a second.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  nwLink() for the link quality meter
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/nl80211.h>
+
+#include "nlwifi.h"
+#include "main.h"
+#include "clockfunc.h"
+
+#define NW_BUF_LEN			32768		// biggest dump message the kernel sends
+#define NW_PROC_WIRELESS	"/proc/net/wireless"
+#define NW_REPLY_MS			2000		// longest to wait for an answer
+
+#define NW_DATA(a)			((const void *)((const char *)(a)+NLA_HDRLEN))
+#define NW_LEN(a)			((int)(a)->nla_len-NLA_HDRLEN)
+
+// A request: headers and a few attributes
+typedef struct
+{
+	struct nlmsghdr nh;
+	struct genlmsghdr gh;
+	char attrs[128];
+} NwMsg_t;
+
+// Where the scan results go
+typedef struct
+{
+	NwNet_t *pNets;
+	int max;
+	int num;
+} NwList_t;
+
+typedef struct
+{
+	uint16_t family;
+	uint32_t scanGroup;
+} NwFamily_t;
+
+static uint32_t nwSeq=0;
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwOpen
+Synopsis:
+	Opens a generic netlink socket.  Replies that take longer than
+	NW_REPLY_MS are given up on.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	int: the socket, -1 if it couldn't be had
+-----------------------------------------------------------------------------*/
+static int nwOpen()
+{
+	int fd;
+	struct sockaddr_nl sa;
+	struct timeval tv={ NW_REPLY_MS/1000, (NW_REPLY_MS%1000)*1000 };
+
+	if ((fd=socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC))<0)
+		return -1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.nl_family=AF_NETLINK;
+	if (bind(fd, (struct sockaddr *)&sa, sizeof(sa))<0)
+	{
+		close(fd);
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+	return fd;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwMsgInit / nwMsgAttr
+Synopsis:
+	Builds a request.  Attributes are added one after another.
+Author:
+	John Gedde
+Inputs:
+	NwMsg_t *pMsg: the request
+	uint16_t type: netlink family (init), attribute type (attr)
+	uint16_t flags: NLM_F_XXX on top of NLM_F_REQUEST
+	uint8_t cmd: generic netlink command
+	const void *data: attribute value
+	uint16_t len: size of data
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void nwMsgInit(NwMsg_t *pMsg, uint16_t type, uint16_t flags, uint8_t cmd)
+{
+	memset(pMsg, 0, sizeof(*pMsg));
+	pMsg->nh.nlmsg_len=NLMSG_LENGTH(GENL_HDRLEN);
+	pMsg->nh.nlmsg_type=type;
+	pMsg->nh.nlmsg_flags=NLM_F_REQUEST | flags;
+	pMsg->nh.nlmsg_seq=__atomic_add_fetch(&nwSeq, 1, __ATOMIC_RELAXED);
+	pMsg->gh.cmd=cmd;
+	pMsg->gh.version=1;
+}
+
+static void nwMsgAttr(NwMsg_t *pMsg, uint16_t type, const void *data, uint16_t len)
+{
+	struct nlattr *pAttr=(struct nlattr *)((char *)pMsg+NLMSG_ALIGN(pMsg->nh.nlmsg_len));
+
+	if (NLMSG_ALIGN(pMsg->nh.nlmsg_len)+NLA_HDRLEN+NLA_ALIGN(len)>sizeof(NwMsg_t))
+		return;
+
+	pAttr->nla_type=type;
+	pAttr->nla_len=NLA_HDRLEN+len;
+	memcpy((char *)pAttr+NLA_HDRLEN, data, len);
+	pMsg->nh.nlmsg_len=NLMSG_ALIGN(pMsg->nh.nlmsg_len)+NLA_ALIGN(pAttr->nla_len);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwParse
+Synopsis:
+	Sorts a run of attributes into tb[] by type.  Types above maxType and
+	anything that runs off the end are ignored.
+Author:
+	John Gedde
+Inputs:
+	const struct nlattr **tb: maxType+1 entries
+	int maxType: highest type wanted
+	const void *data: the attributes
+	int len: their length
+Outputs:
+	const struct nlattr **tb: NULL for any that weren't there
+-----------------------------------------------------------------------------*/
+static void nwParse(const struct nlattr **tb, int maxType, const void *data, int len)
+{
+	const struct nlattr *pAttr=data;
+	int type;
+
+	memset(tb, 0, sizeof(*tb)*(maxType+1));
+	while (len>=NLA_HDRLEN && pAttr->nla_len>=NLA_HDRLEN && pAttr->nla_len<=len)
+	{
+		type=pAttr->nla_type & NLA_TYPE_MASK;
+		if (type<=maxType)
+			tb[type]=pAttr;
+		len-=NLA_ALIGN(pAttr->nla_len);
+		pAttr=(const struct nlattr *)((const char *)pAttr+NLA_ALIGN(pAttr->nla_len));
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwTalk
+Synopsis:
+	Sends a request and reads the answers until the ack, error or end of
+	a dump.  fn() is called for each answer that has data.
+Author:
+	John Gedde
+Inputs:
+	int fd: socket
+	NwMsg_t *pMsg: the request (with NLM_F_ACK or NLM_F_DUMP)
+	void (*fn)(const struct nlmsghdr *, void *): answer handler, can be NULL
+	void *arg: for fn
+Outputs:
+	int: 0 if it worked, -errno if not
+-----------------------------------------------------------------------------*/
+static int nwTalk(int fd, NwMsg_t *pMsg, void (*fn)(const struct nlmsghdr *, void *), void *arg)
+{
+	char buf[NW_BUF_LEN] __attribute__((aligned(NLMSG_ALIGNTO)));
+	const struct nlmsghdr *nh;
+	int len;
+
+	if (send(fd, pMsg, pMsg->nh.nlmsg_len, 0)<0)
+		return -errno;
+
+	for (;;)
+	{
+		if ((len=recv(fd, buf, sizeof(buf), 0))<0)
+		{
+			if (errno==EINTR)
+				continue;
+			return -errno;
+		}
+
+		for (nh=(const struct nlmsghdr *)buf; NLMSG_OK(nh, (unsigned int)len); nh=NLMSG_NEXT(nh, len))
+		{
+			if (nh->nlmsg_seq!=pMsg->nh.nlmsg_seq)
+				continue;
+			if (nh->nlmsg_type==NLMSG_ERROR)
+				return ((const struct nlmsgerr *)NLMSG_DATA(nh))->error;
+			if (nh->nlmsg_type==NLMSG_DONE)
+				return 0;
+			if (fn)
+				fn(nh, arg);
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwFamilyMsg / nwFamily
+Synopsis:
+	Looks up the nl80211 generic netlink family and its scan event group
+Author:
+	John Gedde
+Inputs:
+	int fd: socket
+	NwFamily_t *pFamily: where to put it
+Outputs:
+	bool: TRUE if nl80211 is there
+-----------------------------------------------------------------------------*/
+static void nwFamilyMsg(const struct nlmsghdr *nh, void *arg)
+{
+	NwFamily_t *pFamily=arg;
+	const struct nlattr *tb[CTRL_ATTR_MAX+1];
+	const struct nlattr *grp[CTRL_ATTR_MCAST_GRP_MAX+1];
+	const struct nlattr *pAttr;
+	int len;
+
+	nwParse(tb, CTRL_ATTR_MAX, (const char *)NLMSG_DATA(nh)+GENL_HDRLEN, 
+		nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN));
+	if (tb[CTRL_ATTR_FAMILY_ID])
+		pFamily->family=*(const uint16_t *)NW_DATA(tb[CTRL_ATTR_FAMILY_ID]);
+	if (tb[CTRL_ATTR_MCAST_GROUPS]==NULL)
+		return;
+
+	// A list of nested groups, each with a name and an id
+	pAttr=NW_DATA(tb[CTRL_ATTR_MCAST_GROUPS]);
+	len=NW_LEN(tb[CTRL_ATTR_MCAST_GROUPS]);
+	while (len>=NLA_HDRLEN && pAttr->nla_len>=NLA_HDRLEN && pAttr->nla_len<=len)
+	{
+		nwParse(grp, CTRL_ATTR_MCAST_GRP_MAX, NW_DATA(pAttr), NW_LEN(pAttr));
+		if (grp[CTRL_ATTR_MCAST_GRP_NAME] && grp[CTRL_ATTR_MCAST_GRP_ID] &&
+			strncmp(NW_DATA(grp[CTRL_ATTR_MCAST_GRP_NAME]), NL80211_MULTICAST_GROUP_SCAN, 
+				NW_LEN(grp[CTRL_ATTR_MCAST_GRP_NAME]))==0)
+			pFamily->scanGroup=*(const uint32_t *)NW_DATA(grp[CTRL_ATTR_MCAST_GRP_ID]);
+		len-=NLA_ALIGN(pAttr->nla_len);
+		pAttr=(const struct nlattr *)((const char *)pAttr+NLA_ALIGN(pAttr->nla_len));
+	}
+}
+
+static bool nwFamily(int fd, NwFamily_t *pFamily)
+{
+	NwMsg_t msg;
+
+	memset(pFamily, 0, sizeof(*pFamily));
+	nwMsgInit(&msg, GENL_ID_CTRL, NLM_F_ACK, CTRL_CMD_GETFAMILY);
+	nwMsgAttr(&msg, CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME, sizeof(NL80211_GENL_NAME));
+	return nwTalk(fd, &msg, nwFamilyMsg, pFamily)==0 && pFamily->family!=0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwStart
+Synopsis:
+	Opens a socket and finds nl80211 and the interface
+Author:
+	John Gedde
+Inputs:
+	const char *iface: wifi interface
+	NwFamily_t *pFamily: where to put the nl80211 ids
+	uint32_t *pIfIndex: where to put the interface index
+	bool quiet: don't log problems (called often)
+Outputs:
+	int: the socket, -1 if any of it isn't there
+-----------------------------------------------------------------------------*/
+static int nwStart(const char *iface, NwFamily_t *pFamily, uint32_t *pIfIndex, bool quiet)
+{
+	int fd;
+
+	if ((*pIfIndex=if_nametoindex(iface))==0)
+	{
+		if (!quiet)
+			fprintf(stderr, "aslLCD Error: No wifi interface %s\n", iface);
+		return -1;
+	}
+	if ((fd=nwOpen())<0)
+		return -1;
+	if (!nwFamily(fd, pFamily))
+	{
+		if (!quiet)
+			fprintf(stderr, "aslLCD Error: No nl80211 in this kernel\n");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwWaitScan
+Synopsis:
+	Waits for the scan on an interface to finish (or be aborted)
+Author:
+	John Gedde
+Inputs:
+	int evFd: socket in the scan event group
+	uint32_t ifIndex: the interface
+Outputs:
+	bool: FALSE if it didn't finish within NW_SCAN_WAIT_MS
+-----------------------------------------------------------------------------*/
+static bool nwWaitScan(int evFd, uint32_t ifIndex)
+{
+	char buf[NW_BUF_LEN] __attribute__((aligned(NLMSG_ALIGNTO)));
+	const struct nlmsghdr *nh;
+	const struct genlmsghdr *gh;
+	const struct nlattr *tb[NL80211_ATTR_IFINDEX+1];
+	struct pollfd pfd={ evFd, POLLIN, 0 };
+	uint64_t deadline=getClock_ms()+NW_SCAN_WAIT_MS, now;
+	int len;
+
+	while ((now=getClock_ms())<deadline)
+	{
+		if (poll(&pfd, 1, (int)(deadline-now))<=0)
+			continue;
+		if ((len=recv(evFd, buf, sizeof(buf), MSG_DONTWAIT))<=0)
+			continue;
+
+		for (nh=(const struct nlmsghdr *)buf; NLMSG_OK(nh, (unsigned int)len); nh=NLMSG_NEXT(nh, len))
+		{
+			gh=NLMSG_DATA(nh);
+			if (gh->cmd!=NL80211_CMD_NEW_SCAN_RESULTS && gh->cmd!=NL80211_CMD_SCAN_ABORTED)
+				continue;
+			nwParse(tb, NL80211_ATTR_IFINDEX, (const char *)gh+GENL_HDRLEN, 
+				nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN));
+			if (tb[NL80211_ATTR_IFINDEX] && *(const uint32_t *)NW_DATA(tb[NL80211_ATTR_IFINDEX])==ifIndex)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwScanMsg
+Synopsis:
+	One BSS from the scan dump.  Networks are kept by name, with the
+	strongest signal any of its access points had.  If the list is full
+	a stronger network pushes out the weakest.  Hidden networks (no name)
+	are left out.
+Author:
+	John Gedde
+Inputs:
+	const struct nlmsghdr *nh: the answer
+	void *arg: NwList_t
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void nwScanMsg(const struct nlmsghdr *nh, void *arg)
+{
+	NwList_t *pList=arg;
+	const struct nlattr *tb[NL80211_ATTR_BSS+1];
+	const struct nlattr *bss[NL80211_BSS_MAX+1];
+	const uint8_t *pIe;
+	int ieLen, weakest=0;
+	NwNet_t net;
+
+	nwParse(tb, NL80211_ATTR_BSS, (const char *)NLMSG_DATA(nh)+GENL_HDRLEN, 
+		nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN));
+	if (tb[NL80211_ATTR_BSS]==NULL)
+		return;
+	nwParse(bss, NL80211_BSS_MAX, NW_DATA(tb[NL80211_ATTR_BSS]), NW_LEN(tb[NL80211_ATTR_BSS]));
+	if (bss[NL80211_BSS_INFORMATION_ELEMENTS]==NULL)
+		return;
+
+	// Information elements are id, length, data.  The SSID is id 0.
+	memset(&net, 0, sizeof(net));
+	pIe=NW_DATA(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	ieLen=NW_LEN(bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+	while (ieLen>=2 && pIe[1]+2<=ieLen)
+	{
+		if (pIe[0]==0)
+		{
+			for (int i=0; i<pIe[1] && i<NW_SSID_LEN && pIe[2+i]!='\0'; ++i)
+				net.ssid[i]=(pIe[2+i]>=' ' && pIe[2+i]<0x7f) ? pIe[2+i] : '?';
+			break;
+		}
+		ieLen-=pIe[1]+2;
+		pIe+=pIe[1]+2;
+	}
+	if (net.ssid[0]=='\0')
+		return;
+
+	net.signal_dBm=NW_NO_SIGNAL;
+	if (bss[NL80211_BSS_SIGNAL_MBM])
+		net.signal_dBm=*(const int32_t *)NW_DATA(bss[NL80211_BSS_SIGNAL_MBM])/100;
+
+	for (int i=0; i<pList->num; ++i)
+	{
+		if (strcmp(pList->pNets[i].ssid, net.ssid)==0)
+		{
+			if (net.signal_dBm>pList->pNets[i].signal_dBm)
+				pList->pNets[i].signal_dBm=net.signal_dBm;
+			return;
+		}
+		if (pList->pNets[i].signal_dBm<pList->pNets[weakest].signal_dBm)
+			weakest=i;
+	}
+
+	if (pList->num<pList->max)
+		pList->pNets[pList->num++]=net;
+	else if (pList->num && net.signal_dBm>pList->pNets[weakest].signal_dBm)
+		pList->pNets[weakest]=net;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwCompare
+Synopsis:
+	qsort() order: strongest first, then by name
+Author:
+	John Gedde
+Inputs:
+	const void *a, *b: NwNet_t
+Outputs:
+	int: <0, 0, >0
+-----------------------------------------------------------------------------*/
+static int nwCompare(const void *a, const void *b)
+{
+	const NwNet_t *pA=a, *pB=b;
+
+	if (pA->signal_dBm!=pB->signal_dBm)
+		return pB->signal_dBm-pA->signal_dBm;
+	return strcmp(pA->ssid, pB->ssid);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwScan
+Synopsis:
+	Scans for wifi networks.  Takes a few seconds, so run it from the
+	prefetch thread.  If a new scan can't be started (one is already
+	running, or we aren't allowed) whatever the kernel has from the last
+	scan is used.
+Author:
+	John Gedde
+Inputs:
+	const char *iface: wifi interface (wlan0)
+	NwNet_t *pNets: where to put them
+	int max: room in pNets
+Outputs:
+	NwNet_t *pNets: networks, strongest first, one per name
+	int: how many, -1 if the scan couldn't be done at all
+-----------------------------------------------------------------------------*/
+int nwScan(const char *iface, NwNet_t *pNets, int max)
+{
+	int fd, evFd=-1, err;
+	uint32_t ifIndex;
+	NwFamily_t family;
+	NwMsg_t msg;
+	NwList_t list={ pNets, max, 0 };
+
+	if ((fd=nwStart(iface, &family, &ifIndex, FALSE))<0)
+		return -1;
+
+	// Join the scan events before starting the scan so the end can't be missed
+	if (family.scanGroup && (evFd=nwOpen())>=0 &&
+		setsockopt(evFd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &family.scanGroup, sizeof(family.scanGroup))<0)
+	{
+		close(evFd);
+		evFd=-1;
+	}
+
+	if (evFd>=0)
+	{
+		nwMsgInit(&msg, family.family, NLM_F_ACK, NL80211_CMD_TRIGGER_SCAN);
+		nwMsgAttr(&msg, NL80211_ATTR_IFINDEX, &ifIndex, sizeof(ifIndex));
+		err=nwTalk(fd, &msg, NULL, NULL);
+		if (err==0 || err==-EBUSY)
+			nwWaitScan(evFd, ifIndex);
+		close(evFd);
+	}
+
+	nwMsgInit(&msg, family.family, NLM_F_DUMP, NL80211_CMD_GET_SCAN);
+	nwMsgAttr(&msg, NL80211_ATTR_IFINDEX, &ifIndex, sizeof(ifIndex));
+	err=nwTalk(fd, &msg, nwScanMsg, &list);
+	close(fd);
+	if (err<0)
+	{
+		fprintf(stderr, "aslLCD Error: Wifi scan on %s failed (%s)\n", iface, strerror(-err));
+		return -1;
+	}
+
+	qsort(pNets, list.num, sizeof(NwNet_t), nwCompare);
+	return list.num;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwIfaceMsg / nwStationMsg
+Synopsis:
+	The interface's SSID, and the station info for the access point
+Author:
+	John Gedde
+Inputs:
+	const struct nlmsghdr *nh: the answer
+	void *arg: NwLink_t
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void nwIfaceMsg(const struct nlmsghdr *nh, void *arg)
+{
+	NwLink_t *pLink=arg;
+	const struct nlattr *tb[NL80211_ATTR_SSID+1];
+	const uint8_t *pSsid;
+
+	nwParse(tb, NL80211_ATTR_SSID, (const char *)NLMSG_DATA(nh)+GENL_HDRLEN, 
+		nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN));
+	if (tb[NL80211_ATTR_SSID]==NULL)
+		return;
+
+	pSsid=NW_DATA(tb[NL80211_ATTR_SSID]);
+	memset(pLink->ssid, 0, sizeof(pLink->ssid));
+	for (int i=0; i<NW_LEN(tb[NL80211_ATTR_SSID]) && i<NW_SSID_LEN && pSsid[i]!='\0'; ++i)
+		pLink->ssid[i]=(pSsid[i]>=' ' && pSsid[i]<0x7f) ? pSsid[i] : '?';
+}
+
+static void nwStationMsg(const struct nlmsghdr *nh, void *arg)
+{
+	NwLink_t *pLink=arg;
+	const struct nlattr *tb[NL80211_ATTR_STA_INFO+1];
+	const struct nlattr *sta[NL80211_STA_INFO_MAX+1];
+	const struct nlattr *rate[NL80211_RATE_INFO_MAX+1];
+
+	nwParse(tb, NL80211_ATTR_STA_INFO, (const char *)NLMSG_DATA(nh)+GENL_HDRLEN, 
+		nh->nlmsg_len-NLMSG_LENGTH(GENL_HDRLEN));
+	if (tb[NL80211_ATTR_STA_INFO]==NULL)
+		return;
+	nwParse(sta, NL80211_STA_INFO_MAX, NW_DATA(tb[NL80211_ATTR_STA_INFO]), NW_LEN(tb[NL80211_ATTR_STA_INFO]));
+
+	pLink->connected=TRUE;
+	if (sta[NL80211_STA_INFO_SIGNAL])
+		pLink->signal_dBm=*(const int8_t *)NW_DATA(sta[NL80211_STA_INFO_SIGNAL]);
+	if (sta[NL80211_STA_INFO_TX_RETRIES])
+		pLink->txRetries=*(const uint32_t *)NW_DATA(sta[NL80211_STA_INFO_TX_RETRIES]);
+
+	if (sta[NL80211_STA_INFO_TX_BITRATE])
+	{
+		nwParse(rate, NL80211_RATE_INFO_MAX, NW_DATA(sta[NL80211_STA_INFO_TX_BITRATE]), 
+			NW_LEN(sta[NL80211_STA_INFO_TX_BITRATE]));
+		if (rate[NL80211_RATE_INFO_BITRATE32])
+			pLink->txBitrate_100k=*(const uint32_t *)NW_DATA(rate[NL80211_RATE_INFO_BITRATE32]);
+		else if (rate[NL80211_RATE_INFO_BITRATE])
+			pLink->txBitrate_100k=*(const uint16_t *)NW_DATA(rate[NL80211_RATE_INFO_BITRATE]);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwProcWireless
+Synopsis:
+	Link quality and noise from /proc/net/wireless:
+	 wlan0: 0000   70.  -40.  -256        0      0      0      0      0        0
+	Noise of -256 means the driver doesn't know.
+Author:
+	John Gedde
+Inputs:
+	const char *iface: wifi interface
+	NwLink_t *pLink: where to put them
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void nwProcWireless(const char *iface, NwLink_t *pLink)
+{
+	FILE *fp;
+	char line[160];
+	char *p;
+	size_t ifLen=strlen(iface);
+	float quality, level, noise;
+
+	if ((fp=fopen(NW_PROC_WIRELESS, "r"))==NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp))
+	{
+		p=line;
+		while (*p==' ')
+			p++;
+		if (strncmp(p, iface, ifLen)!=0 || p[ifLen]!=':')
+			continue;
+
+		if (sscanf(p+ifLen+1, "%*x %f %f %f", &quality, &level, &noise)==3)
+		{
+			pLink->quality=(quality>0) ? (uint8_t)quality : 0;
+			if (noise>-256 && noise<0)
+				pLink->noise_dBm=(int16_t)noise;
+		}
+		break;
+	}
+	fclose(fp);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	nwLink
+Synopsis:
+	Reads how the link to the access point is doing.  No processes are
+	started, so it can be called several times a second.
+Author:
+	John Gedde
+Inputs:
+	const char *iface: wifi interface
+	NwLink_t *pLink: where to put it
+Outputs:
+	NwLink_t *pLink: the link, connected FALSE if there isn't one
+	bool: FALSE if nl80211 or the interface isn't there
+-----------------------------------------------------------------------------*/
+bool nwLink(const char *iface, NwLink_t *pLink)
+{
+	int fd;
+	uint32_t ifIndex;
+	NwFamily_t family;
+	NwMsg_t msg;
+
+	memset(pLink, 0, sizeof(*pLink));
+	pLink->signal_dBm=NW_NO_SIGNAL;
+	pLink->noise_dBm=NW_NO_SIGNAL;
+
+	if ((fd=nwStart(iface, &family, &ifIndex, TRUE))<0)
+		return FALSE;
+
+	nwMsgInit(&msg, family.family, NLM_F_DUMP, NL80211_CMD_GET_STATION);
+	nwMsgAttr(&msg, NL80211_ATTR_IFINDEX, &ifIndex, sizeof(ifIndex));
+	nwTalk(fd, &msg, nwStationMsg, pLink);
+
+	if (pLink->connected)
+	{
+		nwMsgInit(&msg, family.family, NLM_F_ACK, NL80211_CMD_GET_INTERFACE);
+		nwMsgAttr(&msg, NL80211_ATTR_IFINDEX, &ifIndex, sizeof(ifIndex));
+		nwTalk(fd, &msg, nwIfaceMsg, pLink);
+		nwProcWireless(iface, pLink);
+	}
+
+	close(fd);
+	return TRUE;
+}
@@ -0,0 +1,66 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  nlwifi.h
+*
+*  Synopsis:	Header file for nlwifi.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  nwLink() for the link quality meter
+*
+****************************************************************************/
+
+#ifndef _NLWIFI
+#define _NLWIFI
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NW_SSID_LEN			32
+#define NW_SCAN_WAIT_MS		10000		// longest a scan is waited for
+#define NW_NO_SIGNAL		-100		// dBm, if the driver doesn't say
+
+typedef struct
+{
+	char ssid[NW_SSID_LEN+1];			// unprintable chars are '?'
+	int16_t signal_dBm;
+} NwNet_t;
+
+// The link to the access point we're connected to
+typedef struct
+{
+	bool connected;
+	char ssid[NW_SSID_LEN+1];
+	int16_t signal_dBm;
+	int16_t noise_dBm;					// NW_NO_SIGNAL if the driver doesn't say
+	uint8_t quality;					// /proc/net/wireless link quality
+	uint32_t txBitrate_100k;			// 100 kbit/s units, 0 if not known
+	uint32_t txRetries;					// since connecting
+} NwLink_t;
+
+int 	nwScan(const char *iface, NwNet_t *pNets, int max);
+bool 	nwLink(const char *iface, NwLink_t *pLink);
+
+#endif
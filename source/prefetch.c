@@ -0,0 +1,502 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  prefetch.c
+*
+*  Synopsis:	Background fetching of data that takes a while to get, so
+*				it's already there when a screen asks for it.  The menu
+*				calls pfWant() when the cursor stops on an item that will
+*				need something; the prefetch thread gets it and keeps it
+*				for the source's fresh_ms.  pfGet() hands back the kept
+*				copy if it's fresh, waits if a fetch is part way through,
+*				or fetches on the spot if neither.
+*
+*				Anything that changes the data (a connect, a new local
+*				node) calls pfInvalidate().  A fetch that was running at
+*				the time is thrown away when it finishes.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Tell the caller when a background fetch
+*            |              |  finishes so a screen can wait without
+*            |              |  blocking.  Fresh time can be changed later.
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "prefetch.h"
+#include "main.h"
+#include "clockfunc.h"
+
+typedef struct
+{
+	PfSource_t src;
+	void *data;
+	bool valid;
+	bool busy;						// a fetch is running
+	bool wanted;					// for the prefetch thread
+	uint32_t gen;					// goes up on every pfInvalidate()
+	uint64_t fetched_ms;
+	PfStats_t stats;
+} PfEntry_t;
+
+static PfEntry_t entries[PF_MAX_SOURCES];
+static int numEntries=0;
+static pthread_mutex_t pfLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pfWake=PTHREAD_COND_INITIALIZER;		// something wanted
+static pthread_cond_t pfDone=PTHREAD_COND_INITIALIZER;		// a fetch finished
+static pthread_t pfThread;
+static bool running=FALSE;
+static bool pfKill=FALSE;
+static void (*pfDoneFn)(int id)=NULL;
+
+/*-----------------------------------------------------------------------------
+Function:
+	isFresh
+Synopsis:
+	Whether an entry has data that is still good.  Call with pfLock held.
+Author:
+	John Gedde
+Inputs:
+	const PfEntry_t *e: the entry
+Outputs:
+	bool: TRUE if fresh
+-----------------------------------------------------------------------------*/
+static bool isFresh(const PfEntry_t *e)
+{
+	return e->valid && getClock_ms()-e->fetched_ms<e->src.fresh_ms;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	runFetch
+Synopsis:
+	Runs an entry's fetch with pfLock let go, then marks the data good if
+	nothing invalidated it meanwhile.  Call with pfLock held and busy not
+	set.
+Author:
+	John Gedde
+Inputs:
+	PfEntry_t *e: the entry
+Outputs:
+	bool: TRUE if the fetch worked
+-----------------------------------------------------------------------------*/
+static bool runFetch(PfEntry_t *e)
+{
+	uint32_t gen=e->gen;
+	bool ok;
+
+	e->busy=TRUE;
+	e->valid=FALSE;
+	pthread_mutex_unlock(&pfLock);
+
+	memset(e->data, 0, e->src.size);
+	ok=e->src.fetch(e->data);
+
+	pthread_mutex_lock(&pfLock);
+	e->busy=FALSE;
+	if (ok && gen==e->gen)
+	{
+		e->valid=TRUE;
+		e->fetched_ms=getClock_ms();
+	}
+	pthread_cond_broadcast(&pfDone);
+
+	return ok;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfThreadFn
+Synopsis:
+	Fetches whatever has been asked for with pfWant() and isn't fresh
+Author:
+	John Gedde
+Inputs:
+	void *p: arguments
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *pfThreadFn(void *p)
+{
+	PfEntry_t *e;
+	int i;
+
+	pthread_mutex_lock(&pfLock);
+	while (!pfKill)
+	{
+		for (i=0; i<numEntries; ++i)
+		{
+			if (entries[i].wanted)
+				break;
+		}
+		if (i==numEntries)
+		{
+			pthread_cond_wait(&pfWake, &pfLock);
+			continue;
+		}
+
+		e=&entries[i];
+		e->wanted=FALSE;
+		if (e->busy || isFresh(e))
+			continue;
+
+		e->stats.prefetches++;
+		runFetch(e);
+
+		if (pfDoneFn)
+		{
+			pthread_mutex_unlock(&pfLock);
+			pfDoneFn(i);
+			pthread_mutex_lock(&pfLock);
+		}
+	}
+	pthread_mutex_unlock(&pfLock);
+
+	return p;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfStart
+Synopsis:
+	Sets up the sources and starts the prefetch thread.  The source ids
+	used with the other calls are their places in the list.
+Author:
+	John Gedde
+Inputs:
+	const PfSource_t *sources: the sources
+	int numSources: how many (PF_MAX_SOURCES at most)
+	void (*doneFn)(int id): called from the prefetch thread each time a
+							background fetch finishes, worked or not.
+							Can be NULL.
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pfStart(const PfSource_t *sources, int numSources, void (*doneFn)(int id))
+{
+	if (running)
+		return;
+
+	pfDoneFn=doneFn;
+
+	if (numSources>PF_MAX_SOURCES)
+		numSources=PF_MAX_SOURCES;
+
+	for (int i=0; i<numSources; ++i)
+	{
+		memset(&entries[i], 0, sizeof(PfEntry_t));
+		entries[i].src=sources[i];
+		entries[i].data=calloc(1, sources[i].size);
+		if (entries[i].data==NULL)
+		{
+			fprintf(stderr, "aslLCD Error: Out of memory for prefetch\n");
+			numSources=i;
+			break;
+		}
+	}
+	numEntries=numSources;
+
+	pfKill=FALSE;
+	if (pthread_create(&pfThread, NULL, pfThreadFn, NULL)!=0)
+		fprintf(stderr, "aslLCD Error: Could not create prefetch thread\n");
+	else
+		running=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfStop
+Synopsis:
+	Stops the prefetch thread once any fetch it's doing is finished
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pfStop()
+{
+	if (!running)
+		return;
+
+	pthread_mutex_lock(&pfLock);
+	pfKill=TRUE;
+	pthread_cond_broadcast(&pfWake);
+	pthread_mutex_unlock(&pfLock);
+	pthread_join(pfThread, NULL);
+	running=FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfWant
+Synopsis:
+	Asks for a source to be fetched in the background if it isn't fresh
+Author:
+	John Gedde
+Inputs:
+	int id: source
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pfWant(int id)
+{
+	if (id<0 || id>=numEntries || !running)
+		return;
+
+	pthread_mutex_lock(&pfLock);
+	if (!entries[id].busy && !isFresh(&entries[id]))
+	{
+		entries[id].wanted=TRUE;
+		pthread_cond_signal(&pfWake);
+	}
+	pthread_mutex_unlock(&pfLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfReady
+Synopsis:
+	Whether pfGet() would answer right away (e.g. to skip a "please wait")
+Author:
+	John Gedde
+Inputs:
+	int id: source
+Outputs:
+	bool: TRUE if there's fresh data
+-----------------------------------------------------------------------------*/
+bool pfReady(int id)
+{
+	bool ready;
+
+	if (id<0 || id>=numEntries)
+		return FALSE;
+
+	pthread_mutex_lock(&pfLock);
+	ready=isFresh(&entries[id]);
+	pthread_mutex_unlock(&pfLock);
+
+	return ready;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfBusy
+Synopsis:
+	Whether a fetch is running or waiting to run.  Once it isn't and
+	pfPeek() still has nothing, the fetch failed.
+Author:
+	John Gedde
+Inputs:
+	int id: source
+Outputs:
+	bool: TRUE if there's a fetch on the way
+-----------------------------------------------------------------------------*/
+bool pfBusy(int id)
+{
+	bool busy;
+
+	if (id<0 || id>=numEntries)
+		return FALSE;
+
+	pthread_mutex_lock(&pfLock);
+	busy=entries[id].busy || entries[id].wanted;
+	pthread_mutex_unlock(&pfLock);
+
+	return busy;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfSetFresh
+Synopsis:
+	Changes how long a source's data is good for (e.g. from the conf file)
+Author:
+	John Gedde
+Inputs:
+	int id: source
+	uint32_t fresh_ms: new fresh time
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pfSetFresh(int id, uint32_t fresh_ms)
+{
+	if (id<0 || id>=numEntries)
+		return;
+
+	pthread_mutex_lock(&pfLock);
+	entries[id].src.fresh_ms=fresh_ms;
+	pthread_mutex_unlock(&pfLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfPeek
+Synopsis:
+	Copies out the data if it's fresh, without ever waiting or fetching
+Author:
+	John Gedde
+Inputs:
+	int id: source
+	void *out: where to put it (the source's size)
+Outputs:
+	bool: TRUE if out was filled in
+-----------------------------------------------------------------------------*/
+bool pfPeek(int id, void *out)
+{
+	bool fresh;
+
+	if (id<0 || id>=numEntries)
+		return FALSE;
+
+	pthread_mutex_lock(&pfLock);
+	fresh=isFresh(&entries[id]);
+	if (fresh)
+		memcpy(out, entries[id].data, entries[id].src.size);
+	pthread_mutex_unlock(&pfLock);
+
+	return fresh;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfGet
+Synopsis:
+	Gets fresh data: the kept copy if it's good, otherwise whatever the
+	fetch running now comes back with, otherwise a new fetch done here.
+Author:
+	John Gedde
+Inputs:
+	int id: source
+	void *out: where to put it (the source's size)
+Outputs:
+	bool: FALSE if the fetch failed (out is zeroed)
+-----------------------------------------------------------------------------*/
+bool pfGet(int id, void *out)
+{
+	PfEntry_t *e;
+	bool ok=TRUE;
+
+	if (id<0 || id>=numEntries)
+		return FALSE;
+	e=&entries[id];
+
+	pthread_mutex_lock(&pfLock);
+	if (isFresh(e))
+		e->stats.hits++;
+	else if (e->busy)
+	{
+		e->stats.waits++;
+		while (e->busy)
+			pthread_cond_wait(&pfDone, &pfLock);
+	}
+
+	if (!isFresh(e))
+	{
+		e->stats.misses++;
+		e->wanted=FALSE;
+		ok=runFetch(e);
+	}
+
+	if (ok)
+		memcpy(out, e->data, e->src.size);
+	else
+		memset(out, 0, e->src.size);
+	pthread_mutex_unlock(&pfLock);
+
+	return ok;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfInvalidate
+Synopsis:
+	Throws away what's kept for a source because it has changed
+Author:
+	John Gedde
+Inputs:
+	int id: source
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pfInvalidate(int id)
+{
+	if (id<0 || id>=numEntries)
+		return;
+
+	pthread_mutex_lock(&pfLock);
+	entries[id].gen++;
+	entries[id].valid=FALSE;
+	pthread_mutex_unlock(&pfLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pfReport
+Synopsis:
+	Text report of the hit/miss counters for the command port, one line
+	per source
+Author:
+	John Gedde
+Inputs:
+	char *buf: where to put it
+	size_t bufLen: size of buf
+Outputs:
+	int: length of the report
+-----------------------------------------------------------------------------*/
+int pfReport(char *buf, size_t bufLen)
+{
+	size_t pos=0;
+	int len;
+
+	if (bufLen==0)
+		return 0;
+	buf[0]='\0';
+
+	pthread_mutex_lock(&pfLock);
+	for (int i=-1; i<numEntries; ++i)
+	{
+		if (i<0)
+			len=snprintf(buf+pos, bufLen-pos, "prefetch hits waits misses prefetches\n");
+		else
+			len=snprintf(buf+pos, bufLen-pos, "%s %u %u %u %u\n", entries[i].src.name,
+				entries[i].stats.hits, entries[i].stats.waits,
+				entries[i].stats.misses, entries[i].stats.prefetches);
+		if (len<0 || (size_t)len>=bufLen-pos)
+		{
+			buf[pos]='\0';
+			break;
+		}
+		pos+=len;
+	}
+	pthread_mutex_unlock(&pfLock);
+
+	return pos;
+}
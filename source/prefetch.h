@@ -0,0 +1,74 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  prefetch.h
+*
+*  Synopsis:	Header file for prefetch.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Fetch done callback, pfBusy(), pfSetFresh()
+*
+****************************************************************************/
+
+#ifndef _PREFETCH
+#define _PREFETCH
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define PF_MAX_SOURCES		8
+
+// Something slow to get (asterisk, iwlist...)  fetch() runs on the prefetch
+// thread or the caller's, never both at once.  It must not touch the LCD
+// or /tmp/lcdtempfile.  Return FALSE if it couldn't get the data.
+typedef struct
+{
+	const char *name;
+	bool (*fetch)(void *buf);
+	size_t size;					// of the data
+	uint32_t fresh_ms;				// how long a result is good for
+} PfSource_t;
+
+typedef struct
+{
+	uint32_t hits;					// wanted data was already there
+	uint32_t waits;					// caught a fetch part way through
+	uint32_t misses;				// had to fetch on the spot
+	uint32_t prefetches;			// fetched in the background
+} PfStats_t;
+
+void 	pfStart(const PfSource_t *sources, int numSources, void (*doneFn)(int id));
+void 	pfStop();
+void 	pfWant(int id);
+bool 	pfReady(int id);
+bool 	pfBusy(int id);
+void 	pfSetFresh(int id, uint32_t fresh_ms);
+bool 	pfPeek(int id, void *out);
+bool 	pfGet(int id, void *out);
+void 	pfInvalidate(int id);
+int 	pfReport(char *buf, size_t bufLen);
+
+#endif
@@ -0,0 +1,332 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  recent.c
+*
+*  Synopsis:	Nodes connected to, ranked by how often and how lately.
+*				Each connect adds one to a node's score; scores halve
+*				every half life, so a node used a lot last month drops
+*				below one used twice today.  The list is kept in a small
+*				text file, rewritten to a temporary file and renamed over
+*				the old one so a power cut can't leave half of it:
+*
+*					# node count last_used score
+*					27339 14 1792345678 5.213
+*
+*				Connects are recorded from the asterisk command thread
+*				as they're confirmed; the menus read the list from the UI
+*				thread.  rnLock covers the list.  The file is written from
+*				a copy with the lock let go, so the UI never waits on an
+*				fsync().
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Record from the asterisk command thread
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <libgen.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "recent.h"
+#include "ini.h"
+#include "main.h"
+
+typedef struct
+{
+	uint32_t nodeNum;
+	uint32_t count;
+	time_t lastUsed;
+	double score;						// as of lastUsed
+} RnNode_t;
+
+static RnNode_t nodes[RN_MAX_NODES];
+static uint16_t numNodes=0;
+static char filePath[CONF_PATH_LEN];
+static double halfLife_s=72*3600.0;
+static pthread_mutex_t rnLock=PTHREAD_MUTEX_INITIALIZER;
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnScore
+Synopsis:
+	A node's score now
+Author:
+	John Gedde
+Inputs:
+	const RnNode_t *pNode: the node
+	time_t now: time now
+Outputs:
+	double: the score, decayed since it was last used
+-----------------------------------------------------------------------------*/
+static double rnScore(const RnNode_t *pNode, time_t now)
+{
+	double age=difftime(now, pNode->lastUsed);
+
+	if (age<=0)
+		return pNode->score;
+	return pNode->score*exp2(-age/halfLife_s);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnLoad
+Synopsis:
+	Reads the list from the file.  A missing file is an empty list.
+Author:
+	John Gedde
+Inputs:
+	const char *path: the file
+	uint16_t halfLife_h: hours for a score to halve
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void rnLoad(const char *path, uint16_t halfLife_h)
+{
+	FILE *fp;
+	char line[128];
+	RnNode_t node;
+	long long lastUsed;
+
+	pthread_mutex_lock(&rnLock);
+	snprintf(filePath, sizeof(filePath), "%s", path);
+	if (halfLife_h>0)
+		halfLife_s=halfLife_h*3600.0;
+	numNodes=0;
+
+	if ((fp=fopen(filePath, "r"))==NULL)
+	{
+		if (errno!=ENOENT)
+			fprintf(stderr, "aslLCD Error: Could not read %s\n", filePath);
+		pthread_mutex_unlock(&rnLock);
+		return;
+	}
+
+	while (numNodes<RN_MAX_NODES && fgets(line, sizeof(line), fp))
+	{
+		if (line[0]=='#')
+			continue;
+		if (sscanf(line, "%u %u %lld %lf", &node.nodeNum, &node.count, &lastUsed, &node.score)!=4 || 
+			node.nodeNum==0)
+			continue;
+		node.lastUsed=(time_t)lastUsed;
+		nodes[numNodes++]=node;
+	}
+	fclose(fp);
+	pthread_mutex_unlock(&rnLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnSave
+Synopsis:
+	Writes a copy of the list to a temporary file next to the real one and
+	renames it over the top
+Author:
+	John Gedde
+Inputs:
+	const char *path: the file
+	const RnNode_t *list: the list
+	uint16_t count: how many
+Outputs:
+	bool: TRUE if it was written
+-----------------------------------------------------------------------------*/
+static bool rnSave(const char *path, const RnNode_t *list, uint16_t count)
+{
+	FILE *fp;
+	char tmpPath[CONF_PATH_LEN+8];
+	char dir[CONF_PATH_LEN];
+	bool ok;
+
+	if (path[0]=='\0')
+		return FALSE;
+
+	// First time, the directory might not be there yet
+	snprintf(dir, sizeof(dir), "%s", path);
+	mkdir(dirname(dir), 0755);
+
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+	if ((fp=fopen(tmpPath, "w"))==NULL)
+	{
+		fprintf(stderr, "aslLCD Error: Could not write %s\n", tmpPath);
+		return FALSE;
+	}
+
+	fprintf(fp, "# node count last_used score\n");
+	for (uint16_t i=0; i<count; ++i)
+		fprintf(fp, "%u %u %lld %.4f\n", list[i].nodeNum, list[i].count, 
+			(long long)list[i].lastUsed, list[i].score);
+
+	ok=(fflush(fp)==0 && fsync(fileno(fp))==0);
+	ok=(fclose(fp)==0) && ok;
+	if (!ok || rename(tmpPath, path)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not save %s\n", path);
+		unlink(tmpPath);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnRecord
+Synopsis:
+	Counts a connect to a node and saves the list.  Called from the
+	asterisk command thread.
+Author:
+	John Gedde
+Inputs:
+	uint32_t nodeNum: node connected to
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void rnRecord(uint32_t nodeNum)
+{
+	time_t now=time(NULL);
+	uint16_t i, low=0;
+	RnNode_t copy[RN_MAX_NODES];
+	uint16_t numCopy;
+	char path[CONF_PATH_LEN];
+
+	pthread_mutex_lock(&rnLock);
+	for (i=0; i<numNodes && nodes[i].nodeNum!=nodeNum; ++i)
+		;
+
+	if (i==numNodes)
+	{
+		if (numNodes<RN_MAX_NODES)
+			numNodes++;
+		else
+		{
+			// Full: the new one takes the place of the lowest score, the
+			// oldest of those if there's a tie
+			for (i=1; i<numNodes; ++i)
+			{
+				if (rnScore(&nodes[i], now)<rnScore(&nodes[low], now) || 
+					(rnScore(&nodes[i], now)==rnScore(&nodes[low], now) && nodes[i].lastUsed<nodes[low].lastUsed))
+					low=i;
+			}
+			i=low;
+		}
+		memset(&nodes[i], 0, sizeof(nodes[i]));
+		nodes[i].nodeNum=nodeNum;
+		nodes[i].lastUsed=now;
+	}
+
+	nodes[i].score=rnScore(&nodes[i], now)+1.0;
+	nodes[i].count++;
+	nodes[i].lastUsed=now;
+
+	numCopy=numNodes;
+	memcpy(copy, nodes, numCopy*sizeof(*copy));
+	snprintf(path, sizeof(path), "%s", filePath);
+	pthread_mutex_unlock(&rnLock);
+
+	rnSave(path, copy, numCopy);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnRanked
+Synopsis:
+	The nodes, highest score first
+Author:
+	John Gedde
+Inputs:
+	uint32_t *pNodes: where to put them
+	uint16_t max: room in pNodes
+Outputs:
+	uint16_t: how many there are
+-----------------------------------------------------------------------------*/
+uint16_t rnRanked(uint32_t *pNodes, uint16_t max)
+{
+	time_t now=time(NULL);
+	double scores[RN_MAX_NODES];
+	uint32_t ranked[RN_MAX_NODES];
+	double score;
+	uint16_t j;
+
+	// Insertion sort - there are only a few
+	pthread_mutex_lock(&rnLock);
+	for (uint16_t i=0; i<numNodes; ++i)
+	{
+		score=rnScore(&nodes[i], now);
+		for (j=i; j>0 && scores[j-1]<score; --j)
+		{
+			scores[j]=scores[j-1];
+			ranked[j]=ranked[j-1];
+		}
+		scores[j]=score;
+		ranked[j]=nodes[i].nodeNum;
+	}
+
+	if (max>numNodes)
+		max=numNodes;
+	pthread_mutex_unlock(&rnLock);
+	memcpy(pNodes, ranked, max*sizeof(*pNodes));
+	return max;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	rnComplete
+Synopsis:
+	The highest scoring node whose number starts with prefix
+Author:
+	John Gedde
+Inputs:
+	const char *prefix: digits so far, "" for any
+Outputs:
+	uint32_t: the node, 0 if none
+-----------------------------------------------------------------------------*/
+uint32_t rnComplete(const char *prefix)
+{
+	time_t now=time(NULL);
+	size_t len=strlen(prefix);
+	char num[12];
+	uint32_t best=0;
+	double bestScore=-1;
+
+	pthread_mutex_lock(&rnLock);
+	for (uint16_t i=0; i<numNodes; ++i)
+	{
+		snprintf(num, sizeof(num), "%u", nodes[i].nodeNum);
+		if (strncmp(num, prefix, len)==0 && rnScore(&nodes[i], now)>bestScore)
+		{
+			best=nodes[i].nodeNum;
+			bestScore=rnScore(&nodes[i], now);
+		}
+	}
+	pthread_mutex_unlock(&rnLock);
+	return best;
+}
@@ -0,0 +1,46 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  recent.h
+*
+*  Synopsis:	Header file for recent.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _RECENT
+#define _RECENT
+
+#include <stdint.h>
+
+#define RN_MAX_NODES		32			// the lowest scoring one goes when full
+
+void 		rnLoad(const char *path, uint16_t halfLife_h);
+void 		rnRecord(uint32_t nodeNum);
+uint16_t 	rnRanked(uint32_t *pNodes, uint16_t max);
+uint32_t 	rnComplete(const char *prefix);
+
+#endif
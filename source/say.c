@@ -0,0 +1,277 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  say.c
+*
+*  Synopsis:	Built in announcements (time, IP address) without starting
+*				a script interpreter.  The sound files for what's to be
+*				said are joined into one file here (raw gsm/ulaw files can
+*				just be put end to end) so asterisk only has to be asked
+*				once to play it with rpt localplay.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <time.h>
+
+#include "say.h"
+#include "ini.h"
+#include "main.h"
+#include "getIP.h"
+
+typedef struct
+{
+	const char *parts[SAY_MAX_PARTS];
+	char digits[SAY_MAX_PARTS][18];		// room for digits/ and any %u
+	int num;
+} SayList_t;
+
+static const char *sayNames[SAY_MAX]=
+{
+	"say_time",
+	"say_time24",
+	"say_ip"
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	sayLookup / sayName
+Synopsis:
+	Built in announcement names, as used after SAY_PREFIX in script_pathN
+Author:
+	John Gedde
+Inputs:
+	const char *name: name to look up
+	SayWhat_t what: announcement
+Outputs:
+	int (sayLookup): SayWhat_t, -1 if there's no such announcement
+	const char * (sayName): its name
+-----------------------------------------------------------------------------*/
+int sayLookup(const char *name)
+{
+	for (int i=0; i<SAY_MAX; ++i)
+	{
+		if (strcasecmp(name, sayNames[i])==0)
+			return i;
+	}
+	return -1;
+}
+
+const char *sayName(SayWhat_t what)
+{
+	return (what<SAY_MAX) ? sayNames[what] : "";
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	addPart / addDigits / addNumber
+Synopsis:
+	Adds a sound (name under the sounds directory, no extension) to the
+	list.  addDigits adds one digits/ sound, addNumber says 0-99 with them.
+Author:
+	John Gedde
+Inputs:
+	SayList_t *pList: the list
+	const char *part: sound name
+	unsigned int n: number
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void addPart(SayList_t *pList, const char *part)
+{
+	if (pList->num<SAY_MAX_PARTS)
+		pList->parts[pList->num++]=part;
+}
+
+static void addDigits(SayList_t *pList, unsigned int n)
+{
+	if (pList->num<SAY_MAX_PARTS)
+	{
+		snprintf(pList->digits[pList->num], sizeof(pList->digits[0]), "digits/%u", n);
+		addPart(pList, pList->digits[pList->num]);
+	}
+}
+
+static void addNumber(SayList_t *pList, unsigned int n)
+{
+	if (n<=20)
+		addDigits(pList, n);
+	else
+	{
+		addDigits(pList, (n/10)*10);
+		if (n%10)
+			addDigits(pList, n%10);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	buildTime / buildIP
+Synopsis:
+	The sounds for each announcement.  Time is said the way saytime.pl
+	and say24time.pl say it; the IP address is spelled out digit by digit
+	like sayip.sh.
+Author:
+	John Gedde
+Inputs:
+	SayList_t *pList: the list
+	bool clock24: TRUE for 24 hour time
+Outputs:
+	bool: FALSE if there is nothing to say
+-----------------------------------------------------------------------------*/
+static bool buildTime(SayList_t *pList, bool clock24)
+{
+	time_t t=time(NULL);
+	struct tm *localT=localtime(&t);
+	int hour=localT->tm_hour;
+	int min=localT->tm_min;
+
+	if (!clock24)
+	{
+		if (hour<12)
+			addPart(pList, "rpt/goodmorning");
+		else if (hour<18)
+			addPart(pList, "rpt/goodafternoon");
+		else
+			addPart(pList, "rpt/goodevening");
+	}
+	addPart(pList, "rpt/thetimeis");
+
+	if (clock24)
+	{
+		addNumber(pList, hour);
+		if (min==0)
+			addPart(pList, "digits/hundred");
+	}
+	else
+		addNumber(pList, (hour%12) ? hour%12 : 12);
+
+	if (min>0 && min<10)
+	{
+		addPart(pList, "digits/oh");
+		addNumber(pList, min);
+	}
+	else if (min>=10)
+		addNumber(pList, min);
+	else if (!clock24)
+		addPart(pList, "digits/oclock");
+
+	if (!clock24)
+		addPart(pList, (hour<12) ? "digits/a-m" : "digits/p-m");
+
+	return TRUE;
+}
+
+static bool buildIP(SayList_t *pList)
+{
+	char ip[32];
+
+	getIPaddress(ip);
+	for (char *s=ip; *s; ++s)
+	{
+		if (isdigit((unsigned char)*s))
+			addDigits(pList, *s-'0');
+		else if (*s=='.')
+			addPart(pList, "letters/dot");
+	}
+	return pList->num>0;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	sayBuild
+Synopsis:
+	Makes the sound file for an announcement.  Sounds that aren't there
+	are left out (and complained about).
+Author:
+	John Gedde
+Inputs:
+	SayWhat_t what: announcement
+	char *base: where to put the file's name
+	size_t baseLen: size of base
+Outputs:
+	char *base: the file's name without the extension, for rpt localplay
+	bool: FALSE if nothing could be put in the file
+-----------------------------------------------------------------------------*/
+bool sayBuild(SayWhat_t what, char *base, size_t baseLen)
+{
+	SayList_t list;
+	char path[CONF_PATH_LEN+32];
+	char tmpPath[CONF_PATH_LEN+32];
+	char buf[4096];
+	FILE *fpOut, *fpIn;
+	size_t len;
+	int used=0;
+	bool ok;
+
+	memset(&list, 0, sizeof(list));
+	if (what==SAY_IP)
+		ok=buildIP(&list);
+	else
+		ok=buildTime(&list, what==SAY_TIME24);
+	if (!ok)
+	{
+		fprintf(stderr, "aslLCD Error: Nothing to say for %s\n", sayName(what));
+		return FALSE;
+	}
+
+	snprintf(base, baseLen, "%s%s", SAY_TMP_BASE, sayName(what));
+	snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", base);
+	if ((fpOut=fopen(tmpPath, "w"))==NULL)
+	{
+		fprintf(stderr, "aslLCD Error: Can't write %s\n", tmpPath);
+		return FALSE;
+	}
+
+	for (int i=0; i<list.num; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/%s.%s", conf->soundsDir, list.parts[i], conf->soundExt);
+		if ((fpIn=fopen(path, "r"))==NULL)
+		{
+			fprintf(stderr, "aslLCD Error: No sound file %s\n", path);
+			continue;
+		}
+		while ((len=fread(buf, 1, sizeof(buf), fpIn))>0)
+			fwrite(buf, 1, len, fpOut);
+		fclose(fpIn);
+		used++;
+	}
+
+	if (fclose(fpOut)!=0 || used==0)
+	{
+		remove(tmpPath);
+		return FALSE;
+	}
+
+	// Swap it in whole in case the last one is still playing
+	snprintf(path, sizeof(path), "%s.%s", base, conf->soundExt);
+	return rename(tmpPath, path)==0;
+}
@@ -0,0 +1,57 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  say.h
+*
+*  Synopsis:	Header file for say.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _SAY
+#define _SAY
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SAY_PREFIX			'@'			// script_pathN = "@say_time"
+#define SAY_TMP_BASE		"/tmp/aslLCD-"
+#define SAY_MAX_PARTS		24
+
+typedef enum
+{
+	SAY_TIME=0,					// 12 hour, with a greeting
+	SAY_TIME24,
+	SAY_IP,
+	SAY_MAX
+} SayWhat_t;
+
+int 		sayLookup(const char *name);
+const char 	*sayName(SayWhat_t what);
+bool 		sayBuild(SayWhat_t what, char *base, size_t baseLen);
+
+#endif
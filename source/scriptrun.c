@@ -0,0 +1,590 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  scriptrun.c
+*
+*  Synopsis:	Runs the user's scripts without tying up the buttons.  Each
+*				one is started with posix_spawn in its own process group
+*				with stdout and stderr on a pipe.  One thread reads the
+*				pipes into a ring of the last SR_LINES lines, reaps the
+*				scripts when they finish and kills any that run past
+*				their timeout (SIGTERM, then SIGKILL).
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <ctype.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "scriptrun.h"
+#include "main.h"
+#include "clockfunc.h"
+
+#define SR_POLL_MS			100			// reap/timeout check while running
+
+extern char **environ;
+
+typedef struct
+{
+	uint32_t id;						// 0 if the slot was never used
+	SrStatus_t st;
+	pid_t pid;							// 0 once reaped
+	int fd;								// output pipe, -1 once closed
+	uint64_t start;
+	uint64_t deadline;					// 0 for no timeout
+	uint64_t killAt;					// SIGKILL time once SIGTERM is sent
+	bool timedOut;
+	char lines[SR_LINES][SR_LINE_LEN];
+	uint16_t head;						// where the next line goes
+	char partial[SR_LINE_LEN];
+	uint16_t partialLen;
+	bool lastCR;
+} SrRun_t;
+
+static SrRun_t runs[SR_MAX_RUNS];
+static uint32_t nextId=1;
+static SrChangeFn_t changed=NULL;
+static int wakeFd[2]={ -1, -1 };
+static pthread_mutex_t srLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_t srThread;
+static bool running=FALSE;
+static bool srKill=FALSE;
+
+/*-----------------------------------------------------------------------------
+Function:
+	addLine / addOutput
+Synopsis:
+	Puts script output into a run's ring of lines.  Control characters
+	are dropped, tabs become spaces and long lines are cut short.  Call
+	with srLock held.
+Author:
+	John Gedde
+Inputs:
+	SrRun_t *pRun: the run
+	const char *buf: output
+	size_t len: bytes in buf
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void addLine(SrRun_t *pRun)
+{
+	pRun->partial[pRun->partialLen]='\0';
+	strcpy(pRun->lines[pRun->head], pRun->partial);
+	pRun->head=(pRun->head+1) % SR_LINES;
+	if (pRun->st.numLines<SR_LINES)
+		pRun->st.numLines++;
+	pRun->st.totalLines++;
+	pRun->partialLen=0;
+}
+
+static void addOutput(SrRun_t *pRun, const char *buf, size_t len)
+{
+	char c;
+
+	for (size_t i=0; i<len; ++i)
+	{
+		c=buf[i];
+		if (c=='\n' && pRun->lastCR)
+			;					// \r\n is one line end
+		else if (c=='\n' || c=='\r')
+			addLine(pRun);
+		else if (pRun->partialLen<SR_LINE_LEN-1)
+		{
+			if (c=='\t')
+				c=' ';
+			if (!iscntrl((unsigned char)c))
+				pRun->partial[pRun->partialLen++]=c;
+		}
+		pRun->lastCR=(c=='\r');
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	finishRun
+Synopsis:
+	Records how a script ended once it has been reaped.  Call with srLock
+	held.
+Author:
+	John Gedde
+Inputs:
+	SrRun_t *pRun: the run
+	int status: from waitpid()
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void finishRun(SrRun_t *pRun, int status)
+{
+	pRun->pid=0;
+	pRun->st.elapsed_ms=getClock_ms()-pRun->start;
+
+	if (WIFEXITED(status))
+		pRun->st.exitCode=WEXITSTATUS(status);
+	else if (WIFSIGNALED(status))
+		pRun->st.exitCode=WTERMSIG(status);
+
+	if (pRun->timedOut)
+		pRun->st.state=SRS_TIMEOUT;
+	else if (WIFEXITED(status) && pRun->st.exitCode==0)
+		pRun->st.state=SRS_DONE;
+	else
+		pRun->st.state=SRS_FAILED;
+
+	if (pRun->partialLen)
+		addLine(pRun);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srThreadFn
+Synopsis:
+	Reads output from the running scripts, reaps them when they end and
+	kills any that run too long
+Author:
+	John Gedde
+Inputs:
+	void *p: arguments
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *srThreadFn(void *p)
+{
+	struct pollfd fds[SR_MAX_RUNS+1];
+	int runIdx[SR_MAX_RUNS+1];
+	uint32_t changedIds[2*SR_MAX_RUNS];
+	int numFds, numChanged, timeout, status, i;
+	bool anyRunning;
+	char buf[256];
+	ssize_t len;
+	uint64_t now;
+	SrRun_t *pRun;
+
+	pthread_mutex_lock(&srLock);
+	while (!srKill)
+	{
+		fds[0].fd=wakeFd[0];
+		fds[0].events=POLLIN;
+		numFds=1;
+		anyRunning=FALSE;
+		for (i=0; i<SR_MAX_RUNS; ++i)
+		{
+			if (runs[i].pid)
+				anyRunning=TRUE;
+			if (runs[i].fd>=0)
+			{
+				fds[numFds].fd=runs[i].fd;
+				fds[numFds].events=POLLIN;
+				runIdx[numFds]=i;
+				numFds++;
+			}
+		}
+		timeout=anyRunning ? SR_POLL_MS : -1;
+		pthread_mutex_unlock(&srLock);
+
+		poll(fds, numFds, timeout);
+
+		pthread_mutex_lock(&srLock);
+		numChanged=0;
+		if (fds[0].revents)
+		{
+			while (read(wakeFd[0], buf, sizeof(buf))>0)
+				;
+		}
+
+		// Output
+		for (i=1; i<numFds; ++i)
+		{
+			if (!fds[i].revents)
+				continue;
+			pRun=&runs[runIdx[i]];
+			if (pRun->fd!=fds[i].fd)
+				continue;			// slot reused meanwhile
+
+			len=read(pRun->fd, buf, sizeof(buf));
+			if (len>0)
+				addOutput(pRun, buf, len);
+			else if (len==0 || (errno!=EAGAIN && errno!=EINTR))
+			{
+				close(pRun->fd);
+				pRun->fd=-1;
+			}
+			changedIds[numChanged++]=pRun->id;
+		}
+
+		// Finished or taking too long
+		now=getClock_ms();
+		for (i=0; i<SR_MAX_RUNS; ++i)
+		{
+			pRun=&runs[i];
+			if (!pRun->pid)
+				continue;
+
+			if (waitpid(pRun->pid, &status, WNOHANG)==pRun->pid)
+			{
+				finishRun(pRun, status);
+				if (numChanged==0 || changedIds[numChanged-1]!=pRun->id)
+					changedIds[numChanged++]=pRun->id;
+			}
+			else if (pRun->deadline && now>=pRun->deadline && !pRun->timedOut)
+			{
+				fprintf(stderr, "aslLCD Error: Script %s timed out\n", pRun->st.name);
+				kill(-pRun->pid, SIGTERM);
+				pRun->timedOut=TRUE;
+				pRun->killAt=now+SR_KILL_GRACE_MS;
+			}
+			else if (pRun->killAt && now>=pRun->killAt)
+			{
+				kill(-pRun->pid, SIGKILL);
+				pRun->killAt=0;
+			}
+		}
+		pthread_mutex_unlock(&srLock);
+
+		if (changed)
+		{
+			for (i=0; i<numChanged; ++i)
+				changed(changedIds[i]);
+		}
+		pthread_mutex_lock(&srLock);
+	}
+	pthread_mutex_unlock(&srLock);
+
+	return p;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srStart
+Synopsis:
+	Starts the script thread
+Author:
+	John Gedde
+Inputs:
+	SrChangeFn_t changeFn: told about output and scripts ending, can be
+						   NULL
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void srStart(SrChangeFn_t changeFn)
+{
+	if (running)
+		return;
+
+	for (int i=0; i<SR_MAX_RUNS; ++i)
+	{
+		memset(&runs[i], 0, sizeof(SrRun_t));
+		runs[i].fd=-1;
+	}
+
+	if (pipe2(wakeFd, O_CLOEXEC | O_NONBLOCK)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create script thread pipe\n");
+		return;
+	}
+
+	changed=changeFn;
+	srKill=FALSE;
+	if (pthread_create(&srThread, NULL, srThreadFn, NULL)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create script thread\n");
+		close(wakeFd[0]);
+		close(wakeFd[1]);
+	}
+	else
+		running=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srStop
+Synopsis:
+	Stops the script thread.  Scripts still running are killed.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void srStop()
+{
+	int status;
+
+	if (!running)
+		return;
+
+	pthread_mutex_lock(&srLock);
+	srKill=TRUE;
+	pthread_mutex_unlock(&srLock);
+	if (write(wakeFd[1], "x", 1)<0)
+		fprintf(stderr, "aslLCD Error: Could not wake script thread\n");
+	pthread_join(srThread, NULL);
+
+	for (int i=0; i<SR_MAX_RUNS; ++i)
+	{
+		if (runs[i].pid)
+		{
+			kill(-runs[i].pid, SIGKILL);
+			waitpid(runs[i].pid, &status, 0);
+			runs[i].pid=0;
+		}
+		if (runs[i].fd>=0)
+		{
+			close(runs[i].fd);
+			runs[i].fd=-1;
+		}
+	}
+	close(wakeFd[0]);
+	close(wakeFd[1]);
+	running=FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srIsRunning
+Synopsis:
+	Whether a script by this name is running now
+Author:
+	John Gedde
+Inputs:
+	const char *name: script name
+Outputs:
+	bool: TRUE if it is
+-----------------------------------------------------------------------------*/
+bool srIsRunning(const char *name)
+{
+	bool found=FALSE;
+
+	pthread_mutex_lock(&srLock);
+	for (int i=0; i<SR_MAX_RUNS && !found; ++i)
+		found=(runs[i].pid && strcmp(runs[i].st.name, name)==0);
+	pthread_mutex_unlock(&srLock);
+
+	return found;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srRun
+Synopsis:
+	Starts a script through /bin/sh so the command line works the same as
+	it did with system().  stdin is /dev/null.  A script that is already
+	running isn't started again.
+Author:
+	John Gedde
+Inputs:
+	const char *name: name to show and to spot it already running
+	const char *cmd: command line
+	uint32_t timeout_ms: kill it after this long, 0 for never
+	uint16_t maxRunning: most scripts allowed to run at once
+Outputs:
+	uint32_t: id for srStatus()/srLine(), 0 if it couldn't be started
+			  now (already running, too many running)
+-----------------------------------------------------------------------------*/
+uint32_t srRun(const char *name, const char *cmd, uint32_t timeout_ms, uint16_t maxRunning)
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t attr;
+	sigset_t sigs;
+	char *argv[]={ "/bin/sh", "-c", (char *)cmd, NULL };
+	SrRun_t *pRun=NULL;
+	int pipeFd[2], numRunning=0, rc, i;
+	uint32_t id=0;
+
+	if (!running)
+		return 0;
+	if (maxRunning>SR_MAX_RUNS)
+		maxRunning=SR_MAX_RUNS;
+
+	pthread_mutex_lock(&srLock);
+
+	// A free slot, else the oldest finished run
+	for (i=0; i<SR_MAX_RUNS; ++i)
+	{
+		if (runs[i].pid)
+		{
+			numRunning++;
+			if (strcmp(runs[i].st.name, name)==0)
+				break;
+		}
+		else if (!pRun || runs[i].id<pRun->id)
+			pRun=&runs[i];
+	}
+	if (i<SR_MAX_RUNS || numRunning>=maxRunning || !pRun)
+	{
+		pthread_mutex_unlock(&srLock);
+		return 0;
+	}
+
+	if (pRun->fd>=0)
+		close(pRun->fd);
+	memset(pRun, 0, sizeof(*pRun));
+	pRun->fd=-1;
+	pRun->id=id=nextId++;
+	snprintf(pRun->st.name, sizeof(pRun->st.name), "%s", name);
+	pRun->start=getClock_ms();
+	pRun->deadline=timeout_ms ? pRun->start+timeout_ms : 0;
+
+	if (pipe2(pipeFd, O_CLOEXEC)!=0)
+	{
+		rc=errno;
+		pipeFd[0]=pipeFd[1]=-1;
+	}
+	else
+	{
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+		posix_spawn_file_actions_adddup2(&actions, pipeFd[1], 1);
+		posix_spawn_file_actions_adddup2(&actions, pipeFd[1], 2);
+
+		// Own process group so a timeout gets anything it started too.
+		// Our threads' blocked signals shouldn't carry over.
+		posix_spawnattr_init(&attr);
+		posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+		posix_spawnattr_setpgroup(&attr, 0);
+		sigemptyset(&sigs);
+		posix_spawnattr_setsigmask(&attr, &sigs);
+		sigaddset(&sigs, SIGPIPE);
+		sigaddset(&sigs, SIGINT);
+		posix_spawnattr_setsigdefault(&attr, &sigs);
+
+		rc=posix_spawn(&pRun->pid, argv[0], &actions, &attr, argv, environ);
+
+		posix_spawnattr_destroy(&attr);
+		posix_spawn_file_actions_destroy(&actions);
+		close(pipeFd[1]);
+	}
+
+	if (rc!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not run %s: %s\n", cmd, strerror(rc));
+		if (pipeFd[0]>=0)
+			close(pipeFd[0]);
+		pRun->pid=0;
+		pRun->st.state=SRS_FAILED;
+		pRun->st.exitCode=-1;
+		snprintf(pRun->partial, sizeof(pRun->partial), "%s", strerror(rc));
+		pRun->partialLen=strlen(pRun->partial);
+		addLine(pRun);
+	}
+	else
+	{
+		fcntl(pipeFd[0], F_SETFL, fcntl(pipeFd[0], F_GETFL) | O_NONBLOCK);
+		pRun->fd=pipeFd[0];
+		pRun->st.state=SRS_RUNNING;
+	}
+	pthread_mutex_unlock(&srLock);
+
+	// Have the thread pick up the new pipe
+	if (write(wakeFd[1], "x", 1)<0 && errno!=EAGAIN)
+		fprintf(stderr, "aslLCD Error: Could not wake script thread\n");
+
+	return id;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srStatus
+Synopsis:
+	Gets where a script run is up to
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: from srRun()
+	SrStatus_t *pStatus: where to put it
+Outputs:
+	bool: FALSE if the run is too old to still be known
+-----------------------------------------------------------------------------*/
+bool srStatus(uint32_t id, SrStatus_t *pStatus)
+{
+	bool found=FALSE;
+
+	pthread_mutex_lock(&srLock);
+	for (int i=0; i<SR_MAX_RUNS && !found; ++i)
+	{
+		if (id && runs[i].id==id)
+		{
+			found=TRUE;
+			if (pStatus)
+			{
+				*pStatus=runs[i].st;
+				if (runs[i].pid)
+					pStatus->elapsed_ms=getClock_ms()-runs[i].start;
+			}
+		}
+	}
+	pthread_mutex_unlock(&srLock);
+
+	return found;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	srLine
+Synopsis:
+	Gets one of the output lines kept for a run
+Author:
+	John Gedde
+Inputs:
+	uint32_t id: from srRun()
+	uint16_t idx: 0 for the oldest kept, numLines-1 for the newest
+	char *buf: where to put it
+	size_t bufLen: size of buf
+Outputs:
+	bool: FALSE if there is no such line
+-----------------------------------------------------------------------------*/
+bool srLine(uint32_t id, uint16_t idx, char *buf, size_t bufLen)
+{
+	const SrRun_t *pRun=NULL;
+	bool found=FALSE;
+
+	pthread_mutex_lock(&srLock);
+	for (int i=0; i<SR_MAX_RUNS && !pRun; ++i)
+	{
+		if (id && runs[i].id==id)
+			pRun=&runs[i];
+	}
+	if (pRun && idx<pRun->st.numLines)
+	{
+		snprintf(buf, bufLen, "%s", pRun->lines[(pRun->head+SR_LINES-pRun->st.numLines+idx) % SR_LINES]);
+		found=TRUE;
+	}
+	pthread_mutex_unlock(&srLock);
+
+	return found;
+}
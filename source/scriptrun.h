@@ -0,0 +1,75 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  scriptrun.h
+*
+*  Synopsis:	Header file for scriptrun.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _SCRIPTRUN
+#define _SCRIPTRUN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SR_MAX_RUNS			4			// running + finished ones kept
+#define SR_LINES			16			// output lines kept per run
+#define SR_LINE_LEN			64
+#define SR_NAME_LEN			17
+#define SR_KILL_GRACE_MS	2000		// SIGTERM to SIGKILL
+
+typedef enum
+{
+	SRS_RUNNING=0,
+	SRS_DONE,					// exit code 0
+	SRS_FAILED,					// non-zero exit, killed by a signal,
+								// or couldn't be started
+	SRS_TIMEOUT
+} SrState_t;
+
+typedef struct
+{
+	char name[SR_NAME_LEN];
+	SrState_t state;
+	int exitCode;				// exit code or the signal number
+	uint32_t elapsed_ms;
+	uint16_t numLines;			// output lines kept (SR_LINES at most)
+	uint32_t totalLines;		// output lines seen
+} SrStatus_t;
+
+// Called from the script thread when a run gets output or finishes
+typedef void (*SrChangeFn_t)(uint32_t id);
+
+void 		srStart(SrChangeFn_t changeFn);
+void 		srStop();
+uint32_t 	srRun(const char *name, const char *cmd, uint32_t timeout_ms, uint16_t maxRunning);
+bool 		srIsRunning(const char *name);
+bool 		srStatus(uint32_t id, SrStatus_t *pStatus);
+bool 		srLine(uint32_t id, uint16_t idx, char *buf, size_t bufLen);
+
+#endif
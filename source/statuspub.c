@@ -0,0 +1,240 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  statuspub.c
+*
+*  Synopsis:	Pushes node status changes to clients that sent SUB on the
+*				backlight command port.  Every message carries a sequence
+*				number so a client can tell if it missed one:
+*
+*					S <seq> <status bits in hex> <selected local node>
+*
+*				Status bits are the PTT_UP, COS_UP, etc. bits in
+*				backlight.h.  Only the backlight thread calls in here.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "statuspub.h"
+#include "main.h"
+
+static int subFds[MAX_SUBSCRIBERS]={ -1, -1, -1, -1, -1, -1, -1, -1 };
+static uint32_t pubSeq=0;
+
+/*-----------------------------------------------------------------------------
+Function:
+	sendStatus
+Synopsis:
+	Sends one status message to one subscriber.  If the client isn't
+	keeping up the message is dropped (they'll see the gap in sequence
+	numbers).  If the client has gone away it is removed.
+Author:
+	John Gedde
+Inputs:
+	int idx: subscriber index
+	const char *msg: the message
+	int len: message length
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void sendStatus(int idx, const char *msg, int len)
+{
+	if (send(subFds[idx], msg, len, MSG_NOSIGNAL | MSG_DONTWAIT) < 0 &&
+		errno!=EAGAIN && errno!=EWOULDBLOCK)
+	{
+		close(subFds[idx]);
+		subFds[idx]=-1;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pubAddSubscriber
+Synopsis:
+	Adds a client to the subscriber list and sends it the current status.
+	The socket belongs to this module from here on (it is closed if there
+	is no room.)
+Author:
+	John Gedde
+Inputs:
+	int fd: connected client socket
+	uint16_t statusBits: current status bits
+	uint32_t localNode: currently selected local node
+Outputs:
+	bool: TRUE if added
+-----------------------------------------------------------------------------*/
+bool pubAddSubscriber(int fd, uint16_t statusBits, uint32_t localNode)
+{
+	char msg[48];
+	int len;
+
+	for (int i=0; i<MAX_SUBSCRIBERS; ++i)
+	{
+		if (subFds[i]<0)
+		{
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			subFds[i]=fd;
+
+			// Snapshot so the client starts out in sync
+			len=sprintf(msg, "S %u %04X %u\n", pubSeq, statusBits, localNode);
+			sendStatus(i, msg, len);
+			return TRUE;
+		}
+	}
+
+	fprintf(stderr, "aslLCD Warning: Too many status subscribers\n");
+	close(fd);
+	return FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pubPollFds
+Synopsis:
+	Fills in pollfd entries for the subscriber sockets so the caller's
+	poll() notices when a client hangs up.
+Author:
+	John Gedde
+Inputs:
+	struct pollfd *pfds: where to put the entries
+	int maxFds: room in pfds
+Outputs:
+	int: number of entries filled in
+-----------------------------------------------------------------------------*/
+int pubPollFds(struct pollfd *pfds, int maxFds)
+{
+	int n=0;
+
+	for (int i=0; i<MAX_SUBSCRIBERS && n<maxFds; ++i)
+	{
+		if (subFds[i]>=0)
+		{
+			pfds[n].fd=subFds[i];
+			pfds[n].events=POLLIN;
+			pfds[n].revents=0;
+			n++;
+		}
+	}
+	return n;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pubServicePollFds
+Synopsis:
+	Handles poll() results for the subscriber sockets.  Anything a client
+	sends is thrown away; a client that closed is removed.
+Author:
+	John Gedde
+Inputs:
+	const struct pollfd *pfds: entries from pubPollFds() after poll()
+	int numFds: number of entries
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pubServicePollFds(const struct pollfd *pfds, int numFds)
+{
+	char buf[64];
+
+	for (int n=0; n<numFds; ++n)
+	{
+		if (pfds[n].revents==0)
+			continue;
+
+		for (int i=0; i<MAX_SUBSCRIBERS; ++i)
+		{
+			if (subFds[i]==pfds[n].fd)
+			{
+				if ((pfds[n].revents & (POLLERR | POLLHUP | POLLNVAL)) ||
+					recv(subFds[i], buf, sizeof(buf), MSG_DONTWAIT)==0)
+				{
+					close(subFds[i]);
+					subFds[i]=-1;
+				}
+				break;
+			}
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pubPublish
+Synopsis:
+	Sends a status change to every subscriber.  The sequence number goes
+	up by one for each change whether or not anyone is listening.
+Author:
+	John Gedde
+Inputs:
+	uint16_t statusBits: current status bits
+	uint32_t localNode: currently selected local node
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pubPublish(uint16_t statusBits, uint32_t localNode)
+{
+	char msg[48];
+	int len;
+
+	len=sprintf(msg, "S %u %04X %u\n", ++pubSeq, statusBits, localNode);
+
+	for (int i=0; i<MAX_SUBSCRIBERS; ++i)
+	{
+		if (subFds[i]>=0)
+			sendStatus(i, msg, len);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	pubCloseAll
+Synopsis:
+	Drops all subscribers
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void pubCloseAll()
+{
+	for (int i=0; i<MAX_SUBSCRIBERS; ++i)
+	{
+		if (subFds[i]>=0)
+		{
+			close(subFds[i]);
+			subFds[i]=-1;
+		}
+	}
+}
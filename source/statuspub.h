@@ -0,0 +1,49 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  statuspub.h
+*
+*  Synopsis:	Header file for statuspub.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _STATUSPUB
+#define _STATUSPUB
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <poll.h>
+
+#define MAX_SUBSCRIBERS		8
+
+bool 	pubAddSubscriber(int fd, uint16_t statusBits, uint32_t localNode);
+int 	pubPollFds(struct pollfd *pfds, int maxFds);
+void 	pubServicePollFds(const struct pollfd *pfds, int numFds);
+void 	pubPublish(uint16_t statusBits, uint32_t localNode);
+void 	pubCloseAll();
+
+#endif
@@ -0,0 +1,262 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  statusshm.c
+*
+*  Synopsis:	Publishes node status to shared memory for local programs.
+*				See statusshm.h for the layout.  Both of our threads write
+*				here so writers take a mutex; readers never do.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  CPU temperature comes in tenths of a degree
+*  10/19/26  | John Gedde   |  Reset an existing segment under the seqlock
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "statusshm.h"
+#include "backlight.h"
+#include "clockfunc.h"
+#include "main.h"
+
+static AslLcdShm_t *pShm=NULL;
+static pthread_mutex_t shmLock=PTHREAD_MUTEX_INITIALIZER;
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmInit
+Synopsis:
+	Creates and maps the status segment, or takes over the one left by
+	an earlier run
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmInit()
+{
+	int fd;
+	void *p;
+
+	fd=shm_open(ASLLCD_SHM_NAME, O_CREAT | O_RDWR, 0644);
+	if (fd<0)
+	{
+		fprintf(stderr, "aslLCD Error: Couldn't create status shared memory\n");
+		return;
+	}
+
+	if (ftruncate(fd, sizeof(AslLcdShm_t))!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Couldn't size status shared memory\n");
+		close(fd);
+		return;
+	}
+
+	p=mmap(NULL, sizeof(AslLcdShm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p==MAP_FAILED)
+	{
+		fprintf(stderr, "aslLCD Error: Couldn't map status shared memory\n");
+		return;
+	}
+
+	// Readers may still have the segment from a run before this one, so
+	// it's reset like any other write.  seq is left odd if that run died
+	// in the middle of one.
+	pthread_mutex_lock(&shmLock);
+	pShm=p;
+	__atomic_store_n(&pShm->seq, pShm->seq | 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memset((char *)pShm+offsetof(AslLcdShm_t, reserved), 0, sizeof(AslLcdShm_t)-offsetof(AslLcdShm_t, reserved));
+	pShm->magic=ASLLCD_SHM_MAGIC;
+	pShm->version=ASLLCD_SHM_VERSION;
+	pShm->cpuTemp_dC=ASLLCD_SHM_NO_TEMP;
+	pShm->updated_ms=getClock_ms();
+	__atomic_store_n(&pShm->seq, pShm->seq+1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&shmLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmClose
+Synopsis:
+	Unmaps and removes the status segment
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmClose()
+{
+	pthread_mutex_lock(&shmLock);
+	if (pShm)
+	{
+		munmap(pShm, sizeof(AslLcdShm_t));
+		pShm=NULL;
+		shm_unlink(ASLLCD_SHM_NAME);
+	}
+	pthread_mutex_unlock(&shmLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmWriteBegin / shmWriteEnd
+Synopsis:
+	Bracket every write to the segment.  seq goes odd, the data changes,
+	then seq goes even again.
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	bool (shmWriteBegin): TRUE if the segment is there to write to
+-----------------------------------------------------------------------------*/
+static bool shmWriteBegin()
+{
+	pthread_mutex_lock(&shmLock);
+	if (!pShm)
+	{
+		pthread_mutex_unlock(&shmLock);
+		return FALSE;
+	}
+	__atomic_store_n(&pShm->seq, pShm->seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return TRUE;
+}
+
+static void shmWriteEnd()
+{
+	pShm->updated_ms=getClock_ms();
+	__atomic_store_n(&pShm->seq, pShm->seq+1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&shmLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmPublishStatus
+Synopsis:
+	Publishes status bits and the selected local node
+Author:
+	John Gedde
+Inputs:
+	uint16_t statusBits: PTT_UP, COS_UP, etc.
+	uint32_t selectedLocalNode: currently selected local node
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmPublishStatus(uint16_t statusBits, uint32_t selectedLocalNode)
+{
+	if (shmWriteBegin())
+	{
+		pShm->statusBits=statusBits;
+		pShm->cosKeyed=(statusBits & COS_UP) ? 1 : 0;
+		pShm->pttKeyed=(statusBits & PTT_UP) ? 1 : 0;
+		pShm->selectedLocalNode=selectedLocalNode;
+		shmWriteEnd();
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmPublishLinks
+Synopsis:
+	Publishes the list of nodes connected to the selected local node
+Author:
+	John Gedde
+Inputs:
+	const AslLcdShmLink_t *links: connected nodes
+	uint16_t numLinks: number of connected nodes
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmPublishLinks(const AslLcdShmLink_t *links, uint16_t numLinks)
+{
+	if (numLinks>ASLLCD_SHM_MAX_LINKS)
+		numLinks=ASLLCD_SHM_MAX_LINKS;
+
+	if (shmWriteBegin())
+	{
+		memset(pShm->links, 0, sizeof(pShm->links));
+		if (links && numLinks)
+			memcpy(pShm->links, links, numLinks*sizeof(AslLcdShmLink_t));
+		pShm->numLinks=numLinks;
+		shmWriteEnd();
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmPublishIP
+Synopsis:
+	Publishes our IP address
+Author:
+	John Gedde
+Inputs:
+	const char *ipAddr: IP address (may be space padded) or empty string
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmPublishIP(const char *ipAddr)
+{
+	if (shmWriteBegin())
+	{
+		memset(pShm->ipAddr, 0, sizeof(pShm->ipAddr));
+		for (unsigned int i=0; i<sizeof(pShm->ipAddr)-1 && ipAddr[i] && ipAddr[i]!=' '; ++i)
+			pShm->ipAddr[i]=ipAddr[i];
+		shmWriteEnd();
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	shmPublishTemp
+Synopsis:
+	Publishes the CPU temperature
+Author:
+	John Gedde
+Inputs:
+	int16_t temp_dC: temperature in tenths of a degree C
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void shmPublishTemp(int16_t temp_dC)
+{
+	if (shmWriteBegin())
+	{
+		pShm->cpuTemp_dC=temp_dC;
+		shmWriteEnd();
+	}
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  statusshm.h
+*
+*  Synopsis:	Layout of the aslLCD status segment in shared memory
+*				(/dev/shm/aslLCD) and a reader for other programs to use.
+*				Include this file, shm_open() ASLLCD_SHM_NAME read only,
+*				mmap() it and call aslLcdShmRead() as often as you like.
+*				Readers never block aslLCD.
+*
+*				The segment is guarded by a sequence lock: seq is odd
+*				while aslLCD is writing.  A read is good if seq was even
+*				and didn't change while the data was being copied.
+*
+*				Status bits are the PTT_UP, COS_UP, etc. bits from
+*				backlight.h.  Links are updated whenever aslLCD reads
+*				them, CPU temperature every sample_s seconds.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  shmPublishTemp() takes tenths of a degree
+*
+****************************************************************************/
+
+#ifndef _STATUSSHM
+#define _STATUSSHM
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define ASLLCD_SHM_NAME			"/aslLCD"
+#define ASLLCD_SHM_MAGIC		0x43534C41	// "ALSC"
+#define ASLLCD_SHM_VERSION		1
+#define ASLLCD_SHM_MAX_LINKS	20
+#define ASLLCD_SHM_NO_TEMP		INT16_MIN
+
+typedef struct
+{
+	uint32_t nodeNum;
+	char connType[12];
+} AslLcdShmLink_t;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seq;					// odd while being written
+	uint32_t reserved;
+	uint64_t updated_ms;			// ms since epoch of last write
+	uint16_t statusBits;
+	uint8_t cosKeyed;
+	uint8_t pttKeyed;
+	uint32_t selectedLocalNode;
+	uint16_t numLinks;
+	uint16_t reserved2;
+	AslLcdShmLink_t links[ASLLCD_SHM_MAX_LINKS];
+	char ipAddr[20];
+	int16_t cpuTemp_dC;				// tenths of a degree C
+	uint16_t reserved3;
+} AslLcdShm_t;
+
+/*-----------------------------------------------------------------------------
+Function:
+	aslLcdShmRead
+Synopsis:
+	Takes a consistent copy of the status segment.
+Author:
+	John Gedde
+Inputs:
+	const AslLcdShm_t *shm: the mapped segment
+	AslLcdShm_t *out: where to put the copy
+Outputs:
+	bool: true if out holds a good copy, false if aslLCD was busy writing
+		  every time we looked (just try again later)
+-----------------------------------------------------------------------------*/
+static inline bool aslLcdShmRead(const AslLcdShm_t *shm, AslLcdShm_t *out)
+{
+	uint32_t seq1, seq2;
+
+	for (int tries=0; tries<100; ++tries)
+	{
+		seq1=__atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+		if (seq1 & 1)
+			continue;
+
+		memcpy(out, (const void*)shm, sizeof(*out));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2=__atomic_load_n(&shm->seq, __ATOMIC_RELAXED);
+		if (seq1==seq2)
+			return out->magic==ASLLCD_SHM_MAGIC;
+	}
+	return false;
+}
+
+// Writer side (aslLCD only)
+void shmInit();
+void shmClose();
+void shmPublishStatus(uint16_t statusBits, uint32_t selectedLocalNode);
+void shmPublishLinks(const AslLcdShmLink_t *links, uint16_t numLinks);
+void shmPublishIP(const char *ipAddr);
+void shmPublishTemp(int16_t temp_dC);
+
+#endif
@@ -0,0 +1,480 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  textentry.c
+*
+*  Synopsis:	Text entry on the LCD with five buttons, for node numbers
+*				and wifi passwords.  UP/DOWN step through the characters
+*				allowed; held down they repeat, faster the longer they're
+*				held.  UP+DOWN together jumps to the next kind of
+*				character (digits, lower case, upper case, symbols, then
+*				blank) so a letter is never more than a few steps away.
+*				The first UP/DOWN on a blank starts in the same kind as
+*				the character to its left.  LEFT/RIGHT move; LEFT past the
+*				start asks to cancel.  If the caller can suggest the rest
+*				of the text it's shown on line 1 and RIGHT at the end of
+*				what's typed fills it in.  The caller can also say which
+*				characters can come next; UP/DOWN skip the others.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Suggestions (recent node numbers)
+*  10/19/26  | John Gedde   |  Only step through characters the caller allows
+*            |              |  (callsign search)
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "textentry.h"
+#include "lcdfunc.h"
+#include "clockfunc.h"
+#include "main.h"
+
+// First repeat after conf->fastUpDownWait_ms, then every TE_REPEAT_START_MS
+// getting TE_REPEAT_SPEEDUP % shorter each time down to
+// conf->fastUpDownRate_ms
+#define TE_REPEAT_START_MS	250
+#define TE_REPEAT_SPEEDUP	20
+
+static const char * const teClassChars[TE_CLASS_MAX]=
+{
+	"0123456789",
+	"abcdefghijklmnopqrstuvwxyz",
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+	"!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+};
+
+/*-----------------------------------------------------------------------------
+Function:
+	teInit
+Synopsis:
+	Sets up a text entry before pushing textEntryScreen
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+	ConfStr_t heading: line 1
+	uint8_t classes: TE_CLASS_BIT()s allowed
+	uint8_t minLen: shortest text SELECT takes (tooShort is shown if
+					it's shorter)
+	uint8_t maxLen: longest text, TE_MAX_LEN at most
+	char blank: how an empty spot looks
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void teInit(TextEntry_t *pTe, ConfStr_t heading, uint8_t classes, uint8_t minLen, uint8_t maxLen, char blank)
+{
+	memset(pTe, 0, sizeof(*pTe));
+	pTe->heading=heading;
+	pTe->minLen=minLen;
+	pTe->tooShort=STR_MSG_AT_LEAST_8_CHARS;
+	pTe->maxLen=(maxLen>TE_MAX_LEN) ? TE_MAX_LEN : maxLen;
+	pTe->blank=blank;
+
+	pTe->alphabet[pTe->alphaLen++]=' ';
+	for (uint8_t c=0; c<TE_CLASS_MAX; ++c)
+	{
+		pTe->classStart[c]=pTe->alphaLen;
+		if (classes & TE_CLASS_BIT(c))
+		{
+			strcpy(pTe->alphabet+pTe->alphaLen, teClassChars[c]);
+			pTe->alphaLen+=strlen(teClassChars[c]);
+		}
+	}
+	pTe->classStart[TE_CLASS_MAX]=pTe->alphaLen;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teClassOf
+Synopsis:
+	Which kind of character an alphabet[] entry is
+Author:
+	John Gedde
+Inputs:
+	const TextEntry_t *pTe: the entry
+	uint16_t idx: in alphabet[]
+Outputs:
+	int: TeClass_t, -1 for the blank
+-----------------------------------------------------------------------------*/
+static int teClassOf(const TextEntry_t *pTe, uint16_t idx)
+{
+	for (int c=TE_CLASS_MAX-1; c>=0; --c)
+	{
+		if (pTe->classStart[c]<pTe->classStart[c+1] && idx>=pTe->classStart[c])
+			return c;
+	}
+	return -1;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teDraw
+Synopsis:
+	Shows the part of the text around the cursor on line 2
+Author:
+	John Gedde
+Inputs:
+	const TextEntry_t *pTe: the entry
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teDraw(const TextEntry_t *pTe)
+{
+	char lcdBuf[17];
+	int16_t start=(pTe->pos>15) ? pTe->pos-15 : 0;
+
+	memset(lcdBuf, ' ', 16);
+	lcdBuf[16]='\0';
+	for (int16_t i=0; i<16 && start+i<pTe->maxLen; ++i)
+		lcdBuf[i]=(pTe->text[start+i]==' ') ? pTe->blank : pTe->text[start+i];
+
+	lcdWriteLn(lcdBuf, LCD_LINE2, FALSE);
+	lcdPositionCursor(LCD_LINE2, pTe->pos-start);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teSuggest
+Synopsis:
+	Asks for a suggestion for what's typed so far.  Line 1 shows the hint
+	that comes with it, or the heading if there isn't one.
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teSuggest(TextEntry_t *pTe)
+{
+	char typed[TE_MAX_LEN+1];
+	char suggestion[TE_MAX_LEN+1]="";
+	char hint[CONF_STR_LEN+1]="";
+	size_t len;
+
+	if (pTe->suggest==NULL)
+		return;
+
+	strcpy(typed, pTe->text);
+	for (len=strlen(typed); len>0 && typed[len-1]==' '; --len)
+		;
+	typed[len]='\0';
+
+	pTe->suggestion[0]='\0';
+	if (pTe->suggest(typed, suggestion, hint))
+	{
+		// Only worth taking if it adds something
+		if (strlen(suggestion)>len && strlen(suggestion)<=pTe->maxLen)
+			strcpy(pTe->suggestion, suggestion);
+		lcdWriteLn(hint, LCD_LINE1, FALSE);
+		pTe->hinted=TRUE;
+	}
+	else if (pTe->hinted)
+	{
+		lcdWriteLn(confStr(pTe->heading), LCD_LINE1, FALSE);
+		pTe->hinted=FALSE;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teAllowed
+Synopsis:
+	Whether alphabet[idx] can go at the cursor after what's before it.
+	The blank always can.
+Author:
+	John Gedde
+Inputs:
+	const TextEntry_t *pTe: the entry
+	uint16_t idx: in alphabet[]
+Outputs:
+	bool: TRUE if it can
+-----------------------------------------------------------------------------*/
+static bool teAllowed(const TextEntry_t *pTe, uint16_t idx)
+{
+	char before[TE_MAX_LEN+1];
+
+	if (idx==0 || pTe->allow==NULL)
+		return TRUE;
+
+	memcpy(before, pTe->text, pTe->pos);
+	before[pTe->pos]='\0';
+	return pTe->allow(before, pTe->alphabet[idx]);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teSet
+Synopsis:
+	Puts alphabet[idx] at the cursor
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+	uint16_t idx: in alphabet[]
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teSet(TextEntry_t *pTe, uint16_t idx)
+{
+	pTe->charIdx=idx;
+	pTe->text[pTe->pos]=pTe->alphabet[idx];
+	teSuggest(pTe);
+	teDraw(pTe);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teStep
+Synopsis:
+	One UP/DOWN step.  On a blank the first step starts in the kind of 
+	character to the left: its first one for UP, last one for DOWN.  If
+	that character isn't in the alphabet it steps from the blank.
+	Characters that aren't allowed are stepped over.
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+	uint16_t buttons: BTN_UP or BTN_DOWN
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teStep(TextEntry_t *pTe, uint16_t buttons)
+{
+	const char *p;
+	int c=-1;
+	uint16_t idx;
+
+	pTe->prevIdx=pTe->charIdx;
+	if (pTe->charIdx==0 && pTe->pos>0)
+	{
+		// A character that isn't in the alphabet (e.g. '-' filled in from a
+		// suggestion) has no kind
+		p=strchr(pTe->alphabet, pTe->text[pTe->pos-1]);
+		if (p && *p)
+			c=teClassOf(pTe, (uint16_t)(p-pTe->alphabet));
+	}
+
+	if (c>=0)
+		idx=(buttons & BTN_UP) ? pTe->classStart[c] : pTe->classStart[c+1]-1;
+	else
+		idx=uiWrap(pTe->charIdx, pTe->alphaLen, buttons);
+
+	// Gets to the blank at worst
+	while (!teAllowed(pTe, idx))
+		idx=uiWrap(idx, pTe->alphaLen, buttons);
+	teSet(pTe, idx);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teJump
+Synopsis:
+	UP+DOWN: first character of the next kind, after the last kind the
+	blank.  Starts from where the character was before the UP or DOWN
+	that made the chord.  Kinds with nothing allowed are skipped.
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teJump(TextEntry_t *pTe)
+{
+	int c=teClassOf(pTe, pTe->prevIdx);
+
+	for (++c; c<TE_CLASS_MAX; ++c)
+	{
+		for (uint16_t idx=pTe->classStart[c]; idx<pTe->classStart[c+1]; ++idx)
+		{
+			if (teAllowed(pTe, idx))
+			{
+				teSet(pTe, idx);
+				return;
+			}
+		}
+	}
+	teSet(pTe, 0);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	teMove
+Synopsis:
+	Moves the cursor to pos
+Author:
+	John Gedde
+Inputs:
+	TextEntry_t *pTe: the entry
+	int16_t pos: where to, -1 for the cancel prompt
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void teMove(TextEntry_t *pTe, int16_t pos)
+{
+	const char *p;
+
+	pTe->pos=pos;
+	if (pos<0)
+	{
+		lcdCursorEnable(FALSE);
+		lcdWriteLn(confStr(STR_MSG_CANCEL_PROMPT), LCD_LINE2, FALSE);
+		return;
+	}
+
+	p=strchr(pTe->alphabet, pTe->text[pos]);
+	pTe->charIdx=p ? p-pTe->alphabet : 0;
+	pTe->prevIdx=pTe->charIdx;
+	lcdCursorEnable(TRUE);
+	teDraw(pTe);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	textEntryScreen handlers
+Synopsis:
+	Text entry.  Closes with TRUE when SELECT takes the text, FALSE if it
+	was cancelled.
+Author:
+	John Gedde
+Inputs:
+	void *ctx: TextEntry_t
+	const UiEvent_t *ev: event
+	uint64_t now: current time in ms
+Outputs:
+	uint64_t: next repeat
+-----------------------------------------------------------------------------*/
+static void textEntryEnter(void *ctx)
+{
+	TextEntry_t *pTe=ctx;
+
+	memset(pTe->text, ' ', pTe->maxLen);
+	pTe->text[pTe->maxLen]='\0';
+
+	lcdClearScreen();
+	lcdWriteLn(confStr(pTe->heading), LCD_LINE1, FALSE);
+	pTe->suggestion[0]='\0';
+	pTe->hinted=FALSE;
+	teSuggest(pTe);
+	teMove(pTe, 0);
+}
+
+static void textEntryEvent(void *ctx, const UiEvent_t *ev)
+{
+	TextEntry_t *pTe=ctx;
+	uint16_t len;
+
+	if (ev->type!=UI_EV_BUTTON)
+		return;
+
+	if ((ev->buttons & BTN_UP) || (ev->buttons & BTN_DOWN))
+	{
+		if (pTe->pos<0)
+			return;
+		if ((ev->held & BTN_UP) && (ev->held & BTN_DOWN))
+			teJump(pTe);
+		else
+		{
+			teStep(pTe, ev->buttons);
+
+			// Held down repeats after a bit
+			pTe->repeats=0;
+			pTe->repeat_ms=TE_REPEAT_START_MS;
+			uiTickAt(getClock_ms()+conf->fastUpDownWait_ms);
+		}
+	}
+	else if (ev->buttons & BTN_LEFT)
+	{
+		if (pTe->pos>=0)
+			teMove(pTe, pTe->pos-1);
+	}
+	else if (ev->buttons & BTN_RIGHT)
+	{
+		// At the end of what's typed: take the suggestion
+		for (len=strlen(pTe->text); len>0 && pTe->text[len-1]==' '; --len)
+			;
+		if (pTe->suggestion[0]!='\0' && pTe->pos>=(int16_t)len-1)
+		{
+			len=strlen(pTe->suggestion);
+			memcpy(pTe->text, pTe->suggestion, len);
+			teSuggest(pTe);
+			teMove(pTe, len-1);
+		}
+		else
+			teMove(pTe, (pTe->pos<pTe->maxLen-1) ? pTe->pos+1 : pTe->pos);
+	}
+	else if (ev->buttons & BTN_SELECT)
+	{
+		if (pTe->pos<0)
+		{
+			uiPop(FALSE);
+			return;
+		}
+
+		// Trailing blanks don't count
+		for (len=strlen(pTe->text); len>0 && pTe->text[len-1]==' '; --len)
+			;
+		if (len<pTe->minLen)
+		{
+			lcdWriteLn(confStr(pTe->tooShort), LCD_LINE1, FALSE);
+			teDraw(pTe);
+			return;
+		}
+		pTe->text[len]='\0';
+		uiPop(TRUE);
+	}
+}
+
+static uint64_t textEntryTick(void *ctx, uint64_t now)
+{
+	TextEntry_t *pTe=ctx;
+	uint16_t held=uiHeld() & (BTN_UP | BTN_DOWN);
+
+	// Nothing held, or both (that was a jump)
+	if (pTe->pos<0 || held==0 || held==(BTN_UP | BTN_DOWN))
+		return UI_NO_TICK;
+
+	teStep(pTe, held);
+	pTe->repeats++;
+	if (pTe->repeats>1)
+		pTe->repeat_ms-=pTe->repeat_ms*TE_REPEAT_SPEEDUP/100;
+	if (pTe->repeat_ms<conf->fastUpDownRate_ms)
+		pTe->repeat_ms=conf->fastUpDownRate_ms;
+	return now+pTe->repeat_ms;
+}
+
+static void textEntryExit(void *ctx)
+{
+	(void)ctx;
+	lcdCursorEnable(FALSE);
+}
+
+const UiScreen_t textEntryScreen=
+{
+	"text entry", textEntryEnter, textEntryEvent, textEntryTick, textEntryExit
+};
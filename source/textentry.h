@@ -0,0 +1,97 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  textentry.h
+*
+*  Synopsis:	Header file for textentry.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  Suggestions
+*  10/19/26  | John Gedde   |  allow
+*
+****************************************************************************/
+
+#ifndef _TEXTENTRY
+#define _TEXTENTRY
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ini.h"
+#include "ui.h"
+
+#define TE_MAX_LEN			63			// longest WPA passphrase
+
+// Kinds of character.  UP+DOWN together jumps to the next kind.
+typedef enum
+{
+	TE_CLASS_DIGIT=0,
+	TE_CLASS_LOWER,
+	TE_CLASS_UPPER,
+	TE_CLASS_SYMBOL,
+	TE_CLASS_MAX
+} TeClass_t;
+
+#define TE_CLASS_BIT(c)		(1<<(c))
+#define TE_DIGITS			TE_CLASS_BIT(TE_CLASS_DIGIT)
+#define TE_ANY				(TE_CLASS_BIT(TE_CLASS_MAX)-1)
+
+// What's being entered.  Set up with teInit() then push textEntryScreen
+// with it.  It closes with TRUE and the text in text[] (trailing blanks
+// gone) or FALSE if cancelled.  These can be set after teInit():
+//	suggest: asked for a longer text starting with what's been typed, and
+//		something to show on line 1 about it (16 chars).  RIGHT at the end
+//		of the typed text takes the suggestion.
+//	allow: whether a character can come after the ones before the cursor.
+//		UP/DOWN skip the ones that can't.
+//	tooShort: shown when SELECT is pressed on fewer than minLen characters.
+//		STR_MSG_AT_LEAST_8_CHARS unless changed.
+typedef struct
+{
+	ConfStr_t heading;					// line 1
+	uint8_t minLen;
+	ConfStr_t tooShort;					// when it's shorter than minLen
+	uint8_t maxLen;
+	char blank;							// how an empty spot looks
+	char alphabet[100];					// ' ' then the classes allowed
+	uint8_t alphaLen;
+	uint8_t classStart[TE_CLASS_MAX+1];	// first of each in alphabet[]
+	char text[TE_MAX_LEN+1];
+	int16_t pos;						// -1: cancel prompt
+	uint16_t charIdx;					// text[pos] in alphabet[]
+	uint16_t prevIdx;					// before the last UP/DOWN
+	uint16_t repeats;					// while UP/DOWN is held
+	uint16_t repeat_ms;
+	bool (*suggest)(const char *typed, char *pText, char *pHint);
+	bool (*allow)(const char *before, char c);
+	char suggestion[TE_MAX_LEN+1];		// "" if there isn't one
+	bool hinted;						// line 1 has a hint, not the heading
+} TextEntry_t;
+
+extern const UiScreen_t textEntryScreen;
+
+void 		teInit(TextEntry_t *pTe, ConfStr_t heading, uint8_t classes, uint8_t minLen, uint8_t maxLen, char blank);
+
+#endif
@@ -0,0 +1,370 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  ui.c
+*
+*  Synopsis:	Screen stack and the one event loop that drives the LCD
+*				user interface.  Each screen is a set of handlers (enter,
+*				event, tick, exit) rather than a loop of its own, so nothing
+*				on the screen waits on anything else.  The loop scans the
+*				buttons, hands out ticks when screens ask for them and
+*				passes on background data changes posted by other threads.
+*
+*				A screen opens another with uiPush().  When that one is
+*				done it calls uiPop() with a result, which comes back to
+*				the screen underneath as a UI_EV_RESULT event.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  uiTop() and uiIdle_ms() for the dashboard
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "ui.h"
+#include "main.h"
+#include "clockfunc.h"
+
+typedef struct
+{
+	const UiScreen_t *screen;
+	void *ctx;
+	uint64_t nextTick;
+} UiFrame_t;
+
+static UiFrame_t stack[UI_MAX_DEPTH];
+static int depth=0;
+static bool quit=FALSE;
+static uint32_t pendingData=0;
+static uint16_t held=0;
+static uint64_t lastPress_ms=0;
+
+/*-----------------------------------------------------------------------------
+Function:
+	sendEvent
+Synopsis:
+	Gives an event to the screen on top
+Author:
+	John Gedde
+Inputs:
+	const UiEvent_t *ev: the event
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void sendEvent(const UiEvent_t *ev)
+{
+	UiFrame_t *f;
+
+	if (depth==0)
+		return;
+	f=&stack[depth-1];
+	if (f->screen->event)
+		f->screen->event(f->ctx, ev);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiPush
+Synopsis:
+	Opens a screen on top of the current one
+Author:
+	John Gedde
+Inputs:
+	const UiScreen_t *screen: the screen
+	void *ctx: handed to the screen's handlers
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiPush(const UiScreen_t *screen, void *ctx)
+{
+	if (depth>=UI_MAX_DEPTH)
+	{
+		fprintf(stderr, "aslLCD Error: Screens nested too deep opening %s\n", screen->name);
+		return;
+	}
+
+	stack[depth].screen=screen;
+	stack[depth].ctx=ctx;
+	stack[depth].nextTick=screen->tick ? 0 : UI_NO_TICK;
+	depth++;
+
+	if (screen->enter)
+		screen->enter(ctx);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	closeTop
+Synopsis:
+	Takes the top screen off the stack
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	const UiScreen_t *: the screen closed
+-----------------------------------------------------------------------------*/
+static const UiScreen_t *closeTop()
+{
+	UiFrame_t f;
+
+	f=stack[--depth];
+	if (f.screen->exit)
+		f.screen->exit(f.ctx);
+
+	return f.screen;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiPop
+Synopsis:
+	Closes the top screen.  The one underneath gets a UI_EV_RESULT and an
+	immediate tick so it can redraw.
+Author:
+	John Gedde
+Inputs:
+	int32_t result: passed back to the screen underneath
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiPop(int32_t result)
+{
+	UiEvent_t ev={ 0 };
+
+	if (depth==0)
+		return;
+
+	ev.type=UI_EV_RESULT;
+	ev.from=closeTop();
+	ev.result=result;
+
+	if (depth>0)
+	{
+		if (stack[depth-1].screen->tick)
+			stack[depth-1].nextTick=0;
+		sendEvent(&ev);
+	}
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiReplace
+Synopsis:
+	Closes the top screen and opens another in its place.  The screen
+	underneath doesn't hear about it until the new one is popped.
+Author:
+	John Gedde
+Inputs:
+	const UiScreen_t *screen: the new screen
+	void *ctx: handed to the screen's handlers
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiReplace(const UiScreen_t *screen, void *ctx)
+{
+	if (depth>0)
+		closeTop();
+	uiPush(screen, ctx);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiTickAt
+Synopsis:
+	Changes when the top screen next gets a tick (e.g. redraw right away
+	after a button press)
+Author:
+	John Gedde
+Inputs:
+	uint64_t when: getClock_ms() time, 0 for now
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiTickAt(uint64_t when)
+{
+	if (depth>0 && stack[depth-1].screen->tick)
+		stack[depth-1].nextTick=when;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiQuit
+Synopsis:
+	Makes uiRun() return after the current handler
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiQuit()
+{
+	quit=TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiNotify
+Synopsis:
+	Posts a background data change to the screen on top.  Safe from any
+	thread; changes are collected and given out on the next pass.
+Author:
+	John Gedde
+Inputs:
+	uint32_t data: UI_DATA_XXX bits
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiNotify(uint32_t data)
+{
+	__atomic_fetch_or(&pendingData, data, __ATOMIC_RELEASE);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiHeld
+Synopsis:
+	Buttons held down as of the last scan, for screens that repeat while
+	a button is held
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	uint16_t: BTN_XXX bits
+-----------------------------------------------------------------------------*/
+uint16_t uiHeld()
+{
+	return held;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiTop
+Synopsis:
+	The screen on top of the stack
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	const UiScreen_t *: the screen, NULL if none
+-----------------------------------------------------------------------------*/
+const UiScreen_t *uiTop()
+{
+	return (depth>0) ? stack[depth-1].screen : NULL;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiIdle_ms
+Synopsis:
+	How long since a button was last pressed (or uiRun() started)
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	uint64_t: time in ms
+-----------------------------------------------------------------------------*/
+uint64_t uiIdle_ms()
+{
+	return getClock_ms()-lastPress_ms;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiRun
+Synopsis:
+	The event loop.  Runs until uiQuit() or the last screen is popped,
+	then closes anything still open.  A button counts as pressed when it
+	goes down; holding it or letting go of another button doesn't repeat.
+Author:
+	John Gedde
+Inputs:
+	void (*pollFn)(): called every pass to look for background changes,
+					  or NULL
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void uiRun(void (*pollFn)())
+{
+	UiEvent_t ev;
+	UiFrame_t *f;
+	const UiScreen_t *screen;
+	uint16_t lastHeld, pressed;
+	uint32_t data;
+	uint64_t now, next;
+	int level;
+
+	quit=FALSE;
+	held=lastHeld=readButtons();
+	lastPress_ms=getClock_ms();
+
+	while (!quit && depth>0)
+	{
+		if (pollFn)
+			pollFn();
+
+		data=__atomic_exchange_n(&pendingData, 0, __ATOMIC_ACQUIRE);
+		if (data)
+		{
+			ev=(UiEvent_t){ .type=UI_EV_DATA, .data=data };
+			sendEvent(&ev);
+		}
+
+		held=readButtons();
+		pressed=held & ~lastHeld;
+		lastHeld=held;
+		if (pressed && !quit)
+		{
+			lastPress_ms=getClock_ms();
+			ev=(UiEvent_t){ .type=UI_EV_BUTTON, .buttons=pressed, .held=held };
+			sendEvent(&ev);
+		}
+
+		now=getClock_ms();
+		if (!quit && depth>0 && stack[depth-1].nextTick<=now)
+		{
+			level=depth-1;
+			f=&stack[level];
+			screen=f->screen;
+			f->nextTick=UI_NO_TICK;
+			next=screen->tick(f->ctx, now);
+
+			// Unless it opened or closed a screen while it was at it
+			if (depth-1==level && stack[level].screen==screen && stack[level].nextTick==UI_NO_TICK)
+				stack[level].nextTick=next;
+		}
+
+		usleep(UI_POLL_MS*1000);
+	}
+
+	while (depth>0)
+		closeTop();
+}
@@ -0,0 +1,130 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  ui.h
+*
+*  Synopsis:	Header file for ui.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*  10/19/26  | John Gedde   |  uiTop(), uiIdle_ms() and node status changes
+*  10/19/26  | John Gedde   |  UI_DATA_FETCH, UI_DATA_WIFI
+*  10/19/26  | John Gedde   |  UI_DATA_TEMP
+*
+****************************************************************************/
+
+#ifndef _UI
+#define _UI
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lcdfunc.h"
+
+#define UI_MAX_DEPTH		8
+#define UI_POLL_MS			10			// button scan rate
+#define UI_NO_TICK			UINT64_MAX
+
+// Background data that changed.  Posted with uiNotify() from any thread.
+#define UI_DATA_CONF		0x01		// conf file reloaded
+#define UI_DATA_ASTERISK	0x02		// asterisk went down or came back
+#define UI_DATA_NODE		0x04		// selected local node changed
+#define UI_DATA_LINKS		0x08		// connected nodes changed
+#define UI_DATA_NET			0x10		// IP address changed
+#define UI_DATA_STATUS		0x20		// COS/PTT/TX timeout changed
+#define UI_DATA_SCRIPT		0x40		// script output or a script ended
+#define UI_DATA_FETCH		0x80		// a background fetch finished
+#define UI_DATA_WIFI		0x100		// wifi join went on a step
+#define UI_DATA_TEMP		0x200		// new CPU temperature reading
+
+typedef enum
+{
+	UI_EV_BUTTON=0,			// buttons: newly pressed, held: all down
+	UI_EV_RESULT,			// screen above us closed: from, result
+	UI_EV_DATA				// data: UI_DATA_XXX bits
+} UiEventType_t;
+
+typedef struct UiScreen_s UiScreen_t;
+
+typedef struct
+{
+	UiEventType_t type;
+	uint16_t buttons;
+	uint16_t held;
+	const UiScreen_t *from;
+	int32_t result;
+	uint32_t data;
+} UiEvent_t;
+
+// A screen.  Any handler can be NULL.  None of them may wait for anything -
+// do the work and return.  tick() returns when it wants to be called
+// next (ms, getClock_ms() time) or UI_NO_TICK.  Only the screen on top
+// of the stack gets events and ticks.
+struct UiScreen_s
+{
+	const char *name;
+	void 		(*enter)(void *ctx);
+	void 		(*event)(void *ctx, const UiEvent_t *ev);
+	uint64_t	(*tick)(void *ctx, uint64_t now);
+	void 		(*exit)(void *ctx);
+};
+
+void 		uiPush(const UiScreen_t *screen, void *ctx);
+void 		uiPop(int32_t result);
+void 		uiReplace(const UiScreen_t *screen, void *ctx);
+void 		uiTickAt(uint64_t when);
+void 		uiQuit();
+void 		uiNotify(uint32_t data);
+uint16_t 	uiHeld();
+const UiScreen_t *uiTop();
+uint64_t 	uiIdle_ms();
+void 		uiRun(void (*pollFn)());
+
+/*-----------------------------------------------------------------------------
+Function:
+	uiWrap
+Synopsis:
+	UP/DOWN through a list of count items, wrapping at the ends.  UP goes
+	to the next item.
+Author:
+	John Gedde
+Inputs:
+	uint16_t idx: current item
+	uint16_t count: number of items
+	uint16_t buttons: buttons pressed
+Outputs:
+	uint16_t: new item
+-----------------------------------------------------------------------------*/
+static inline uint16_t uiWrap(uint16_t idx, uint16_t count, uint16_t buttons)
+{
+	if (count==0)
+		return 0;
+	if (buttons & BTN_UP)
+		return (idx+1>=count) ? 0 : idx+1;
+	if (buttons & BTN_DOWN)
+		return (idx==0) ? count-1 : idx-1;
+	return idx;
+}
+
+#endif
@@ -0,0 +1,459 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  wpactrl.c
+*
+*  Synopsis:	Joins a wifi network by talking to wpa_supplicant's control
+*				socket (the same thing wpa_cli does) instead of adding to
+*				its conf file and rebooting.  The network is added and
+*				selected, then the event socket is watched for it to
+*				connect.  Only once it has is it saved with SAVE_CONFIG;
+*				a wrong password is taken back out so it isn't tried
+*				again after a reboot.
+*
+*				One join at a time runs on its own thread.  The caller's
+*				change function is told whenever the state changes.
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "wpactrl.h"
+#include "main.h"
+#include "clockfunc.h"
+
+#define WPA_SSID_LEN		32
+#define WPA_PSK_LEN			64
+#define WPA_REPLY_LEN		512
+
+typedef struct
+{
+	char ctrlPath[108];				// sun_path size
+	char ssid[WPA_SSID_LEN+1];
+	char psk[WPA_PSK_LEN];
+	uint32_t timeout_ms;
+	void (*changeFn)();
+} WpaJob_t;
+
+// A socket to wpa_supplicant and the local name it's bound to
+typedef struct
+{
+	int fd;
+	char localPath[108];
+} WpaSock_t;
+
+static WpaJob_t job;
+static WpaStatus_t status={ WPA_IDLE, 0, FALSE };
+static uint64_t jobStart;
+static pthread_mutex_t wpaLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_t wpaThread;
+static bool running=FALSE;				// wpaThread needs joining
+static bool wpaKill=FALSE;
+
+/*-----------------------------------------------------------------------------
+Function:
+	setState
+Synopsis:
+	Updates the join state where the screens can see it, and says so
+Author:
+	John Gedde
+Inputs:
+	WpaState_t state: new state
+	bool saved: SAVE_CONFIG worked
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+static void setState(WpaState_t state, bool saved)
+{
+	pthread_mutex_lock(&wpaLock);
+	status.state=state;
+	status.saved=saved;
+	status.elapsed_ms=getClock_ms()-jobStart;
+	pthread_mutex_unlock(&wpaLock);
+
+	if (job.changeFn)
+		job.changeFn();
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaOpen / wpaClose
+Synopsis:
+	Opens a datagram socket to a wpa_supplicant control socket.  Ours
+	has to have a name of its own for the answers to come back to.
+Author:
+	John Gedde
+Inputs:
+	WpaSock_t *pSock: the socket
+	const char *ctrlPath: /var/run/wpa_supplicant/wlan0
+	int n: makes the local name different for each socket
+Outputs:
+	bool: TRUE if wpa_supplicant is there
+-----------------------------------------------------------------------------*/
+static bool wpaOpen(WpaSock_t *pSock, const char *ctrlPath, int n)
+{
+	struct sockaddr_un sa;
+
+	pSock->fd=socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (pSock->fd<0)
+		return FALSE;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family=AF_UNIX;
+	snprintf(pSock->localPath, sizeof(pSock->localPath), WPA_LOCAL_BASE "%d-%d", (int)getpid(), n);
+	strcpy(sa.sun_path, pSock->localPath);
+	unlink(pSock->localPath);
+	if (bind(pSock->fd, (struct sockaddr *)&sa, sizeof(sa))<0)
+	{
+		close(pSock->fd);
+		pSock->fd=-1;
+		return FALSE;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family=AF_UNIX;
+	snprintf(sa.sun_path, sizeof(sa.sun_path), "%s", ctrlPath);
+	if (connect(pSock->fd, (struct sockaddr *)&sa, sizeof(sa))<0)
+	{
+		close(pSock->fd);
+		pSock->fd=-1;
+		unlink(pSock->localPath);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void wpaClose(WpaSock_t *pSock)
+{
+	if (pSock->fd<0)
+		return;
+	close(pSock->fd);
+	pSock->fd=-1;
+	unlink(pSock->localPath);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaCmd
+Synopsis:
+	Sends a command and waits for its answer.  Events ("<3>CTRL-...")
+	that turn up in between are skipped.
+Author:
+	John Gedde
+Inputs:
+	WpaSock_t *pSock: the socket
+	const char *cmd: the command
+	char *reply: where to put the answer, trailing newline removed
+Outputs:
+	bool: FALSE if there was no answer
+-----------------------------------------------------------------------------*/
+static bool wpaCmd(WpaSock_t *pSock, const char *cmd, char *reply)
+{
+	struct pollfd pfd={ pSock->fd, POLLIN, 0 };
+	uint64_t deadline=getClock_ms()+WPA_REPLY_MS, now;
+	ssize_t len;
+
+	if (send(pSock->fd, cmd, strlen(cmd), 0)<0)
+		return FALSE;
+
+	while ((now=getClock_ms())<deadline)
+	{
+		if (poll(&pfd, 1, (int)(deadline-now))<=0)
+			continue;
+		if ((len=recv(pSock->fd, reply, WPA_REPLY_LEN-1, MSG_DONTWAIT))<=0)
+			continue;
+
+		reply[len]='\0';
+		if (reply[0]=='<')
+			continue;
+		while (len && (reply[len-1]=='\n' || reply[len-1]=='\r'))
+			reply[--len]='\0';
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaCmdOk
+Synopsis:
+	Sends a command that answers OK
+Author:
+	John Gedde
+Inputs:
+	WpaSock_t *pSock: the socket
+	const char *cmd: the command
+Outputs:
+	bool: TRUE if it said OK
+-----------------------------------------------------------------------------*/
+static bool wpaCmdOk(WpaSock_t *pSock, const char *cmd)
+{
+	char reply[WPA_REPLY_LEN];
+
+	if (!wpaCmd(pSock, cmd, reply))
+		return FALSE;
+	if (strcmp(reply, "OK")!=0)
+	{
+		// Just the command word - don't log the password
+		fprintf(stderr, "aslLCD Error: wpa_supplicant said %s to %.*s\n", reply, (int)strcspn(cmd, " "), cmd);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaWaitConnect
+Synopsis:
+	Watches the event socket for network id to connect or be turned down
+	for a wrong password
+Author:
+	John Gedde
+Inputs:
+	WpaSock_t *pEv: attached event socket
+	int id: the network
+Outputs:
+	WpaState_t: WPA_CONNECTED, WPA_WRONG_KEY or WPA_TIMEOUT
+-----------------------------------------------------------------------------*/
+static WpaState_t wpaWaitConnect(WpaSock_t *pEv, int id)
+{
+	struct pollfd pfd={ pEv->fd, POLLIN, 0 };
+	uint64_t deadline=jobStart+job.timeout_ms, now;
+	char ev[WPA_REPLY_LEN];
+	char idStr[16];
+	ssize_t len;
+
+	while ((now=getClock_ms())<deadline && !__atomic_load_n(&wpaKill, __ATOMIC_RELAXED))
+	{
+		// Wake now and then to check for kill
+		if (poll(&pfd, 1, (deadline-now<500) ? (int)(deadline-now) : 500)<=0)
+			continue;
+		if ((len=recv(pEv->fd, ev, sizeof(ev)-1, MSG_DONTWAIT))<=0)
+			continue;
+		ev[len]='\0';
+
+		// <3>CTRL-EVENT-CONNECTED - Connection to 00:11:22:33:44:55 completed [id=1 id_str=]
+		snprintf(idStr, sizeof(idStr), "[id=%d ", id);
+		if (strstr(ev, "CTRL-EVENT-CONNECTED") && strstr(ev, idStr))
+			return WPA_CONNECTED;
+
+		// <3>CTRL-EVENT-SSID-TEMP-DISABLED id=1 ssid="x" auth_failures=1 duration=10 reason=WRONG_KEY
+		snprintf(idStr, sizeof(idStr), " id=%d ", id);
+		if (strstr(ev, "CTRL-EVENT-SSID-TEMP-DISABLED") && strstr(ev, idStr) && strstr(ev, "reason=WRONG_KEY"))
+			return WPA_WRONG_KEY;
+	}
+	return WPA_TIMEOUT;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaThreadFn
+Synopsis:
+	Does a join: ADD_NETWORK, SET_NETWORK ssid/psk, ENABLE_NETWORK,
+	SELECT_NETWORK, then waits for it.  SELECT_NETWORK turns the other
+	networks off, so they're all turned back on afterwards either way
+	(if the new one didn't work wpa_supplicant goes back to the old one.)
+	The ssid is sent in hex so quotes in it can't confuse anything.
+Author:
+	John Gedde
+Inputs:
+	void *p: arguments
+Outputs:
+	return val to caller
+-----------------------------------------------------------------------------*/
+static void *wpaThreadFn(void *p)
+{
+	WpaSock_t cmd, ev;
+	char buf[WPA_REPLY_LEN];
+	char hex[WPA_SSID_LEN*2+1];
+	WpaState_t state;
+	bool saved=FALSE;
+	int id;
+
+	if (!wpaOpen(&cmd, job.ctrlPath, 0))
+	{
+		fprintf(stderr, "aslLCD Error: Can't talk to wpa_supplicant on %s\n", job.ctrlPath);
+		setState(WPA_NO_CTRL, FALSE);
+		return p;
+	}
+	if (!wpaOpen(&ev, job.ctrlPath, 1) || !wpaCmdOk(&ev, "ATTACH"))
+	{
+		wpaClose(&ev);
+		wpaClose(&cmd);
+		setState(WPA_NO_CTRL, FALSE);
+		return p;
+	}
+
+	if (!wpaCmd(&cmd, "ADD_NETWORK", buf) || sscanf(buf, "%d", &id)!=1)
+	{
+		wpaClose(&ev);
+		wpaClose(&cmd);
+		setState(WPA_FAILED, FALSE);
+		return p;
+	}
+
+	for (int i=0; job.ssid[i]; ++i)
+		sprintf(hex+i*2, "%02x", (unsigned char)job.ssid[i]);
+
+	snprintf(buf, sizeof(buf), "SET_NETWORK %d ssid %s", id, hex);
+	state=wpaCmdOk(&cmd, buf) ? WPA_JOINING : WPA_FAILED;
+	snprintf(buf, sizeof(buf), "SET_NETWORK %d psk \"%s\"", id, job.psk);
+	if (state==WPA_JOINING && !wpaCmdOk(&cmd, buf))
+		state=WPA_WRONG_KEY;		// not 8-63 chars
+	snprintf(buf, sizeof(buf), "ENABLE_NETWORK %d", id);
+	if (state==WPA_JOINING && !wpaCmdOk(&cmd, buf))
+		state=WPA_FAILED;
+	snprintf(buf, sizeof(buf), "SELECT_NETWORK %d", id);
+	if (state==WPA_JOINING && !wpaCmdOk(&cmd, buf))
+		state=WPA_FAILED;
+
+	if (state==WPA_JOINING)
+		state=wpaWaitConnect(&ev, id);
+
+	if (state!=WPA_CONNECTED)
+	{
+		snprintf(buf, sizeof(buf), "REMOVE_NETWORK %d", id);
+		wpaCmdOk(&cmd, buf);
+	}
+	wpaCmdOk(&cmd, "ENABLE_NETWORK all");
+	if (state==WPA_CONNECTED)
+		saved=wpaCmdOk(&cmd, "SAVE_CONFIG");
+
+	wpaCmdOk(&ev, "DETACH");
+	wpaClose(&ev);
+	wpaClose(&cmd);
+	setState(state, saved);
+	return p;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaJoin
+Synopsis:
+	Starts joining a network in the background.  Follow it with
+	wpaStatus().
+Author:
+	John Gedde
+Inputs:
+	const char *ctrlPath: wpa_supplicant control socket
+	const char *ssid: network name
+	const char *psk: password, 8-63 chars
+	uint32_t timeout_ms: give up if it hasn't connected in this long
+	void (*changeFn)(): called from the join thread when the state
+						changes, can be NULL
+Outputs:
+	bool: FALSE if a join is already going
+-----------------------------------------------------------------------------*/
+bool wpaJoin(const char *ctrlPath, const char *ssid, const char *psk, uint32_t timeout_ms, void (*changeFn)())
+{
+	WpaStatus_t st;
+
+	wpaStatus(&st);
+	if (st.state==WPA_JOINING)
+		return FALSE;
+	if (running)
+	{
+		pthread_join(wpaThread, NULL);
+		running=FALSE;
+	}
+
+	memset(&job, 0, sizeof(job));
+	snprintf(job.ctrlPath, sizeof(job.ctrlPath), "%s", ctrlPath);
+	snprintf(job.ssid, sizeof(job.ssid), "%s", ssid);
+	snprintf(job.psk, sizeof(job.psk), "%s", psk);
+	job.timeout_ms=timeout_ms;
+	job.changeFn=changeFn;
+
+	jobStart=getClock_ms();
+	pthread_mutex_lock(&wpaLock);
+	status.state=WPA_JOINING;
+	status.saved=FALSE;
+	status.elapsed_ms=0;
+	pthread_mutex_unlock(&wpaLock);
+
+	__atomic_store_n(&wpaKill, FALSE, __ATOMIC_RELAXED);
+	if (pthread_create(&wpaThread, NULL, wpaThreadFn, NULL)!=0)
+	{
+		fprintf(stderr, "aslLCD Error: Could not create wifi join thread\n");
+		setState(WPA_FAILED, FALSE);
+		return TRUE;
+	}
+	running=TRUE;
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaStatus
+Synopsis:
+	Where the last join is up to
+Author:
+	John Gedde
+Inputs:
+	WpaStatus_t *pStatus: where to put it
+Outputs:
+	WpaStatus_t *pStatus: state, time so far (or taken), saved
+-----------------------------------------------------------------------------*/
+void wpaStatus(WpaStatus_t *pStatus)
+{
+	pthread_mutex_lock(&wpaLock);
+	*pStatus=status;
+	if (status.state==WPA_JOINING)
+		pStatus->elapsed_ms=getClock_ms()-jobStart;
+	pthread_mutex_unlock(&wpaLock);
+}
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaStop
+Synopsis:
+	Stops waiting for a join and waits for the thread to tidy up
+Author:
+	John Gedde
+Inputs:
+	None
+Outputs:
+	None
+-----------------------------------------------------------------------------*/
+void wpaStop()
+{
+	if (!running)
+		return;
+
+	__atomic_store_n(&wpaKill, TRUE, __ATOMIC_RELAXED);
+	pthread_join(wpaThread, NULL);
+	running=FALSE;
+}
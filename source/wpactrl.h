@@ -0,0 +1,82 @@
+/****************************************************************************
+*  Copyright (c)2023 John Gedde (Amateur radio callsign AD2DK)
+*
+*	aslLCD is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU Lesser General Public License as
+*	published by the Free Software Foundation, either version 3 of the
+*	License, or (at your option) any later version.
+*
+*	aslLCD is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU Lesser General Public License for more details.
+*
+*	You should have received a copy of the GNU Lesser General Public
+*	License along with wiringPi.
+*	If not, see <http://www.gnu.org/licenses/>.
+*
+*	This file is part of aslLCD:
+*	https://github.com/ IT AIN'T THERE YET
+*
+*  wpactrl.h
+*
+*  Synopsis:	Header file for wpactrl.c
+*
+*  Project:	Allstar Link LCD
+*
+*  File Version History:
+*    Date    |      Eng     |               Description
+*  ----------+--------------+------------------------------------------------
+*  10/19/26  | John Gedde   |  Original Version
+*
+****************************************************************************/
+
+#ifndef _WPACTRL
+#define _WPACTRL
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WPA_REPLY_MS		2000		// longest wpa_supplicant takes to answer
+#define WPA_LOCAL_BASE		"/tmp/aslLCD-wpa-"
+
+typedef enum
+{
+	WPA_IDLE=0,
+	WPA_JOINING,					// network added, waiting to connect
+	WPA_CONNECTED,					// connected (and saved, if saved is set)
+	WPA_WRONG_KEY,
+	WPA_FAILED,						// wpa_supplicant said no
+	WPA_TIMEOUT,
+	WPA_NO_CTRL						// no control socket - do it the old way
+} WpaState_t;
+
+typedef struct
+{
+	WpaState_t state;
+	uint32_t elapsed_ms;
+	bool saved;						// SAVE_CONFIG worked
+} WpaStatus_t;
+
+bool 	wpaJoin(const char *ctrlPath, const char *ssid, const char *psk, uint32_t timeout_ms, void (*changeFn)());
+void 	wpaStatus(WpaStatus_t *pStatus);
+void 	wpaStop();
+
+/*-----------------------------------------------------------------------------
+Function:
+	wpaFinished
+Synopsis:
+	Whether a join is over, one way or the other
+Author:
+	John Gedde
+Inputs:
+	WpaState_t state: from wpaStatus()
+Outputs:
+	bool: TRUE if it's over
+-----------------------------------------------------------------------------*/
+static inline bool wpaFinished(WpaState_t state)
+{
+	return state!=WPA_IDLE && state!=WPA_JOINING;
+}
+
+#endif